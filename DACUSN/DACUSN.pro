@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui opengl serialport
+QT       += core gui opengl serialport network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -31,7 +31,22 @@ SOURCES += main.cpp\
     uwbpacketclass.cpp \
     rs232.c \
     mttsettingsdialog.cpp \
-    mtt_pure.cpp
+    mtt_pure.cpp \
+    targetcapacity.cpp \
+    mttsnapshot.cpp \
+    batchlocalization.cpp \
+    spatialfusion.cpp \
+    radarclock.cpp \
+    recordpool.cpp \
+    radarhistory.cpp \
+    framebuffer.cpp \
+    radarsnapshot.cpp \
+    backupwriter.cpp \
+    backupreader.cpp \
+    backupcodec.cpp \
+    ringwriter.cpp \
+    measurementcapture.cpp \
+    replaysource.cpp
 
 HEADERS  += mainwindow.h \
     reciever.h \
@@ -53,7 +68,23 @@ HEADERS  += mainwindow.h \
     rs232.h \
     uwbpacketclass.h \
     mttsettingsdialog.h \
-    mtt_pure.h
+    mtt_pure.h \
+    targetcapacity.h \
+    mttstorage.h \
+    mttsnapshot.h \
+    batchlocalization.h \
+    spatialfusion.h \
+    radarclock.h \
+    recordpool.h \
+    radarhistory.h \
+    framebuffer.h \
+    radarsnapshot.h \
+    backupwriter.h \
+    backupreader.h \
+    backupcodec.h \
+    ringwriter.h \
+    measurementcapture.h \
+    replaysource.h
 
 FORMS    += mainwindow.ui \
     datainputdialog.ui \
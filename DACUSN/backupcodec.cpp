@@ -0,0 +1,390 @@
+/**
+ * @file backupcodec.cpp
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Definitions of backupEncoder and backupDecoder class methods.
+ *
+ * @section DESCRIPTION
+ *
+ * Encoder and decoder must keep exactly the same prediction state, so any change of prediction
+ * must be done in both of them.
+ *
+ */
+
+#include "backupcodec.h"
+
+static quint32 checksumTable[256]; ///< CRC-32 table for each byte value
+
+/**
+ * @brief Fills CRC-32 table, called once during static initialization before any thread is started.
+ * @return Always true.
+ */
+static bool initChecksumTable(void)
+{
+    for(quint32 i=0; i<256; i++)
+    {
+        quint32 c = i;
+        for(int k=0; k<8; k++) c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+        checksumTable[i] = c;
+    }
+    return true;
+}
+
+static bool checksumTableReady = initChecksumTable();
+
+quint32 backupChecksum(const uchar *data, int size, quint32 previous)
+{
+    Q_UNUSED(checksumTableReady);
+
+    quint32 c = ~previous;
+    for(int i=0; i<size; i++) c = checksumTable[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+
+    return ~c;
+}
+
+/**
+ * @brief Maps signed value to unsigned, so values of small magnitude have small codes (0, -1, 1, -2 ... to 0, 1, 2, 3 ...).
+ */
+static inline quint64 zigzag(qint64 value) { return ((quint64)(value) << 1) ^ (quint64)(value >> 63); }
+
+/**
+ * @brief Inverse of 'zigzag'.
+ */
+static inline qint64 unzigzag(quint64 code) { return (qint64)(code >> 1) ^ -(qint64)(code & 1); }
+
+/**
+ * @brief Returns bit pattern of float.
+ */
+static inline quint32 floatBits(float value) { quint32 bits; memcpy(&bits, &value, sizeof(float)); return bits; }
+
+/**
+ * @brief Returns float with given bit pattern.
+ */
+static inline float bitsFloat(quint32 bits) { float value; memcpy(&value, &bits, sizeof(float)); return value; }
+
+/**
+ * @brief Maps float to integer of the same order, -0.0 and 0.0 are kept different (-1 and 0).
+ */
+static inline qint64 orderedBits(float value)
+{
+    quint32 bits = floatBits(value);
+    return (bits & 0x80000000u) ? -(qint64)(bits & 0x7FFFFFFFu)-1 : (qint64)(bits);
+}
+
+/**
+ * @brief Inverse of 'orderedBits', value must be in range of qint32.
+ */
+static inline float orderedFloat(qint64 ordered)
+{
+    return bitsFloat((ordered<0) ? (0x80000000u | (quint32)(-(ordered+1))) : (quint32)(ordered));
+}
+
+/**
+ * @brief Rounds coordinate to integer multiple of resolution.
+ * @return False if coordinate is not finite or its quantized value reaches BACKUP_QUANTIZED_LIMIT.
+ */
+static inline bool quantize(float value, double resolution, qint64 * quantized)
+{
+    double scaled = value/resolution;
+    if(!(scaled>-BACKUP_QUANTIZED_LIMIT && scaled<BACKUP_QUANTIZED_LIMIT)) return false; // NaN fails too
+
+    *quantized = (qint64)(floor(scaled+0.5));
+    return true;
+}
+
+/**
+ * @brief Inverse of 'quantize'.
+ */
+static inline float dequantize(qint64 quantized, double resolution) { return (float)(quantized*resolution); }
+
+/**
+ * @brief Computes prediction of coordinates from target of the previous frame, used by both encoder and decoder.
+ * @param[in] previous Target with the same identifier in the previous frame or NULL for new target (predicted by zero).
+ * @param[in] exact If true, prediction is in 'orderedBits' domain, otherwise it is quantized by 'resolution'.
+ */
+static void predict(const backup_track_record * previous, bool exact, double resolution, qint64 * x, qint64 * y)
+{
+    *x = 0;
+    *y = 0;
+    if(previous==NULL) return;
+
+    if(exact)
+    {
+        *x = orderedBits(previous->x);
+        *y = orderedBits(previous->y);
+    }
+    else
+    {
+        // coordinates stored exactly in the previous frame may not be representable
+        if(!quantize(previous->x, resolution, x)) *x = 0;
+        if(!quantize(previous->y, resolution, y)) *y = 0;
+    }
+}
+
+/**
+ * @brief Finds target with given identifier in previous frame. Targets usually keep their order, so search starts at 'hint'.
+ * @return Index of target or -1.
+ */
+static int findTrack(const backup_track_record * tracks, int count, qint32 id, int hint)
+{
+    for(int k=0; k<count; k++)
+    {
+        int i = (hint+k) % count;
+        if(tracks[i].id==id) return i;
+    }
+    return -1;
+}
+
+backupEncoder::backupEncoder(quint32 coordinate_quantum)
+{
+    quantum = coordinate_quantum;
+    size = 0;
+    reset();
+}
+
+void backupEncoder::reset()
+{
+    memset(&header, 0, sizeof(backup_block_header));
+    header.sync = BACKUP_BLOCK_SYNC;
+    header.quantum = quantum;
+
+    size = sizeof(backup_block_header);
+    if(buffer.size()<size) buffer.resize(size);
+
+    lastTimestamp = 0;
+    lastStep = 0;
+    lastTracks.clear();
+}
+
+void backupEncoder::append(const backup_frame_header *frame, const backup_track_record *tracks)
+{
+    // the worst case is checked in advance, so values are written without further checks
+    int worst = (2+3*frame->count)*BACKUP_VARINT_MAX_SIZE + 8;
+    if(buffer.size()<size+worst) buffer.resize(2*(size+worst));
+
+    if(header.frames==0)
+    {
+        header.timestamp = frame->timestamp;
+        lastTimestamp = frame->timestamp;
+    }
+
+    qint64 step = frame->timestamp-lastTimestamp;
+    putVarint(zigzag(step-lastStep));
+    lastStep = step;
+    lastTimestamp = frame->timestamp;
+
+    putVarint(frame->count);
+
+    double resolution = quantum*1e-6;
+    currentTracks.resize(frame->count);
+
+    qint32 lastId = 0;
+    for(int j=0; j<frame->count; j++)
+    {
+        backup_track_record * track = &currentTracks[j];
+        track->id = tracks[j].id;
+
+        qint64 x, y;
+        bool exact = quantum==0 || !quantize(tracks[j].x, resolution, &x) || !quantize(tracks[j].y, resolution, &y);
+
+        // in fixed-point mode the lowest bit of identifier code marks target with exact coordinates
+        quint64 idCode = zigzag((qint64)(tracks[j].id)-lastId);
+        if(quantum!=0) idCode = (idCode << 1) | (exact ? 1 : 0);
+        putVarint(idCode);
+        lastId = tracks[j].id;
+
+        qint64 predictionX, predictionY;
+        int previous = findTrack(lastTracks.constData(), lastTracks.count(), tracks[j].id, j);
+        predict((previous>=0) ? &lastTracks[previous] : NULL, exact, resolution, &predictionX, &predictionY);
+
+        if(exact)
+        {
+            x = orderedBits(tracks[j].x);
+            y = orderedBits(tracks[j].y);
+            track->x = tracks[j].x;
+            track->y = tracks[j].y;
+        }
+        else
+        {
+            // prediction of the next frame must start from what decoder gets
+            track->x = dequantize(x, resolution);
+            track->y = dequantize(y, resolution);
+        }
+
+        putVarint(zigzag(x-predictionX));
+        putVarint(zigzag(y-predictionY));
+    }
+
+    lastTracks.resize(frame->count);
+    if(frame->count>0) memcpy(lastTracks.data(), currentTracks.constData(), frame->count*sizeof(backup_track_record));
+
+    header.frames++;
+    header.raw_size += BACKUP_FRAME_SIZE(frame->count);
+}
+
+const char *backupEncoder::finishBlock()
+{
+    header.size = size-sizeof(backup_block_header);
+
+    // padding is not part of checksum
+    int padded = getBlockSize();
+    if(buffer.size()<padded) buffer.resize(padded);
+    memset(buffer.data()+size, 0, padded-size);
+
+    header.checksum = 0;
+    memcpy(buffer.data(), &header, sizeof(backup_block_header));
+    header.checksum = backupChecksum(buffer.constData(), size);
+    memcpy(buffer.data(), &header, sizeof(backup_block_header));
+
+    return (const char *)(buffer.constData());
+}
+
+void backupEncoder::putVarint(quint64 value)
+{
+    uchar * data = buffer.data();
+
+    while(value>=0x80)
+    {
+        data[size++] = (uchar)(value | 0x80);
+        value >>= 7;
+    }
+    data[size++] = (uchar)(value);
+}
+
+backupDecoder::backupDecoder()
+{
+    framesSize = 0;
+}
+
+qint64 backupDecoder::blockSize(const uchar *block, qint64 available, bool check_payload)
+{
+    if(available<(qint64)(sizeof(backup_block_header))) return 0;
+
+    backup_block_header header;
+    memcpy(&header, block, sizeof(backup_block_header));
+
+    qint64 padded = sizeof(backup_block_header) + ((header.size+7) & ~7u);
+    if(header.sync!=BACKUP_BLOCK_SYNC || padded>available) return 0;
+
+    if(check_payload)
+    {
+        quint32 checksum = header.checksum;
+        header.checksum = 0;
+        if(backupChecksum(block+sizeof(backup_block_header), header.size, backupChecksum((const uchar *)(&header), sizeof(backup_block_header)))!=checksum) return 0;
+    }
+
+    return padded;
+}
+
+bool backupDecoder::decode(const uchar *block, qint64 available)
+{
+    framesSize = 0;
+
+    if(blockSize(block, available, true)==0) return false;
+
+    backup_block_header header;
+    memcpy(&header, block, sizeof(backup_block_header));
+
+    const uchar * data = block+sizeof(backup_block_header);
+    const uchar * end = data+header.size;
+
+    frames.resize((header.raw_size+7)/8);
+    char * output = (char *)(frames.data());
+    char * outputEnd = output+header.raw_size;
+
+    qint64 lastTimestamp = header.timestamp;
+    qint64 lastStep = 0;
+    const backup_track_record * lastTracks = NULL;
+    int lastCount = 0;
+    double resolution = header.quantum*1e-6;
+
+    for(quint32 i=0; i<header.frames; i++)
+    {
+        quint64 code;
+
+        if(!getVarint(&data, end, &code)) return false;
+        lastStep += unzigzag(code);
+        lastTimestamp += lastStep;
+
+        if(!getVarint(&data, end, &code) || code>(quint64)(outputEnd-output)) return false;
+        int count = (int)(code);
+        if((qint64)(BACKUP_FRAME_SIZE(count))>outputEnd-output) return false;
+
+        backup_frame_header * frame = (backup_frame_header *)(output);
+        backup_track_record * tracks = (backup_track_record *)(frame+1);
+        frame->sync = BACKUP_FRAME_SYNC;
+        frame->count = count;
+        frame->timestamp = lastTimestamp;
+
+        qint32 lastId = 0;
+        for(int j=0; j<count; j++)
+        {
+            if(!getVarint(&data, end, &code)) return false;
+            bool exact = true;
+            if(header.quantum!=0)
+            {
+                exact = code & 1;
+                code >>= 1;
+            }
+            tracks[j].id = (qint32)(lastId+unzigzag(code));
+            lastId = tracks[j].id;
+
+            // the same prediction as in encoder
+            qint64 x, y;
+            int previous = findTrack(lastTracks, lastCount, tracks[j].id, j);
+            predict((previous>=0) ? &lastTracks[previous] : NULL, exact, resolution, &x, &y);
+
+            if(!getVarint(&data, end, &code)) return false;
+            x = (qint64)((quint64)(x)+(quint64)(unzigzag(code)));
+            if(!getVarint(&data, end, &code)) return false;
+            y = (qint64)((quint64)(y)+(quint64)(unzigzag(code)));
+
+            if(exact)
+            {
+                if(x<INT_MIN || x>INT_MAX || y<INT_MIN || y>INT_MAX) return false;
+                tracks[j].x = orderedFloat(x);
+                tracks[j].y = orderedFloat(y);
+            }
+            else
+            {
+                tracks[j].x = dequantize(x, resolution);
+                tracks[j].y = dequantize(y, resolution);
+            }
+        }
+
+        // padding is zeroed, so decoded frames are byte identical with uncompressed ones
+        size_t records = sizeof(backup_frame_header)+count*sizeof(backup_track_record);
+        memset(output+records, 0, BACKUP_FRAME_SIZE(count)-records);
+
+        lastTracks = tracks;
+        lastCount = count;
+        output += BACKUP_FRAME_SIZE(count);
+    }
+
+    if(data!=end || output!=outputEnd) return false;
+
+    framesSize = header.raw_size;
+    return true;
+}
+
+bool backupDecoder::getVarint(const uchar **data, const uchar *end, quint64 *value)
+{
+    const uchar * p = *data;
+    quint64 result = 0;
+    int shift = 0;
+
+    while(p<end && shift<64)
+    {
+        uchar byte = *p++;
+        result |= (quint64)(byte & 0x7F) << shift;
+        if(!(byte & 0x80))
+        {
+            *data = p;
+            *value = result;
+            return true;
+        }
+        shift += 7;
+    }
+
+    return false;
+}
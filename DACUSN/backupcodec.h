@@ -0,0 +1,187 @@
+/**
+ * @file backupcodec.h
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Compression of binary backup frames into independently decodable blocks.
+ *
+ * @section DESCRIPTION
+ *
+ * Positions of the same target change only a little between frames and timestamps increase regularly,
+ * so most of the raw frame bytes are redundant. Encoder stores each value as difference from its prediction
+ * written as zig-zag varint (small positive and negative differences take one or two bytes):
+ *
+ * - timestamp is predicted by the previous timestamp plus the previous time step,
+ * - count of targets is stored directly,
+ * - identifier is predicted by identifier of the previous target in the same frame,
+ * - coordinates are predicted by coordinates of the target with the same identifier in the previous frame.
+ *
+ * Coordinates are stored in one of two ways, the block header tells which one is used:
+ *
+ * - fixed-point (quantum is not zero): coordinates are rounded to integer multiples of quantum (0.1 mm by
+ *   default, far below precision of radars) and differences of these integers are stored. A target moving
+ *   by centimetres takes two or three bytes per coordinate wherever it is. Decoded coordinates differ from
+ *   the original ones by at most half of quantum, so this mode is lossy. Coordinates, which cannot be
+ *   represented (not finite or too far), are stored losslessly as below and target is marked by the lowest
+ *   bit of its identifier code.
+ * - lossless (quantum is zero): 32 bit patterns of coordinates are mapped to integers ordered the same way
+ *   as floats (negative values below positive ones), so a small move across zero is a small difference.
+ *   Decoded floats are identical to the last bit, but the resolution of float grows near zero, so
+ *   differences are larger than in fixed-point mode.
+ *
+ * Prediction is restarted at the beginning of each block, so block can be decoded without any previous
+ * data and seeking needs to decode only one block. Each block starts with 'backup_block_header' containing
+ * CRC-32 of the whole block and is padded to multiple of 8 bytes. Decoder produces frames in the same layout
+ * as they are stored in uncompressed backup, so 'backupReader' handles both formats the same way.
+ *
+ */
+
+#ifndef BACKUPCODEC_H
+#define BACKUPCODEC_H
+
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <QtGlobal>
+#include <QVector>
+
+#include "backupwriter.h"
+
+#define BACKUP_BLOCK_SYNC       (0x4B434C42)    ///< "BLCK" identifier at the beginning of each compressed block
+#define BACKUP_VARINT_MAX_SIZE  (10)            ///< Maximum number of bytes of one 64 bit varint
+#define BACKUP_DEFAULT_QUANTUM  (100)           ///< Default resolution of fixed-point coordinates in micrometers
+#define BACKUP_QUANTIZED_LIMIT  (1099511627776.0) ///< 2^40, coordinates not smaller in quanta are stored losslessly
+
+/**
+ * @brief Header of compressed block.
+ */
+struct backup_block_header {
+    quint32 sync; ///< Must be equal to BACKUP_BLOCK_SYNC
+    quint32 frames; ///< Number of frames encoded in block
+    quint32 size; ///< Size of payload in bytes (without padding)
+    quint32 checksum; ///< CRC-32 of header (with zero checksum) and payload
+    qint64 timestamp; ///< Timestamp of the first frame in block
+    quint32 raw_size; ///< Size of decoded frames in bytes
+    quint32 quantum; ///< Resolution of fixed-point coordinates in micrometers, zero if coordinates are lossless
+};
+
+/**
+ * @brief Computes CRC-32 (IEEE 802.3 polynomial).
+ * @param[in] data Data to check.
+ * @param[in] size Size of data in bytes.
+ * @param[in] previous Checksum of preceding data if checksum is computed by parts.
+ * @return Checksum.
+ */
+quint32 backupChecksum(const uchar * data, int size, quint32 previous = 0);
+
+class backupEncoder
+{
+public:
+    /**
+     * @brief Prepares encoder of the first block.
+     * @param[in] coordinate_quantum Resolution of coordinates in micrometers, zero for lossless coordinates.
+     */
+    backupEncoder(quint32 coordinate_quantum = 0);
+
+    /**
+     * @brief Encodes one frame into the current block.
+     * @param[in] frame Header of frame.
+     * @param[in] tracks Array of 'frame->count' records.
+     */
+    void append(const backup_frame_header * frame, const backup_track_record * tracks);
+
+    /**
+     * @brief Returns the number of frames in the current block.
+     * @return Number of frames.
+     */
+    int getFramesCount(void) { return (int)(header.frames); }
+
+    /**
+     * @brief Returns timestamp of the first frame in the current block.
+     * @return Milliseconds since epoch.
+     */
+    qint64 getTimestamp(void) { return header.timestamp; }
+
+    /**
+     * @brief Finishes the current block, which can be written into file.
+     * @return Pointer to block starting with 'backup_block_header', valid until the next call of 'append' or 'reset'.
+     */
+    const char * finishBlock(void);
+
+    /**
+     * @brief Returns the size of finished block including padding.
+     * @return Size in bytes.
+     */
+    int getBlockSize(void) { return (int)(sizeof(backup_block_header) + ((header.size+7) & ~7u)); }
+
+    /**
+     * @brief Starts a new empty block, prediction starts from scratch.
+     */
+    void reset(void);
+
+private:
+    backup_block_header header; ///< Header of the current block
+    QVector<uchar> buffer; ///< Header and payload of the current block
+    int size; ///< Used bytes in 'buffer'
+
+    qint64 lastTimestamp; ///< Timestamp of the previous frame
+    qint64 lastStep; ///< Time step between the two previous frames
+    QVector<backup_track_record> lastTracks; ///< Records of the previous frame as decoder will see them
+    QVector<backup_track_record> currentTracks; ///< Records of the current frame as decoder will see them
+    quint32 quantum; ///< Resolution of coordinates in micrometers, zero for lossless coordinates
+
+    /**
+     * @brief Appends unsigned varint to payload.
+     * @param[in] value Value to encode.
+     */
+    void putVarint(quint64 value);
+};
+
+class backupDecoder
+{
+public:
+    backupDecoder();
+
+    /**
+     * @brief Checks and decodes one block.
+     * @param[in] block Beginning of block (its header).
+     * @param[in] available Number of bytes available from 'block', block must not exceed it.
+     * @return False if block is incomplete, corrupted or its checksum does not match.
+     */
+    bool decode(const uchar * block, qint64 available);
+
+    /**
+     * @brief Returns decoded frames laid out the same way as in uncompressed backup.
+     * @return The first frame of the last decoded block, valid until the next decoding.
+     */
+    const backup_frame_header * getFrames(void) { return (const backup_frame_header *)(frames.constData()); }
+
+    /**
+     * @brief Returns the end of decoded frames.
+     * @return Pointer after the last decoded frame.
+     */
+    const char * getFramesEnd(void) { return (const char *)(frames.constData())+framesSize; }
+
+    /**
+     * @brief Checks header of block without decoding it.
+     * @param[in] block Beginning of block.
+     * @param[in] available Number of bytes available from 'block'.
+     * @param[in] check_payload If true, checksum of payload is verified too.
+     * @return Size of block including padding or zero if block is not valid.
+     */
+    static qint64 blockSize(const uchar * block, qint64 available, bool check_payload);
+
+private:
+    QVector<qint64> frames; ///< Decoded frames, 8 byte elements keep them aligned
+    int framesSize; ///< Size of decoded frames in bytes
+
+    /**
+     * @brief Reads unsigned varint from payload.
+     * @param[in,out] data Current position, moved behind the value.
+     * @param[in] end End of payload.
+     * @param[out] value Decoded value.
+     * @return False if varint is longer than 'end' allows.
+     */
+    static bool getVarint(const uchar ** data, const uchar * end, quint64 * value);
+};
+
+#endif // BACKUPCODEC_H
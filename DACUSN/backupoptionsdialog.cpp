@@ -7,8 +7,9 @@
  * @section DESCRIPTION (see backupoptionsdialog.h)
  *
  * The following dialog is using the uwbSettings based object to load all settings needed for backup
- * sequence to store data in text file on disk. Dialog provides graphical interface for setting up
- * paths and filename of target txt. Availible is also checkbox for allowing or disabling this functionality.
+ * sequence to store data in binary file on disk. Dialog provides graphical interface for setting up
+ * paths and filename of target file. Availible is also checkbox for allowing or disabling this functionality
+ * and button converting existing binary backup into text file.
  *
  */
 
@@ -32,10 +33,14 @@ backupOptionsDialog::backupOptionsDialog(uwbSettings *setts, QMutex *settings_mu
     ui->filenameLineEdit->setText(backupFileName);
     ui->backupFileLineEdit->setText(settings->getDiskBackupFilePath());
     ui->enableDataBackupCheckBox->setChecked(settings->getDiskBackupEnabled());
+    ui->compressDataBackupCheckBox->setChecked(settings->getDiskBackupCompressed());
+    ui->backupQuantumSpinBox->setValue(settings->getDiskBackupQuantum());
+    ui->captureMeasurementsCheckBox->setChecked(settings->getMeasurementCaptureEnabled());
 
     settingsMutex->unlock();
 
     connect(ui->changePathButton, SIGNAL(clicked()), this, SLOT(changeFilePathSlot()));
+    connect(ui->convertBackupButton, SIGNAL(clicked()), this, SLOT(convertBackupSlot()));
     connect(this, SIGNAL(accepted()), this, SLOT(acceptedSlot()));
 }
 
@@ -64,6 +69,9 @@ void backupOptionsDialog::acceptedSlot()
 
     settings->setDiskBackupFilePath(ui->backupFileLineEdit->text());
     settings->setDiskBackupEnabled(ui->enableDataBackupCheckBox->isChecked());
+    settings->setDiskBackupCompressed(ui->compressDataBackupCheckBox->isChecked());
+    settings->setDiskBackupQuantum(ui->backupQuantumSpinBox->value());
+    settings->setMeasurementCaptureEnabled(ui->captureMeasurementsCheckBox->isChecked());
 
     settingsMutex->unlock();
 
@@ -71,3 +79,20 @@ void backupOptionsDialog::acceptedSlot()
 
     emit acceptedSignal();
 }
+
+void backupOptionsDialog::convertBackupSlot()
+{
+    QString binaryPath = QFileDialog::getOpenFileName(this, tr("Select binary backup file"), ui->backupFileLineEdit->text(), tr("Binary backup (*.bin)"));
+
+    if(binaryPath.isEmpty()) return;
+
+    // text file is created next to binary one
+    QString textPath(binaryPath);
+    if(textPath.endsWith(".bin")) textPath.chop(4);
+    textPath.append(".txt");
+
+    int frames = backupReader::convertToText(binaryPath, textPath);
+
+    if(frames<0) QMessageBox::warning(this, tr("Conversion failed"), tr("The file is not valid binary backup or the text file could not be created."), QMessageBox::Ok);
+    else QMessageBox::information(this, tr("Conversion finished"), tr("%1 frames were written into %2.").arg(frames).arg(textPath), QMessageBox::Ok);
+}
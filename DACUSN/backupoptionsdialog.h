@@ -7,8 +7,9 @@
  * @section DESCRIPTION
  *
  * The following dialog is using the uwbSettings based object to load all settings needed for backup
- * sequence to store data in text file on disk. Dialog provides graphical interface for setting up
- * paths and filename of target txt. Availible is also checkbox for allowing or disabling this functionality.
+ * sequence to store data in binary file on disk. Dialog provides graphical interface for setting up
+ * paths and filename of target file. Availible is also checkbox for allowing or disabling this functionality
+ * and button converting existing binary backup into text file.
  */
 
 #ifndef BACKUPOPTIONSDIALOG_H
@@ -20,6 +21,7 @@
 #include <QMessageBox>
 
 #include "uwbsettings.h"
+#include "backupreader.h"
 
 
 namespace Ui {
@@ -47,6 +49,7 @@ signals:
 private slots:
     void changeFilePathSlot(void);
     void acceptedSlot(void);
+    void convertBackupSlot(void);
 };
 
 #endif // BACKUPOPTIONSDIALOG_H
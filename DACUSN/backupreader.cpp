@@ -0,0 +1,270 @@
+/**
+ * @file backupreader.cpp
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Definitions of backupReader class methods.
+ *
+ * @section DESCRIPTION
+ *
+ * Trailer is trusted only if it points inside the file, index fits between frames and trailer and
+ * offsets of index entries point into frames in increasing order, otherwise the file is handled as
+ * unfinished.
+ *
+ */
+
+#include "backupreader.h"
+
+backupReader::backupReader()
+{
+    decoder = new backupDecoder;
+    file = NULL;
+    data = NULL;
+    index = NULL;
+
+    close();
+}
+
+backupReader::~backupReader()
+{
+    close();
+    delete decoder;
+}
+
+bool backupReader::open(QString file_path)
+{
+    close();
+
+    file = new QFile(file_path);
+    if(!file->open(QIODevice::ReadOnly) || file->size()<(qint64)(sizeof(backup_file_header)))
+    {
+        qDebug() << "Backup file " << file_path << " could not be opened.";
+        close();
+        return false;
+    }
+
+    qint64 size = file->size();
+    data = file->map(0, size);
+    if(data==NULL)
+    {
+        qDebug() << "Backup file " << file_path << " could not be mapped into memory.";
+        close();
+        return false;
+    }
+
+    const backup_file_header * header = (const backup_file_header *)(data);
+    if(header->magic!=BACKUP_FILE_MAGIC || header->version!=BACKUP_FILE_VERSION)
+    {
+        qDebug() << "File " << file_path << " is not binary backup of known version.";
+        close();
+        return false;
+    }
+
+    // compressed file starts with block instead of frame, both sync words are read as the first member
+    compressed = size>=(qint64)(sizeof(backup_file_header)+sizeof(quint32))
+            && *(const quint32 *)(data+sizeof(backup_file_header))==BACKUP_BLOCK_SYNC;
+
+    if(size>=(qint64)(sizeof(backup_file_header)+sizeof(backup_file_trailer)))
+    {
+        const backup_file_trailer * trailer = (const backup_file_trailer *)(data+size-sizeof(backup_file_trailer));
+        qint64 indexEnd = trailer->index_offset+(qint64)(trailer->entries)*sizeof(backup_index_entry);
+
+        if(trailer->magic==BACKUP_INDEX_MAGIC && trailer->index_offset>=(qint64)(sizeof(backup_file_header))
+                && trailer->index_offset%8==0 && indexEnd==size-(qint64)(sizeof(backup_file_trailer))
+                && validIndex((const backup_index_entry *)(data+trailer->index_offset), trailer->entries, trailer->index_offset))
+        {
+            // index is used directly from mapping
+            framesEnd = trailer->index_offset;
+            index = (const backup_index_entry *)(data+trailer->index_offset);
+            indexCount = trailer->entries;
+            framesCount = trailer->frames;
+            lastTimestamp = trailer->last_timestamp;
+            finished = true;
+
+            return true;
+        }
+    }
+
+    qDebug() << "Backup file " << file_path << " was not finished properly, index is rebuilt.";
+
+    framesEnd = size;
+    rebuildIndex();
+
+    return true;
+}
+
+void backupReader::close()
+{
+    if(file!=NULL)
+    {
+        if(data!=NULL) file->unmap((uchar *)(data));
+        file->close();
+        delete file;
+    }
+
+    file = NULL;
+    data = NULL;
+    framesEnd = 0;
+    index = NULL;
+    indexCount = 0;
+    rebuiltIndex.clear();
+    finished = false;
+    compressed = false;
+    nextBlock = 0;
+    framesCount = 0;
+    lastTimestamp = 0;
+}
+
+const backup_frame_header *backupReader::seek(qint64 timestamp)
+{
+    if(indexCount==0) return NULL;
+
+    // the last indexed frame which is older than required time, searched frame is between it and the next indexed one
+    int low = 0;
+    int high = indexCount;
+    while(high-low>1)
+    {
+        int middle = (low+high)/2;
+        if(index[middle].timestamp<timestamp) low = middle;
+        else high = middle;
+    }
+
+    const backup_frame_header * frame = compressed ? blockAt(index[low].offset) : frameAt(index[low].offset);
+    while(frame!=NULL && frame->timestamp<timestamp) frame = next(frame);
+
+    return frame;
+}
+
+const backup_frame_header *backupReader::next(const backup_frame_header *frame)
+{
+    const char * following = (const char *)(frame)+BACKUP_FRAME_SIZE(frame->count);
+
+    if(!compressed) return frameAt((const uchar *)(following)-data);
+
+    if(following<decoder->getFramesEnd()) return (const backup_frame_header *)(following);
+    return blockAt(nextBlock);
+}
+
+const backup_frame_header *backupReader::blockAt(qint64 offset)
+{
+    if(offset<(qint64)(sizeof(backup_file_header))) return NULL;
+
+    // empty blocks are never written, but they would be skipped
+    while(offset<framesEnd && decoder->decode(data+offset, framesEnd-offset))
+    {
+        offset += backupDecoder::blockSize(data+offset, framesEnd-offset, false);
+        nextBlock = offset;
+
+        if(decoder->getFramesEnd()>(const char *)(decoder->getFrames())) return decoder->getFrames();
+    }
+
+    return NULL;
+}
+
+const backup_frame_header *backupReader::frameAt(qint64 offset)
+{
+    // compared without adding to offset, so no value can overflow
+    if(offset<(qint64)(sizeof(backup_file_header)) || offset>framesEnd-(qint64)(sizeof(backup_frame_header))) return NULL;
+
+    const backup_frame_header * frame = (const backup_frame_header *)(data+offset);
+    if(frame->sync!=BACKUP_FRAME_SYNC || frame->count<0 || (qint64)(BACKUP_FRAME_SIZE(frame->count))>framesEnd-offset) return NULL;
+
+    return frame;
+}
+
+void backupReader::rebuildIndex()
+{
+    qint64 offset = sizeof(backup_file_header);
+    const backup_frame_header * frame;
+
+    if(compressed)
+    {
+        qint64 size;
+        qint64 lastBlock = -1;
+
+        // blocks are only checked here, the last one is decoded to find the last timestamp
+        while((size = backupDecoder::blockSize(data+offset, framesEnd-offset, true))>0)
+        {
+            const backup_block_header * block = (const backup_block_header *)(data+offset);
+
+            backup_index_entry entry;
+            entry.timestamp = block->timestamp;
+            entry.offset = offset;
+            rebuiltIndex.append(entry);
+
+            framesCount += block->frames;
+            lastBlock = offset;
+            offset += size;
+        }
+
+        framesEnd = offset;
+        index = rebuiltIndex.constData();
+        indexCount = rebuiltIndex.count();
+
+        for(frame = (lastBlock>=0) ? blockAt(lastBlock) : NULL; frame!=NULL; frame = next(frame)) lastTimestamp = frame->timestamp;
+
+        return;
+    }
+
+    while((frame = frameAt(offset))!=NULL)
+    {
+        if(framesCount%BACKUP_INDEX_INTERVAL==0)
+        {
+            backup_index_entry entry;
+            entry.timestamp = frame->timestamp;
+            entry.offset = offset;
+            rebuiltIndex.append(entry);
+        }
+
+        framesCount++;
+        lastTimestamp = frame->timestamp;
+        offset += BACKUP_FRAME_SIZE(frame->count);
+    }
+
+    // anything after the last valid frame is ignored
+    framesEnd = offset;
+    index = rebuiltIndex.constData();
+    indexCount = rebuiltIndex.count();
+}
+
+bool backupReader::validIndex(const backup_index_entry *entries, int count, qint64 frames_end)
+{
+    if(count<0) return false;
+
+    qint64 previous = (qint64)(sizeof(backup_file_header))-1;
+    for(int i=0; i<count; i++)
+    {
+        if(entries[i].offset<=previous || entries[i].offset>=frames_end) return false;
+        previous = entries[i].offset;
+    }
+
+    return true;
+}
+
+int backupReader::convertToText(QString binary_path, QString text_path)
+{
+    backupReader reader;
+    if(!reader.open(binary_path)) return -1;
+
+    QFile output(text_path);
+    if(!output.open(QFile::Text | QIODevice::WriteOnly)) return -1;
+    QTextStream stream(&output);
+
+    int frames = 0;
+
+    for(const backup_frame_header * frame = reader.first(); frame!=NULL; frame = reader.next(frame))
+    {
+        const backup_track_record * tracks = getRecords(frame);
+
+        // values are written the same way as the former text backup did
+        stream << frame->timestamp << "%" << (float)(frame->count);
+        for(int j=0; j<frame->count; j++) stream << "%" << (qint64)(tracks[j].id) << "%" << tracks[j].x << "%" << tracks[j].y;
+        stream << "%\n";
+
+        frames++;
+    }
+
+    stream.flush();
+    output.close();
+
+    return frames;
+}
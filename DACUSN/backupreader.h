@@ -0,0 +1,167 @@
+/**
+ * @file backupreader.h
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Random access to binary disk backup through memory mapped file.
+ *
+ * @section DESCRIPTION
+ *
+ * Whole backup file written by 'backupWriter' is mapped into memory and frames are returned as pointers
+ * directly into the mapping, so iteration over frames does not copy or parse anything and the system
+ * loads only pages which are really accessed. Frame nearest to given time is found by binary search in
+ * sparse index stored at the end of file and then by walking at most BACKUP_INDEX_INTERVAL frames, so
+ * seeking in multi-hour recording costs only few page accesses.
+ *
+ * Compressed backup is recognized by its first block. Block containing requested frame is decoded into
+ * memory of reader and frames are returned as pointers into decoded block, so they have the same layout
+ * as in uncompressed file, but pointer is valid only until the reader moves to another block.
+ *
+ * If the file was not finished (trailer is missing), index is built by one pass over all frames (or blocks)
+ * when file is opened and reading stops at the first incomplete or corrupted frame (or block).
+ *
+ * Seeking assumes that timestamps of frames do not decrease, which is true unless the system clock was
+ * moved back during recording.
+ *
+ */
+
+#ifndef BACKUPREADER_H
+#define BACKUPREADER_H
+
+#include <QFile>
+#include <QTextStream>
+#include <QString>
+#include <QVector>
+#include <QDebug>
+
+#include "backupwriter.h"
+#include "backupcodec.h"
+
+class backupReader
+{
+public:
+    backupReader();
+    ~backupReader();
+
+    /**
+     * @brief Maps backup file into memory and loads its index. Previously opened file is closed.
+     * @param[in] file_path Path of binary backup file.
+     * @return False if file could not be mapped or is not binary backup of known version.
+     */
+    bool open(QString file_path);
+
+    /**
+     * @brief Unmaps the file. All frame pointers obtained from reader become invalid.
+     */
+    void close(void);
+
+    /**
+     * @brief Returns true if file was finished properly and its index was not rebuilt.
+     * @return True if trailer was found.
+     */
+    bool isFinished(void) { return finished; }
+
+    /**
+     * @brief Returns true if frames are stored in compressed blocks.
+     * @return True if file is compressed.
+     */
+    bool isCompressed(void) { return compressed; }
+
+    /**
+     * @brief Returns the number of readable frames.
+     * @return Number of frames.
+     */
+    qint64 getFramesCount(void) { return framesCount; }
+
+    /**
+     * @brief Returns timestamp of the first frame.
+     * @return Milliseconds since epoch, zero if there are no frames.
+     */
+    qint64 getStartTime(void) { return (indexCount>0) ? index[0].timestamp : 0; }
+
+    /**
+     * @brief Returns timestamp of the last frame.
+     * @return Milliseconds since epoch, zero if there are no frames.
+     */
+    qint64 getEndTime(void) { return lastTimestamp; }
+
+    /**
+     * @brief Returns the first frame of file.
+     * @return Pointer into mapped file (or decoded block) or NULL if there are no frames.
+     */
+    const backup_frame_header * first(void) { return compressed ? blockAt(sizeof(backup_file_header)) : frameAt(sizeof(backup_file_header)); }
+
+    /**
+     * @brief Returns the frame following given frame.
+     * @param[in] frame The last frame obtained from this reader.
+     * @return Pointer into mapped file (or decoded block) or NULL if 'frame' was the last one.
+     */
+    const backup_frame_header * next(const backup_frame_header * frame);
+
+    /**
+     * @brief Finds the first frame which is not older than given time.
+     * @param[in] timestamp Time in milliseconds since epoch.
+     * @return Pointer into mapped file (or decoded block) or NULL if all frames are older.
+     */
+    const backup_frame_header * seek(qint64 timestamp);
+
+    /**
+     * @brief Returns track records of frame, they directly follow its header.
+     * @param[in] frame Frame obtained from reader.
+     * @return Array of 'frame->count' records.
+     */
+    static const backup_track_record * getRecords(const backup_frame_header * frame) { return (const backup_track_record *)(frame+1); }
+
+    /**
+     * @brief Rewrites binary backup into legacy text format 'time%count%id%x%y%id%x%y...%' with one line per frame.
+     * @param[in] binary_path Path of binary backup file.
+     * @param[in] text_path Path of created text file.
+     * @return Number of converted frames or -1 if binary file is not valid backup or files could not be opened.
+     */
+    static int convertToText(QString binary_path, QString text_path);
+
+private:
+    QFile * file; ///< Mapped file, NULL if nothing is opened
+    const uchar * data; ///< Beginning of mapping
+    qint64 framesEnd; ///< Position where frames end (index of finished file or the end of the last valid frame)
+
+    const backup_index_entry * index; ///< Sparse index, points either into mapping or into 'rebuiltIndex'
+    int indexCount; ///< Number of index entries
+    QVector<backup_index_entry> rebuiltIndex; ///< Index built when opening file without trailer
+
+    bool finished; ///< True if trailer was found
+    bool compressed; ///< True if file consists of compressed blocks
+    backupDecoder * decoder; ///< Decoder holding the current block of compressed file
+    qint64 nextBlock; ///< Position of block following the current decoded block
+    qint64 framesCount; ///< Number of frames
+    qint64 lastTimestamp; ///< Timestamp of the last frame
+
+    /**
+     * @brief Returns frame at given position if it lies completely between file header and 'framesEnd' and its header is valid.
+     * @param[in] offset Position in file.
+     * @return Pointer into mapped file or NULL.
+     */
+    const backup_frame_header * frameAt(qint64 offset);
+
+    /**
+     * @brief Decodes compressed block at given position.
+     * @param[in] offset Position in file.
+     * @return The first frame of block or NULL if there is no valid block at position.
+     */
+    const backup_frame_header * blockAt(qint64 offset);
+
+    /**
+     * @brief Walks all frames (or blocks) of file without trailer, builds index and finds the end of the last valid one.
+     */
+    void rebuildIndex(void);
+
+    /**
+     * @brief Checks index read from trailer. Offsets must point behind file header, before 'frames_end' and grow with each entry.
+     * @param[in] entries Index entries.
+     * @param[in] count Number of entries.
+     * @param[in] frames_end Position where frames end.
+     * @return True if index can be used for seeking.
+     */
+    static bool validIndex(const backup_index_entry * entries, int count, qint64 frames_end);
+};
+
+#endif // BACKUPREADER_H
@@ -0,0 +1,152 @@
+/**
+ * @file backupwriter.cpp
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Definitions of backupWriter class methods.
+ *
+ * @section DESCRIPTION
+ *
+ * Frame headers are read back from the ring by writer thread, so index is collected and frames are
+ * encoded without any help from producer.
+ *
+ */
+
+#include "backupwriter.h"
+#include "backupcodec.h"
+
+backupWriter::backupWriter(QString file_path, bool compressed, quint32 quantum, int queue_size)
+    : ringWriter(file_path, queue_size)
+{
+    framesCount = 0;
+    lastTimestamp = 0;
+
+    encoder = compressed ? new backupEncoder(quantum) : NULL;
+}
+
+backupWriter::~backupWriter()
+{
+    if(file!=NULL) finish();
+
+    delete encoder;
+}
+
+bool backupWriter::open()
+{
+    if(!ringWriter::open()) return false;
+
+    backup_file_header header;
+    header.magic = BACKUP_FILE_MAGIC;
+    header.version = BACKUP_FILE_VERSION;
+    file->write((const char *)(&header), sizeof(backup_file_header));
+    fileOffset = sizeof(backup_file_header);
+
+    return true;
+}
+
+bool backupWriter::push(qint64 timestamp, const backup_track_record *tracks, int count)
+{
+    if(count<0) count = 0;
+
+    quint32 size = BACKUP_FRAME_SIZE(count);
+    quint32 records = sizeof(backup_frame_header) + count*sizeof(backup_track_record);
+    quint32 position;
+
+    if(!reserve(size, &position)) return false;
+
+    backup_frame_header frame;
+    frame.sync = BACKUP_FRAME_SYNC;
+    frame.count = count;
+    frame.timestamp = timestamp;
+
+    put(position, &frame, sizeof(backup_frame_header));
+    if(count>0) put(position+sizeof(backup_frame_header), tracks, count*sizeof(backup_track_record));
+
+    // padding keeps frames aligned in memory mapped file
+    static const char padding[8] = {0};
+    if(size>records) put(position+records, padding, size-records);
+
+    // frame becomes visible to writer only when it is complete
+    commit(position+size);
+
+    return true;
+}
+
+int backupWriter::writePending()
+{
+    quint32 h = pendingEnd();
+    quint32 t = pendingBegin();
+
+    if(h==t) return 0;
+
+    // frame headers are read from ring to collect index or to encode frames, producer wrote them before 'head' was moved
+    backup_frame_header frame;
+    for(quint32 position = t; position!=h; position += BACKUP_FRAME_SIZE(frame.count))
+    {
+        get(position, &frame, sizeof(backup_frame_header));
+
+        if(encoder!=NULL)
+        {
+            // records may wrap around the end of ring, encoder needs them in one piece
+            tracks.resize(frame.count);
+            if(frame.count>0) get(position+sizeof(backup_frame_header), tracks.data(), frame.count*sizeof(backup_track_record));
+
+            encoder->append(&frame, tracks.constData());
+            if(encoder->getFramesCount()>=BACKUP_INDEX_INTERVAL) writeBlock();
+        }
+        else if(framesCount%BACKUP_INDEX_INTERVAL==0)
+        {
+            backup_index_entry entry;
+            entry.timestamp = frame.timestamp;
+            entry.offset = fileOffset+(position-t);
+            index.append(entry);
+        }
+
+        framesCount++;
+        lastTimestamp = frame.timestamp;
+    }
+
+    if(encoder==NULL) writeRing(t, h);
+
+    // space is returned to producer after data were copied into file buffers
+    releaseRing(h);
+
+    return h-t;
+}
+
+void backupWriter::writeBlock()
+{
+    if(encoder==NULL || encoder->getFramesCount()==0) return;
+
+    backup_index_entry entry;
+    entry.timestamp = encoder->getTimestamp();
+    entry.offset = fileOffset;
+    index.append(entry);
+
+    const char * block = encoder->finishBlock();
+    int size = encoder->getBlockSize();
+    if(file!=NULL) file->write(block, size);
+    fileOffset += size;
+
+    encoder->reset();
+}
+
+void backupWriter::finish()
+{
+    writePending();
+    writeBlock();
+
+    // frames are padded, so index starts aligned right after the last frame
+    backup_file_trailer trailer;
+    trailer.magic = BACKUP_INDEX_MAGIC;
+    trailer.entries = index.count();
+    trailer.index_offset = fileOffset;
+    trailer.frames = framesCount;
+    trailer.last_timestamp = lastTimestamp;
+
+    if(!index.isEmpty()) file->write((const char *)(index.constData()), index.count()*sizeof(backup_index_entry));
+    file->write((const char *)(&trailer), sizeof(backup_file_trailer));
+
+    file->close();
+    delete file;
+    file = NULL;
+}
@@ -0,0 +1,154 @@
+/**
+ * @file backupwriter.h
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Binary disk backup of fused frames written by dedicated thread.
+ *
+ * @section DESCRIPTION
+ *
+ * Stack manager produces one backup record after each fusion. Formatting of values as text and file
+ * operations on processing thread used to cost more than the fusion itself, so records are stored in
+ * compact binary form and only copied into lock-free ring buffer of 'ringWriter'. The 'backupWriter'
+ * object running in its own thread writes them into file, so processing thread never waits for disk.
+ *
+ * Backup file starts with 'backup_file_header' structure. Each frame is stored as 'backup_frame_header'
+ * followed by 'count' records 'backup_track_record' and padded to multiple of 8 bytes, so frames can be
+ * accessed directly in memory mapped file. Native byte order is used.
+ *
+ * Writer remembers position of each BACKUP_INDEX_INTERVAL-th frame while writing. When backup is finished,
+ * these 'backup_index_entry' entries are appended after the last frame and file is closed by
+ * 'backup_file_trailer', so 'backupReader' can find frame by time without reading the whole file.
+ * If the trailer is missing (program was not closed properly), frames are still readable.
+ *
+ * Optionally, writer compresses frames into blocks of BACKUP_INDEX_INTERVAL frames (see backupcodec.h),
+ * which are stored instead of raw frames and index points to blocks. Compression runs in writer thread,
+ * so processing thread pushes raw frames in both modes. Blocks are written when they are full and also
+ * each RING_WRITER_FLUSH_INTERVAL, so no more data than in raw mode are lost if program crashes.
+ *
+ */
+
+#ifndef BACKUPWRITER_H
+#define BACKUPWRITER_H
+
+#include <QString>
+#include <QVector>
+
+#include "ringwriter.h"
+
+#define BACKUP_FILE_MAGIC       (0x4B424344)    ///< "DCBK" identifier at the beginning of binary backup file
+#define BACKUP_FILE_VERSION     (2)             ///< Version of binary backup layout
+#define BACKUP_FRAME_SYNC       (0x4D415246)    ///< "FRAM" identifier at the beginning of each frame, allows to detect corrupted file
+#define BACKUP_INDEX_MAGIC      (0x58444942)    ///< "BIDX" identifier of trailer of finished backup file
+#define BACKUP_INDEX_INTERVAL   (64)            ///< Every n-th frame has entry in index, seek reads at most this number of frames
+
+class backupEncoder;
+
+#define BACKUP_FRAME_SIZE(count) ((sizeof(backup_frame_header)+(count)*sizeof(backup_track_record)+7) & ~((size_t)(7))) ///< Size of frame in file including padding
+
+/**
+ * @brief Header of binary backup file.
+ */
+struct backup_file_header {
+    quint32 magic; ///< Must be equal to BACKUP_FILE_MAGIC
+    quint32 version; ///< Must be equal to BACKUP_FILE_VERSION
+};
+
+/**
+ * @brief Header of one frame in binary backup.
+ */
+struct backup_frame_header {
+    quint32 sync; ///< Must be equal to BACKUP_FRAME_SYNC
+    qint32 count; ///< Number of track records following the header
+    qint64 timestamp; ///< Time of fusion in milliseconds since epoch
+};
+
+/**
+ * @brief One target of frame in binary backup.
+ */
+struct backup_track_record {
+    qint32 id; ///< Identifier of target (track identifier or index of fused position)
+    float x; ///< X coordinate in meters
+    float y; ///< Y coordinate in meters
+};
+
+/**
+ * @brief Entry of sparse time index stored at the end of finished backup.
+ */
+struct backup_index_entry {
+    qint64 timestamp; ///< Timestamp of indexed frame
+    qint64 offset; ///< Position of indexed frame from the beginning of file
+};
+
+/**
+ * @brief The last structure of finished backup file.
+ */
+struct backup_file_trailer {
+    quint32 magic; ///< Must be equal to BACKUP_INDEX_MAGIC
+    quint32 entries; ///< Number of index entries
+    qint64 index_offset; ///< Position of the first index entry, frames end there
+    qint64 frames; ///< Number of frames in file
+    qint64 last_timestamp; ///< Timestamp of the last frame
+};
+
+class backupWriter : public ringWriter
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Prepares writer. File is not opened until 'open' is called.
+     * @param[in] file_path Path of binary backup file, existing file is overwritten.
+     * @param[in] compressed If true, frames are stored in compressed blocks.
+     * @param[in] quantum Resolution of compressed coordinates in micrometers, zero for lossless coordinates.
+     * @param[in] queue_size Size of ring buffer in bytes, rounded up to power of two.
+     */
+    backupWriter(QString file_path, bool compressed = false, quint32 quantum = 0, int queue_size = RING_WRITER_QUEUE_SIZE);
+    ~backupWriter();
+
+    /**
+     * @brief Creates backup file and writes its header. Must be called before writer thread is started.
+     * @return False if file could not be opened.
+     */
+    bool open(void);
+
+    /**
+     * @brief Copies one frame into ring buffer. Never blocks, must be called from one thread at a time.
+     * @param[in] timestamp Time of fusion in milliseconds since epoch.
+     * @param[in] tracks Array of 'count' track records.
+     * @param[in] count Number of tracks.
+     * @return False if ring is full and frame was dropped.
+     */
+    bool push(qint64 timestamp, const backup_track_record * tracks, int count);
+
+protected:
+    /**
+     * @brief Collects index (or encodes frames) and writes all frames pushed so far.
+     * @return Number of processed bytes of ring.
+     */
+    int writePending(void);
+
+    /**
+     * @brief Writes unfinished compressed block, so it is not lost if program crashes.
+     */
+    void flushPending(void) { writeBlock(); }
+
+    /**
+     * @brief Writes remaining frames, index and trailer and closes the file.
+     */
+    void finish(void);
+
+private:
+    qint64 framesCount; ///< Number of frames handed to file
+    qint64 lastTimestamp; ///< Timestamp of the last frame handed to file
+    QVector<backup_index_entry> index; ///< Sparse index collected while writing, appended to file when backup is finished
+
+    backupEncoder * encoder; ///< Encoder of the current block, NULL if backup is not compressed
+    QVector<backup_track_record> tracks; ///< Records of frame copied out of ring for encoder
+
+    /**
+     * @brief Writes the current compressed block (if it is not empty) and starts a new one.
+     */
+    void writeBlock(void);
+};
+
+#endif // BACKUPWRITER_H
@@ -0,0 +1,235 @@
+/**
+ * @file batchlocalization.cpp
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Definitions of batchLocalization class methods.
+ *
+ * @section DESCRIPTION
+ *
+ * The intersection is computed with the same equations and in the same order of operations as in
+ * 'mtt_pure::intersection2ellipses', so positions in radar coordinate system are identical. Only the
+ * if/else fallbacks are replaced by masks: the y coordinate is taken from the first ellipse if it gives
+ * real solution, otherwise from the second one, and couples where neither gives solution or y is smaller
+ * than BATCH_LOCALIZATION_MIN_Y are marked as invalid.
+ *
+ */
+
+#include "batchlocalization.h"
+
+batchLocalization::batchLocalization(int initial_capacity)
+{
+    radars = NULL;
+    radarsCount = 0;
+
+    count = 0;
+    capacity = 0;
+
+    d0 = d1 = x1 = x2 = NULL;
+    cosAngle = sinAngle = xpos = ypos = NULL;
+    outX = outY = NULL;
+    radar = valid = NULL;
+
+    reserve((initial_capacity>0) ? initial_capacity : BATCH_LOCALIZATION_CAPACITY);
+}
+
+batchLocalization::~batchLocalization()
+{
+    delete [] radars;
+    delete [] d0;
+    delete [] d1;
+    delete [] x1;
+    delete [] x2;
+    delete [] cosAngle;
+    delete [] sinAngle;
+    delete [] xpos;
+    delete [] ypos;
+    delete [] radar;
+    delete [] outX;
+    delete [] outY;
+    delete [] valid;
+}
+
+void batchLocalization::setRadar(int radar_id, const toa_antenna_geometry &geometry)
+{
+    if(radar_id<0) return;
+
+    if(radar_id>=radarsCount)
+    {
+        int new_count = (2*radarsCount>radar_id) ? 2*radarsCount : radar_id+1;
+        radar_geometry * table = new radar_geometry[new_count];
+        for(int i=radarsCount; i<new_count; i++) table[i].set = false;
+        if(radars!=NULL)
+        {
+            memcpy(table, radars, radarsCount*sizeof(radar_geometry));
+            delete [] radars;
+        }
+        radars = table;
+        radarsCount = new_count;
+    }
+
+    // trigonometric functions are evaluated only once, not for each couple
+    radar_geometry * g = &radars[radar_id];
+    g->set = true;
+    g->x1 = geometry.x1;
+    g->x2 = geometry.x2;
+    g->cosAngle = (float) cos(geometry.rot_angle);
+    g->sinAngle = (float) sin(geometry.rot_angle);
+    g->xpos = geometry.xpos;
+    g->ypos = geometry.ypos;
+}
+
+int batchLocalization::addTOA(int radar_id, const float *TOA_mem, int couples)
+{
+    int i, added;
+
+    if(radar_id<0 || radar_id>=radarsCount || !radars[radar_id].set) return 0;
+    radar_geometry * g = &radars[radar_id];
+
+    // the same end condition as in MT_localization, couples are always stored from the beginning of array
+    added = 0;
+    while(added<couples && (TOA_mem[2*added]!=0 || TOA_mem[2*added+1]!=0)) added++;
+
+    if(count+added>capacity) reserve(2*(count+added));
+
+    for(i=0; i<added; i++)
+    {
+        d0[count] = TOA_mem[2*i];
+        d1[count] = TOA_mem[2*i+1];
+        x1[count] = g->x1;
+        x2[count] = g->x2;
+        cosAngle[count] = g->cosAngle;
+        sinAngle[count] = g->sinAngle;
+        xpos[count] = g->xpos;
+        ypos[count] = g->ypos;
+        radar[count] = radar_id;
+        count++;
+    }
+
+    return added;
+}
+
+int batchLocalization::localize(float *positions, int *radar_ids)
+{
+    int i, k, found;
+
+    i = 0;
+#if defined (__SSE2__)
+    const __m128 v_half = _mm_set1_ps(0.5f);
+    const __m128 v_zero = _mm_setzero_ps();
+    const __m128 v_sign = _mm_set1_ps(-0.0f);
+    const __m128 v_min_y = _mm_set1_ps((float) BATCH_LOCALIZATION_MIN_Y);
+    int mask;
+
+    for( ; i+4<=count; i+=4)
+    {
+        __m128 v_d0 = _mm_loadu_ps(&d0[i]);
+        __m128 v_d1 = _mm_loadu_ps(&d1[i]);
+        __m128 v_x1 = _mm_loadu_ps(&x1[i]);
+        __m128 v_x2 = _mm_loadu_ps(&x2[i]);
+
+        __m128 v_k1 = _mm_mul_ps(v_half, _mm_sub_ps(_mm_mul_ps(v_d0, v_d0), _mm_mul_ps(v_x1, v_x1)));
+        __m128 v_k2 = _mm_mul_ps(v_half, _mm_sub_ps(_mm_mul_ps(v_d1, v_d1), _mm_mul_ps(v_x2, v_x2)));
+        __m128 v_num = _mm_xor_ps(v_sign, _mm_sub_ps(_mm_mul_ps(v_k1, v_d1), _mm_mul_ps(v_k2, v_d0)));
+        __m128 v_x = _mm_div_ps(v_num, _mm_sub_ps(_mm_mul_ps(v_x1, v_d1), _mm_mul_ps(v_x2, v_d0)));
+        __m128 v_xx = _mm_mul_ps(v_x, v_x);
+
+        __m128 v_t1 = _mm_div_ps(_mm_add_ps(_mm_mul_ps(v_x1, v_x), v_k1), v_d0);
+        __m128 v_t2 = _mm_div_ps(_mm_add_ps(_mm_mul_ps(v_x2, v_x), v_k2), v_d1);
+        v_t1 = _mm_sub_ps(_mm_mul_ps(v_t1, v_t1), v_xx);
+        v_t2 = _mm_sub_ps(_mm_mul_ps(v_t2, v_t2), v_xx);
+
+        // the first ellipse has priority, comparisons with NaN are false, so degenerated couples end up masked out
+        __m128 m1 = _mm_cmpgt_ps(v_t1, v_zero);
+        __m128 m2 = _mm_cmpgt_ps(v_t2, v_zero);
+        __m128 v_t = _mm_or_ps(_mm_and_ps(m1, v_t1), _mm_andnot_ps(m1, v_t2));
+        __m128 v_y = _mm_and_ps(_mm_or_ps(m1, m2), _mm_sqrt_ps(_mm_max_ps(v_t, v_zero)));
+
+        // y < MIN_Y_COORDINATE in double is the same as y <= (float) MIN_Y_COORDINATE, because y is never negative
+        mask = _mm_movemask_ps(_mm_cmpgt_ps(v_y, v_min_y));
+
+        // transformation into operator coordinate system
+        __m128 v_c = _mm_loadu_ps(&cosAngle[i]);
+        __m128 v_s = _mm_loadu_ps(&sinAngle[i]);
+        _mm_storeu_ps(&outX[i], _mm_add_ps(_mm_loadu_ps(&xpos[i]), _mm_sub_ps(_mm_mul_ps(v_c, v_x), _mm_mul_ps(v_s, v_y))));
+        _mm_storeu_ps(&outY[i], _mm_add_ps(_mm_loadu_ps(&ypos[i]), _mm_add_ps(_mm_mul_ps(v_s, v_x), _mm_mul_ps(v_c, v_y))));
+
+        for(k=0; k<4; k++) valid[i+k] = (mask>>k) & 1;
+    }
+#endif
+
+    // remaining couples (all couples without SSE)
+    solve(i);
+
+    found = 0;
+    for(i=0; i<count; i++)
+    {
+        if(!valid[i]) continue;
+
+        positions[found*2] = outX[i];
+        positions[found*2+1] = outY[i];
+        if(radar_ids!=NULL) radar_ids[found] = radar[i];
+        found++;
+    }
+
+    return found;
+}
+
+void batchLocalization::reserve(int required)
+{
+    if(required<=capacity) return;
+
+    float ** float_arrays[] = { &d0, &d1, &x1, &x2, &cosAngle, &sinAngle, &xpos, &ypos, &outX, &outY };
+    int ** int_arrays[] = { &radar, &valid };
+    unsigned int i;
+
+    for(i=0; i<sizeof(float_arrays)/sizeof(float_arrays[0]); i++)
+    {
+        float * array = new float[required];
+        if(*float_arrays[i]!=NULL)
+        {
+            memcpy(array, *float_arrays[i], count*sizeof(float));
+            delete [] *float_arrays[i];
+        }
+        *float_arrays[i] = array;
+    }
+
+    for(i=0; i<sizeof(int_arrays)/sizeof(int_arrays[0]); i++)
+    {
+        int * array = new int[required];
+        if(*int_arrays[i]!=NULL)
+        {
+            memcpy(array, *int_arrays[i], count*sizeof(int));
+            delete [] *int_arrays[i];
+        }
+        *int_arrays[i] = array;
+    }
+
+    capacity = required;
+}
+
+void batchLocalization::solve(int first)
+{
+    int i;
+    float k1, k2, x, y, t1, t2;
+
+    for(i=first; i<count; i++)
+    {
+        k1 = 0.5f*(d0[i]*d0[i]-x1[i]*x1[i]);
+        k2 = 0.5f*(d1[i]*d1[i]-x2[i]*x2[i]);
+        x = -(k1*d1[i]-k2*d0[i])/(x1[i]*d1[i] - x2[i]*d0[i]);
+
+        t1 = (x1[i]*x+k1)/d0[i];
+        t1 = t1*t1-x*x;
+        t2 = (x2[i]*x+k2)/d1[i];
+        t2 = t2*t2-x*x;
+
+        if(t1>0) y = (float) sqrt(t1);
+        else if(t2>0) y = (float) sqrt(t2);
+        else y = 0;
+
+        valid[i] = (y > (float) BATCH_LOCALIZATION_MIN_Y);
+
+        outX[i] = xpos[i] + (cosAngle[i]*x - sinAngle[i]*y);
+        outY[i] = ypos[i] + (sinAngle[i]*x + cosAngle[i]*y);
+    }
+}
@@ -0,0 +1,132 @@
+/**
+ * @file batchlocalization.h
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Localization of many TOA couples from many radars in one pass.
+ *
+ * @section DESCRIPTION
+ *
+ * Each TOA couple (distances transmitter-target-receiver for both receivers) defines two ellipses and the target
+ * lies in their intersection. 'mtt_pure::MT_localization' solves couples of one radar one by one. The 'batchLocalization'
+ * object collects couples of any number of radars, each radar with its own antenna baseline and placement in operator
+ * coordinate system (set once by 'setRadar'), and solves all of them at once. Couples are stored as structure of arrays, so the intersection
+ * is computed for four couples at once with SSE. Invalid intersections (no real solution or too close to antenna axis)
+ * are not branched on, they are masked out and dropped from the output. Results are already in operator coordinates.
+ *
+ */
+
+#ifndef BATCHLOCALIZATION_H
+#define BATCHLOCALIZATION_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define BATCH_LOCALIZATION_MIN_Y    (0.02)      ///< Intersections with y closer to antenna axis are ill conditioned and dropped, must match MIN_Y_COORDINATE
+#define BATCH_LOCALIZATION_CAPACITY (64)        ///< Initial number of TOA couples, storage grows automatically
+
+/**
+ * @brief Antenna geometry of one radar.
+ */
+struct toa_antenna_geometry
+{
+    float x1; ///< Position of the first receiving antenna on radar x axis (transmitter is in the origin)
+    float x2; ///< Position of the second receiving antenna on radar x axis
+    float xpos; ///< X position of radar in operator coordinate system
+    float ypos; ///< Y position of radar in operator coordinate system
+    float rot_angle; ///< Rotation of radar coordinate system in relation to operator coordinate system (radians)
+};
+
+class batchLocalization
+{
+public:
+    /**
+     * @brief Creates empty batch.
+     * @param[in] initial_capacity Number of TOA couples storage is prepared for. More couples can be added, storage grows if needed.
+     */
+    batchLocalization(int initial_capacity = BATCH_LOCALIZATION_CAPACITY);
+    ~batchLocalization();
+
+    /**
+     * @brief Removes all couples from batch. Memory is kept for the next batch.
+     */
+    void clear(void) { count = 0; }
+
+    /**
+     * @brief Returns the number of couples currently waiting in batch.
+     * @return Number of couples.
+     */
+    int getCount(void) { return count; }
+
+    /**
+     * @brief Sets antenna geometry of radar. Geometry is kept until it is changed, 'clear' does not remove it.
+     * @param[in] radar_id Identificator of radar (non-negative, radar ids are used as indexes of geometry table).
+     * @param[in] geometry Antenna geometry of radar.
+     */
+    void setRadar(int radar_id, const toa_antenna_geometry & geometry);
+
+    /**
+     * @brief Appends TOA couples of one radar.
+     * @param[in] radar_id Identificator of radar, its geometry must be already set by 'setRadar'. It is returned together with each position by 'localize'.
+     * @param[in] TOA_mem Array of [d1, d2] couples (the same layout as used by 'mtt_pure::MT_localization').
+     * @param[in] couples Maximum number of couples in array. Reading stops at the first [0, 0] couple.
+     * @return Number of couples added, 0 if geometry of radar is not known.
+     */
+    int addTOA(int radar_id, const float * TOA_mem, int couples);
+
+    /**
+     * @brief Computes positions of all couples in batch. Batch is not cleared.
+     * @param[out] positions Array of [x, y] positions in operator coordinate system. Must be able to hold 'getCount()*2' values.
+     * @param[out] radar_ids Identificators of radars the positions belong to, may be NULL. Must be able to hold 'getCount()' values.
+     * @return Number of valid positions written. Couples without valid intersection are skipped, order of others is kept.
+     */
+    int localize(float * positions, int * radar_ids);
+
+private:
+    /**
+     * @brief Geometry of one radar prepared for copying into couples.
+     */
+    struct radar_geometry
+    {
+        bool set; ///< False for radar ids without geometry
+        float x1, x2, cosAngle, sinAngle, xpos, ypos;
+    };
+
+    radar_geometry * radars; ///< Geometry table indexed by radar id
+    int radarsCount; ///< Length of geometry table
+
+    int count; ///< Number of couples in batch
+    int capacity; ///< Number of couples storage can hold
+
+    /* couples stored as structure of arrays, geometry is copied to each couple so the pass does not need any lookups */
+    float * d0; ///< Distances to the first receiver
+    float * d1; ///< Distances to the second receiver
+    float * x1; ///< Positions of the first receiving antenna
+    float * x2; ///< Positions of the second receiving antenna
+    float * cosAngle; ///< Cosine of radar rotation
+    float * sinAngle; ///< Sine of radar rotation
+    float * xpos; ///< Radar x positions in operator coordinate system
+    float * ypos; ///< Radar y positions in operator coordinate system
+    int * radar; ///< Radar identificators
+    float * outX; ///< Intersections in operator coordinate system (x), computed by 'localize'
+    float * outY; ///< Intersections in operator coordinate system (y), computed by 'localize'
+    int * valid; ///< Nonzero for couples with valid intersection, computed by 'localize'
+
+    /**
+     * @brief Reallocates storage so it can hold at least 'required' couples. Stored couples are kept.
+     * @param[in] required Required number of couples.
+     */
+    void reserve(int required);
+
+    /**
+     * @brief Solves intersections of couples from 'first' up to 'count'-1 without SSE. Used for tail of vectorized pass.
+     * @param[in] first Index of the first couple to solve.
+     */
+    void solve(int first);
+};
+
+#endif // BATCHLOCALIZATION_H
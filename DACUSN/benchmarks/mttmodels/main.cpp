@@ -0,0 +1,139 @@
+/**
+ * @file main.cpp
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Comparison of polar and cartesian state model of MTT.
+ *
+ * @section DESCRIPTION
+ *
+ * Synthetic targets move along straight lines in front of radar, observations get uniform noise of
+ * MTT_BENCH_NOISE meters. Both models run on the same observations with the same parameters radar
+ * unit uses (see 'radarUnit::processNewData'). After MTT_BENCH_WARMUP scans each true target is paired
+ * with the nearest estimated position and mean distance is reported together with time per scan.
+ *
+ * Usage: mttmodels [scans]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <QElapsedTimer>
+
+#include "mtt_pure.h"
+
+#define MTT_BENCH_NOISE     (0.1)       ///< Width of uniform measurement noise in meters
+#define MTT_BENCH_WARMUP    (50)        ///< Number of scans not evaluated (new target identification)
+#define MTT_BENCH_PERIOD    (0.05)      ///< Time between scans in seconds
+
+/**
+ * @brief Result of one model on one scenario.
+ */
+struct bench_result {
+    double error; ///< Mean distance of true target to the nearest estimation in meters
+    double time; ///< Mean time of one MTT call in microseconds
+};
+
+/**
+ * @brief Runs tracker of given model on scenario with fixed seed, so both models get the same observations.
+ */
+static bench_result runScenario(int capacity, int targets, int scans, mtt_state_model model)
+{
+    mtt_pure tracker(capacity, model);
+    int allocated = tracker.getCapacity();
+
+    // the same constants as in radar unit
+    float r[] = {0.1, 0.01};
+    float q[] = {0.0, 0.01, 0.0, 0.0001};
+    float diff_d = 1.0;
+    float diff_fi = 0.6;
+    if(model==MTT_CARTESIAN_STATE)
+    {
+        r[1] = 0.1;
+        q[3] = 0.01;
+        diff_fi = 1.0;
+    }
+
+    float * P = new float[allocated*2];
+    double * x0 = new double[targets];
+    double * y0 = new double[targets];
+    double * vx = new double[targets];
+    double * vy = new double[targets];
+
+    srand(1);
+    for(int t=0; t<targets; t++)
+    {
+        // targets are spread over the field of view and stay in it for default number of scans (20 s)
+        x0[t] = -4.0 + 8.0*(t+0.5)/targets;
+        y0[t] = 2.0 + (t%4)*1.5;
+        vx[t] = 0.2*((t%2) ? 1.0 : -1.0)*(0.5+rand()/(double)(RAND_MAX));
+        vy[t] = 0.1*(rand()/(double)(RAND_MAX)-0.5);
+    }
+
+    double errorSum = 0.0;
+    int errorCount = 0;
+    qint64 time = 0;
+    QElapsedTimer timer;
+
+    for(int scan=0; scan<scans; scan++)
+    {
+        double s = scan*MTT_BENCH_PERIOD;
+        for(int i=0; i<allocated*2; i++) P[i] = 0.0;
+
+        int count = (targets<allocated) ? targets : allocated;
+        for(int t=0; t<count; t++)
+        {
+            P[t*2] = x0[t] + vx[t]*s + MTT_BENCH_NOISE*(rand()/(double)(RAND_MAX)-0.5);
+            P[t*2+1] = y0[t] + vy[t]*s + MTT_BENCH_NOISE*(rand()/(double)(RAND_MAX)-0.5);
+        }
+
+        timer.start();
+        tracker.MTT(P, r, q, diff_d, diff_fi, 10, 10);
+        time += timer.nsecsElapsed();
+
+        int tracks = tracker.getTracksCount();
+        if(scan<MTT_BENCH_WARMUP || tracks==0) continue;
+
+        for(int t=0; t<count; t++)
+        {
+            double best = -1.0;
+            for(int k=0; k<tracks; k++)
+            {
+                double d = hypot(P[k*2]-(x0[t]+vx[t]*s), P[k*2+1]-(y0[t]+vy[t]*s));
+                if(best<0.0 || d<best) best = d;
+            }
+            errorSum += best;
+            errorCount++;
+        }
+    }
+
+    delete [] P;
+    delete [] x0;
+    delete [] y0;
+    delete [] vx;
+    delete [] vy;
+
+    bench_result result;
+    result.error = (errorCount>0) ? errorSum/errorCount : -1.0;
+    result.time = time/1000.0/scans;
+    return result;
+}
+
+int main(int argc, char * argv[])
+{
+    int scans = (argc>1) ? atoi(argv[1]) : 400;
+
+    const int scenarios[][2] = { {10, 1}, {10, 4}, {16, 8}, {64, 40} };
+
+    printf("%d scans, noise %.2f m, mean position error [m] / time per scan [us]\n", scans, MTT_BENCH_NOISE);
+    for(unsigned int i=0; i<sizeof(scenarios)/sizeof(scenarios[0]); i++)
+    {
+        bench_result polar = runScenario(scenarios[i][0], scenarios[i][1], scans, MTT_POLAR_STATE);
+        bench_result cartesian = runScenario(scenarios[i][0], scenarios[i][1], scans, MTT_CARTESIAN_STATE);
+
+        printf("cap %3d, %2d targets:  polar %7.3f m %8.1f us   cartesian %7.3f m %8.1f us\n",
+               scenarios[i][0], scenarios[i][1], polar.error, polar.time, cartesian.error, cartesian.time);
+    }
+
+    return 0;
+}
@@ -0,0 +1,21 @@
+#-------------------------------------------------
+#
+# Benchmark of polar and cartesian MTT state model
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+TARGET = mttmodels
+CONFIG   += console
+CONFIG   -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp \
+    ../../mtt_pure.cpp \
+    ../../batchlocalization.cpp \
+    ../../mttsnapshot.cpp \
+    ../../targetcapacity.cpp
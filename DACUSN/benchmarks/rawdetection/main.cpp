@@ -0,0 +1,141 @@
+/**
+ * @file main.cpp
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Equivalence and latency of reference and fused background subtraction and CFAR detector.
+ *
+ * @section DESCRIPTION
+ *
+ * Synthetic impulse responses (noise and a moving reflection in both channels) are processed by two
+ * 'mtt_pure' objects. The first one runs the reference chain ('exponential_bg_subtraction' and
+ * 'detector_cfar' for each channel), the second one the fused chain used by 'detect' ('bg_subtraction_2ch'
+ * and 'detector_cfar_2ch'). Background subtracted samples must be identical and detections must not differ
+ * in any sample, otherwise program returns 1. Filters of fused CFAR may differ by CFAR_2CH_TOLERANCE, so
+ * only samples this close to threshold could differ. Mean latency per scan (both channels) is printed.
+ *
+ * The fused chain uses SSE2 if compiler supports it. Build with DEFINES+=MTT_NO_SSE2 to measure its scalar form.
+ *
+ * Usage: rawdetection [scans]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <QElapsedTimer>
+
+#include "mtt_pure.h"
+
+#define RAW_BENCH_EXP_FACTOR    (0.97)      ///< Exponential background subtraction factor
+#define RAW_BENCH_BETA_FAST     (0.4)       ///< Fast CFAR filter coefficient
+#define RAW_BENCH_BETA_SLOW     (0.005)     ///< Slow CFAR filter coefficient
+#define RAW_BENCH_ALPHA         (2.0)       ///< CFAR threshold multiplier
+
+/**
+ * @brief Returns approximately normally distributed random number with zero mean and unit variance.
+ */
+static float gaussian(void)
+{
+    float sum = 0.0;
+    for(int i=0; i<12; i++) sum += rand()/(float)(RAND_MAX);
+    return sum-6.0;
+}
+
+/**
+ * @brief Generates scan of both channels, reflection moves with scan number and differs a little between channels.
+ */
+static void generateScan(float * IR, int scan)
+{
+    for(int ch=0; ch<2; ch++)
+    {
+        double center = 300.0+(scan%200)+ch*7.0;
+        for(int k=0; k<SCANLENGHT; k++)
+        {
+            double shape = (k-center)/5.0;
+            IR[ch*SCANLENGHT+k] = 0.01*gaussian()+0.3*exp(-shape*shape)*sin(k*1.3);
+        }
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    int scans = (argc>1) ? atoi(argv[1]) : 2000;
+
+    mtt_pure * reference = new mtt_pure(MAX_N);
+    mtt_pure * fused = new mtt_pure(MAX_N);
+
+    float * scan = new float[2*SCANLENGHT];
+    float * referenceIR = new float[2*SCANLENGHT];
+    float * fusedIR = new float[2*SCANLENGHT];
+    int * referenceDetections = new int[2*SCANLENGHT];
+    det_map * fusedDetections = new det_map[2];
+
+    qint64 referenceTime = 0;
+    qint64 fusedTime = 0;
+    long samplesDifferent = 0;
+    long detectionsDifferent = 0;
+    long detections = 0;
+    QElapsedTimer timer;
+
+    srand(1);
+    for(int s=0; s<scans; s++)
+    {
+        generateScan(scan, s);
+        memcpy(referenceIR, scan, 2*SCANLENGHT*sizeof(float));
+        memcpy(fusedIR, scan, 2*SCANLENGHT*sizeof(float));
+
+        timer.start();
+        for(int ch=0; ch<2; ch++)
+        {
+            reference->exponential_bg_subtraction(&referenceIR[ch*SCANLENGHT], ch, RAW_BENCH_EXP_FACTOR);
+            reference->detector_cfar(&referenceIR[ch*SCANLENGHT], &referenceDetections[ch*SCANLENGHT], RAW_BENCH_BETA_FAST, RAW_BENCH_BETA_SLOW, RAW_BENCH_ALPHA);
+        }
+        referenceTime += timer.nsecsElapsed();
+
+        timer.start();
+        fused->bg_subtraction_2ch(fusedIR, RAW_BENCH_EXP_FACTOR);
+        fused->detector_cfar_2ch(fusedIR, fusedDetections, RAW_BENCH_BETA_FAST, RAW_BENCH_BETA_SLOW, RAW_BENCH_ALPHA);
+        fusedTime += timer.nsecsElapsed();
+
+        // background subtraction must be bit-identical
+        for(int k=0; k<2*SCANLENGHT; k++)
+            if(memcmp(&referenceIR[k], &fusedIR[k], sizeof(float))!=0) samplesDifferent++;
+
+        // runs of fused detector are expanded and compared with reference detections sample by sample
+        for(int ch=0; ch<2; ch++)
+        {
+            const det_map * map = &fusedDetections[ch];
+            int run = 0;
+            for(int k=0; k<SCANLENGHT; k++)
+            {
+                while(run<map->count && map->run[run].end<=k) run++;
+                int value = (run<map->count && map->run[run].begin<=k) ? map->run[run].value : 0;
+
+                if(value!=referenceDetections[ch*SCANLENGHT+k]) detectionsDifferent++;
+                detections += referenceDetections[ch*SCANLENGHT+k];
+            }
+        }
+    }
+
+    #if defined (MTT_SSE2)
+    const char * path = "SSE2";
+    #else
+    const char * path = "scalar";
+    #endif
+
+    printf("%d scans, fused chain: %s\n", scans, path);
+    printf("background subtraction: %ld different samples\n", samplesDifferent);
+    printf("CFAR detections: %ld different samples of %ld detected (filter tolerance %g relative)\n", detectionsDifferent, detections, CFAR_2CH_TOLERANCE);
+    printf("latency per scan (both channels): reference %.1f us, fused %.1f us\n", referenceTime/1000.0/scans, fusedTime/1000.0/scans);
+
+    delete reference;
+    delete fused;
+    delete [] scan;
+    delete [] referenceIR;
+    delete [] fusedIR;
+    delete [] referenceDetections;
+    delete [] fusedDetections;
+
+    return (samplesDifferent==0 && detectionsDifferent==0) ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+# Equivalence and latency of raw impulse response detection
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+TARGET = rawdetection
+CONFIG   += console
+CONFIG   -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+# scalar form of fused chain is measured by building with DEFINES+=MTT_NO_SSE2
+
+SOURCES += main.cpp \
+    ../../mtt_pure.cpp \
+    ../../batchlocalization.cpp \
+    ../../mttsnapshot.cpp \
+    ../../targetcapacity.cpp
@@ -0,0 +1,224 @@
+/**
+ * @file main.cpp
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Verification and timing of spatial fusion.
+ *
+ * @section DESCRIPTION
+ *
+ * First part generates random frames (1 up to 50 radars, 1 up to 10 targets, some detections missing)
+ * and compares result of 'spatialFusion::fuse' with naive O(n^2) reference using the same rules: two
+ * positions of different radars closer than merge radius belong to the same cluster. Number of clusters,
+ * their sizes and centroids must match. Second part measures time of 50 radars x 10 targets frame
+ * against the reference and time of large uniformly distributed frames.
+ *
+ * Usage: spatialfusion [frames]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <QElapsedTimer>
+
+#include "spatialfusion.h"
+
+#define SF_BENCH_RADARS     (50)        ///< Number of radars in timed frame
+#define SF_BENCH_TARGETS    (10)        ///< Number of targets in timed frame
+#define SF_BENCH_ITERATIONS (20000)     ///< Number of repetitions of timed frame
+#define SF_BENCH_NAIVE_ITERATIONS (200) ///< Number of repetitions of timed frame for reference
+
+/**
+ * @brief Returns uniformly distributed random number from interval <0, 1>.
+ */
+static float uniform(void)
+{
+    return rand()/(float)(RAND_MAX);
+}
+
+/**
+ * @brief Finds root of position in union-find forest.
+ */
+static int findRoot(int * parent, int i)
+{
+    while(parent[i]!=i) i = parent[i];
+    return i;
+}
+
+/**
+ * @brief Naive reference, fills cluster with index of the lowest position of the same cluster.
+ */
+static void naiveFusion(float * x, float * y, int * radar, int n, float radius, int * cluster)
+{
+    for(int i=0; i<n; i++) cluster[i] = i;
+
+    for(int i=0; i<n; i++)
+    {
+        for(int j=i+1; j<n; j++)
+        {
+            if(radar[i]==radar[j]) continue;
+
+            float dx = x[i]-x[j];
+            float dy = y[i]-y[j];
+            if(dx*dx+dy*dy>radius*radius) continue;
+
+            int a = findRoot(cluster, i);
+            int b = findRoot(cluster, j);
+            if(a<b) cluster[b] = a;
+            else if(b<a) cluster[a] = b;
+        }
+    }
+
+    for(int i=0; i<n; i++) cluster[i] = findRoot(cluster, i);
+}
+
+/**
+ * @brief Compares random frames with reference.
+ * @return Number of frames with different result.
+ */
+static int verifyFrames(int frames)
+{
+    int capacity = SF_BENCH_RADARS*SF_BENCH_TARGETS;
+    float * x = new float[capacity];
+    float * y = new float[capacity];
+    int * radar = new int[capacity];
+    int * cluster = new int[capacity];
+    float * positions = new float[capacity*2];
+    int * sizes = new int[capacity];
+    float tx[SF_BENCH_TARGETS], ty[SF_BENCH_TARGETS];
+
+    int mismatches = 0;
+    srand(1);
+    for(int frame=0; frame<frames; frame++)
+    {
+        // small initial capacity, so growing of storage is verified too
+        spatialFusion fusion(0.1+(rand()%10)*0.1, 4);
+
+        int radars = 1+rand()%SF_BENCH_RADARS;
+        int targets = 1+rand()%SF_BENCH_TARGETS;
+        float extent = (rand()%3==0) ? 0.5 : 20.0; // dense frames join targets too
+
+        for(int k=0; k<targets; k++)
+        {
+            tx[k] = uniform()*extent;
+            ty[k] = uniform()*extent;
+        }
+
+        int n = 0;
+        for(int r=0; r<radars; r++)
+        {
+            for(int k=0; k<targets; k++)
+            {
+                if(rand()%5==0) continue; // missed detection
+
+                x[n] = tx[k]+(uniform()-0.5)*0.2;
+                y[n] = ty[k]+(uniform()-0.5)*0.2;
+                radar[n] = r+1;
+                fusion.addPosition(radar[n], x[n], y[n]);
+                n++;
+            }
+        }
+
+        int count = fusion.fuse(positions, sizes);
+        naiveFusion(x, y, radar, n, fusion.getMergeRadius(), cluster);
+
+        // clusters are emitted in order of their lowest position
+        int k = 0;
+        bool match = true;
+        for(int i=0; i<n && match; i++)
+        {
+            if(cluster[i]!=i) continue;
+
+            double sx = 0.0, sy = 0.0;
+            int members = 0;
+            for(int j=i; j<n; j++)
+            {
+                if(cluster[j]!=i) continue;
+                sx += x[j];
+                sy += y[j];
+                members++;
+            }
+
+            if(k>=count || sizes[k]!=members || fabs(sx/members-positions[2*k])>1e-4 || fabs(sy/members-positions[2*k+1])>1e-4) match = false;
+            k++;
+        }
+        if(k!=count) match = false;
+
+        if(!match) mismatches++;
+    }
+
+    delete [] x;
+    delete [] y;
+    delete [] radar;
+    delete [] cluster;
+    delete [] positions;
+    delete [] sizes;
+
+    return mismatches;
+}
+
+/**
+ * @brief Measures 50 radars x 10 targets frame and large random frames.
+ */
+static void timeFrames(void)
+{
+    const int n = SF_BENCH_RADARS*SF_BENCH_TARGETS;
+    float x[n], y[n], positions[n*2];
+    int radar[n], cluster[n], sizes[n];
+
+    for(int i=0; i<n; i++)
+    {
+        int k = i%SF_BENCH_TARGETS;
+        x[i] = -5.0+k*1.1+(uniform()-0.5)*0.2;
+        y[i] = 2.0+(k%3)*1.7+(uniform()-0.5)*0.2;
+        radar[i] = i/SF_BENCH_TARGETS+1;
+    }
+
+    spatialFusion fusion;
+    QElapsedTimer timer;
+    int count = 0;
+
+    timer.start();
+    for(int it=0; it<SF_BENCH_ITERATIONS; it++)
+    {
+        fusion.clear();
+        for(int i=0; i<n; i++) fusion.addPosition(radar[i], x[i], y[i]);
+        count = fusion.fuse(positions, sizes);
+    }
+    double fused = timer.nsecsElapsed()/1000.0/SF_BENCH_ITERATIONS;
+
+    timer.start();
+    for(int it=0; it<SF_BENCH_NAIVE_ITERATIONS; it++) naiveFusion(x, y, radar, n, fusion.getMergeRadius(), cluster);
+    double naive = timer.nsecsElapsed()/1000.0/SF_BENCH_NAIVE_ITERATIONS;
+
+    printf("%d radars x %d targets: %d clusters, %.1f us per frame, naive %.1f us per frame\n",
+           SF_BENCH_RADARS, SF_BENCH_TARGETS, count, fused, naive);
+
+    const int large[] = { 5000, 50000 };
+    for(unsigned int l=0; l<sizeof(large)/sizeof(large[0]); l++)
+    {
+        int size = large[l];
+        spatialFusion uniformFusion;
+        for(int i=0; i<size; i++) uniformFusion.addPosition(i%SF_BENCH_RADARS+1, uniform()*size*0.05, uniform()*size*0.05);
+
+        float * output = new float[size*2];
+        timer.start();
+        int clusters = uniformFusion.fuse(output, NULL);
+        double elapsed = timer.nsecsElapsed()/1000.0;
+        delete [] output;
+
+        printf("n=%d uniform: %d clusters, %.1f us\n", size, clusters, elapsed);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    int frames = (argc>1) ? atoi(argv[1]) : 2000;
+
+    int mismatches = verifyFrames(frames);
+    printf("reference comparison: %d mismatches in %d frames\n", mismatches, frames);
+
+    timeFrames();
+
+    return (mismatches==0) ? 0 : 1;
+}
@@ -0,0 +1,18 @@
+#-------------------------------------------------
+#
+# Verification and benchmark of spatial fusion
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+TARGET = spatialfusion
+CONFIG   += console
+CONFIG   -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp \
+    ../../spatialfusion.cpp
@@ -90,15 +90,37 @@ dataInputDialog::dataInputDialog(uwbSettings * setts, QMutex * settings_mutex, Q
     if(index>=0) ui->recieverSerialBaudRateComboBox->setCurrentIndex(index);
     else ui->recieverSerialBaudRateComboBox->setCurrentIndex(6); // 9600 baud by default (change this as well if adding new items into combobox)
 
+    // raw impulse responses may be read from recorded file or from server
+    ui->recieverRawIRSourceTypeComboBox->addItem(tr("File"), RAW_IR_FILE);
+    ui->recieverRawIRSourceTypeComboBox->addItem(tr("TCP socket"), RAW_IR_SOCKET);
+    ui->recieverRawIRSourceTypeComboBox->setCurrentIndex(ui->recieverRawIRSourceTypeComboBox->findData(settings->getRawIRSourceType()));
+    ui->recieverRawIRSourceLineEdit->setText(settings->getRawIRSource());
+
+    // recorded file may be replayed in real time, faster or as fast as possible
+    ui->recieverReplayFileLineEdit->setText(settings->getReplayFile());
+    ui->recieverReplaySpeedSpinBox->setValue(settings->getReplaySpeed());
+
     // load the reciever method and check correct radio button. If RS232 method is not set, disabe changing baudrates and COM ports
     reciever_method temp_method = settings->getRecieverMethod();
     ui->recieverSerialWidget->setDisabled(true); // initially disable com port settings
+    ui->recieverRawIRWidget->setDisabled(true); // the same for raw impulse response source
+    ui->recieverReplayWidget->setDisabled(true); // and replayed file
 
     if(temp_method==RS232)
     {
         ui->methodSerialRadioButton->setChecked(true);
         ui->recieverSerialWidget->setDisabled(false);
     }
+    else if(temp_method==RAW_IR)
+    {
+        ui->methodRawIRRadioButton->setChecked(true);
+        ui->recieverRawIRWidget->setDisabled(false);
+    }
+    else if(temp_method==REPLAY)
+    {
+        ui->methodReplayRadioButton->setChecked(true);
+        ui->recieverReplayWidget->setDisabled(false);
+    }
     else if(temp_method==SYNTHETIC)
     {
         #if defined (__linux__) || defined (__FreeBSD__)
@@ -131,6 +153,8 @@ void dataInputDialog::accepted()
     settingsMutex->lock();
 
     if(ui->methodSerialRadioButton->isChecked()) settings->setRecieverMethod(RS232);
+    else if(ui->methodRawIRRadioButton->isChecked()) settings->setRecieverMethod(RAW_IR);
+    else if(ui->methodReplayRadioButton->isChecked()) settings->setRecieverMethod(REPLAY);
     #if defined (__WIN32__)
     else if(ui->methodSyntheticRadioButton->isChecked()) settings->setRecieverMethod(SYNTHETIC);
     #endif
@@ -150,6 +174,12 @@ void dataInputDialog::accepted()
 
     settings->setComPortName(port_name_str);
 
+    settings->setRawIRSourceType((raw_ir_source)(ui->recieverRawIRSourceTypeComboBox->currentData().toInt()));
+    settings->setRawIRSource(ui->recieverRawIRSourceLineEdit->text());
+
+    settings->setReplayFile(ui->recieverReplayFileLineEdit->text());
+    settings->setReplaySpeed(ui->recieverReplaySpeedSpinBox->value());
+
     settingsMutex->unlock();
 
     qDebug() << "Setting up new reciever method. Please restart the input thread to apply changes.";
@@ -159,4 +189,7 @@ void dataInputDialog::methodSelectionChangedSlot(QAbstractButton *button)
 {
     if(button==ui->methodSerialRadioButton) ui->recieverSerialWidget->setDisabled(false);
     else  ui->recieverSerialWidget->setDisabled(true);
+
+    ui->recieverRawIRWidget->setDisabled(button!=ui->methodRawIRRadioButton);
+    ui->recieverReplayWidget->setDisabled(button!=ui->methodReplayRadioButton);
 }
@@ -36,13 +36,17 @@ dataInputThreadWorker::dataInputThreadWorker(QVector<rawData *> *raw_data_stack,
     stoppedMutex = new QMutex;
     stoppedCheckMutex = new QMutex;
 
+    captureWriter = NULL;
+    captureThread = NULL;
 
     // create approprate reciever -> need to choose appropriate constructor
     settingsMutex->lock();
-    if(settings->getRecieverMethod()==RS232) recieverHandler = new reciever(settings->getRecieverMethod(), settings->getComPortName(), settings->getComPortBaudRate(), settings->getComPortMode());
+    if(settings->getRecieverMethod()==RS232) recieverHandler = new reciever(settings->getRecieverMethod(), settings->getComPortName(), settings->getComPortBaudRate(), settings->getComPortMode(), settings->getTargetCapacity());
     #if defined (__WIN32__)
-    else if(settings->getRecieverMethod()==SYNTHETIC) recieverHandler = new reciever(settings->getRecieverMethod());
+    else if(settings->getRecieverMethod()==SYNTHETIC) recieverHandler = new reciever(settings->getRecieverMethod(), settings->getTargetCapacity());
     #endif
+    else if(settings->getRecieverMethod()==RAW_IR) recieverHandler = new reciever(settings->getRecieverMethod(), settings->getRawIRSourceType(), settings->getRawIRSource(), settings->getIRDetectionParameters(), settings->getTargetCapacity());
+    else if(settings->getRecieverMethod()==REPLAY) recieverHandler = new reciever(settings->getRecieverMethod(), settings->getReplayFile(), settings->getReplaySpeed(), settings->getTargetCapacity());
     else recieverHandler = new reciever(UNDEFINED);
     settingsMutex->unlock();
 
@@ -69,6 +73,9 @@ void dataInputThreadWorker::runWorker()
     unsigned int idle;
     unsigned int maxErrorCount;
 
+    // each recieving session has own capture file
+    startMeasurementCapture();
+
     forever
     {
         stoppedMutex->lock();
@@ -111,6 +118,12 @@ void dataInputThreadWorker::runWorker()
                 usleep(idle*1000);
                 #endif
             }
+            else if(recieverHandler->curr_method_code()==REPLAY && recieverHandler->replay_finished())
+            {
+                // all recorded data were fed, that is not an error and nothing more will come, so thread sleeps until it is stopped
+                qDebug() << recieverHandler->check_status_message();
+                waitUntilStopped();
+            }
             else
             {
                 // if no UNDEFINED, the current method is probably corrupted
@@ -137,14 +150,22 @@ void dataInputThreadWorker::runWorker()
         else
         {
             // everything is OK, we can now get new data
+            // data are captured before processing, which changes coordinates in place
+            if(captureWriter!=NULL) captureWriter->push(dataTempPointer);
+
             rawDataStackMutex->lock();
             qDebug() << "Appending";
             rawDataStack->append(dataTempPointer);
             rawDataStackMutex->unlock();
             errorCounter = 0;
+
+            // recorded data can wait, so unthrottled replay measures throughput of processing instead of filling the stack
+            if(recieverHandler->curr_method_code()==REPLAY) waitForStack();
         }
     }
 
+    stopMeasurementCapture();
+
     // inform higher classes that the loop is finished
     stoppedCheckMutex->lock();
     stoppedCheck = true;
@@ -184,6 +205,14 @@ void dataInputThreadWorker::stopWorker()
     stoppedMutex->lock();
     stopped = true;
     stoppedMutex->unlock();
+
+    // paced replay may sleep until distant record is due
+    recieverHandler->cancel_replay();
+
+    // wake thread sleeping in 'waitUntilStopped'
+    pauseMutex->lock();
+    pause->wakeAll();
+    pauseMutex->unlock();
 }
 
 void dataInputThreadWorker::releaseIfInPauseState()
@@ -198,3 +227,78 @@ void dataInputThreadWorker::releaseIfInPauseState()
     pauseMutex->unlock();
 }
 
+void dataInputThreadWorker::waitForStack()
+{
+    forever
+    {
+        stoppedMutex->lock();
+        bool stop = stopped;
+        stoppedMutex->unlock();
+        if(stop) return;
+
+        rawDataStackMutex->lock();
+        int count = rawDataStack->count();
+        rawDataStackMutex->unlock();
+        if(count<REPLAY_STACK_LIMIT) return;
+
+        QThread::msleep(1);
+    }
+}
+
+void dataInputThreadWorker::waitUntilStopped()
+{
+    pauseMutex->lock();
+    forever
+    {
+        stoppedMutex->lock();
+        bool stop = stopped;
+        stoppedMutex->unlock();
+        if(stop) break;
+
+        // 'stopWorker' needs pause mutex to wake thread, so stopping can not be missed between check and wait
+        pause->wait(pauseMutex);
+    }
+    pauseMutex->unlock();
+}
+
+void dataInputThreadWorker::startMeasurementCapture()
+{
+    settingsMutex->lock();
+    // replayed data are recorded already, capture could even overwrite the replayed file
+    bool captureIsEnabled = settings->getMeasurementCaptureEnabled() && settings->getRecieverMethod()!=REPLAY;
+    QString filePath(settings->getDiskBackupFilePath());
+    filePath.append(QString("//%1_measurements.bin").arg(settings->getBackupFileName()));
+    settingsMutex->unlock();
+
+    if(!captureIsEnabled) return;
+
+    captureWriter = new measurementCapture(filePath);
+    if(!captureWriter->open())
+    {
+        delete captureWriter;
+        captureWriter = NULL;
+        return;
+    }
+
+    captureThread = new QThread;
+    connect(captureWriter, SIGNAL(finished()), captureThread, SLOT(quit()), Qt::DirectConnection);
+
+    captureWriter->moveToThread(captureThread);
+    captureThread->start(QThread::LowPriority);
+    QMetaObject::invokeMethod(captureWriter, "runWorker", Qt::QueuedConnection);
+}
+
+void dataInputThreadWorker::stopMeasurementCapture()
+{
+    if(captureWriter==NULL) return;
+
+    // writer stores all pushed measurements and closes the file before the thread quits
+    captureWriter->stopWorker();
+    captureThread->wait();
+
+    delete captureWriter;
+    delete captureThread;
+
+    captureWriter = NULL;
+    captureThread = NULL;
+}
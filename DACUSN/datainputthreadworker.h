@@ -20,6 +20,7 @@
 #include <QList>
 #include <QMutex>
 #include <QWaitCondition>
+#include <QThread>
 
 #include <QDebug>
 
@@ -27,6 +28,7 @@
 #include "reciever.h"
 #include "rawdata.h"
 #include "uwbsettings.h"
+#include "measurementcapture.h"
 
 class dataInputThreadWorker : public QObject
 {
@@ -67,7 +69,7 @@ public:
     bool checkStoppedStatus(void);
 
     /**
-     * @brief This function will only set the boolean 'stopped' value to true, what leads in break of infinite loop
+     * @brief This function will set the boolean 'stopped' value to true, what leads in break of infinite loop, and wakes the thread if it sleeps at the end of replayed file or waits for the next replayed record
      */
     void stopWorker(void);
 
@@ -103,6 +105,29 @@ private:
     QMutex * stoppedMutex; ///< Lock mutex for stopped condition.
     QMutex * stoppedCheckMutex; ///< Lock mutex for check boolean value.
 
+    measurementCapture * captureWriter; ///< Capture of recieved measurements, NULL if capture is disabled
+    QThread * captureThread; ///< Thread where 'captureWriter' writes the file
+
+    /**
+     * @brief Creates capture file next to disk backup and starts its writer thread if capture is enabled in settings.
+     */
+    void startMeasurementCapture(void);
+
+    /**
+     * @brief Waits until all captured measurements are written, then deletes capture writer and its thread.
+     */
+    void stopMeasurementCapture(void);
+
+    /**
+     * @brief Waits while stack holds REPLAY_STACK_LIMIT or more objects or until thread is stopped. Used for replayed data only.
+     */
+    void waitForStack(void);
+
+    /**
+     * @brief Sleeps until thread is stopped. Used when the end of replayed file was reached.
+     */
+    void waitUntilStopped(void);
+
 signals:
     /**
      * @brief This signal is emitted when object leaves its infinite loop in runWorker() method
@@ -0,0 +1,108 @@
+/**
+ * @file framebuffer.cpp
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Definitions of frameBuffer class methods.
+ *
+ * @section DESCRIPTION
+ *
+ * Writer and reader own one frame each and exchange it with the middle one. The middle index carries
+ * a flag telling whether the middle frame was published after the reader took its frame, so the reader
+ * swaps only if there is something new and never gets older frame than it already has.
+ *
+ */
+
+#include "framebuffer.h"
+
+#define FRAME_BUFFER_FRESH      (4)     ///< Flag added to middle index when new frame is published
+
+frameBuffer::frameBuffer(int capacity)
+{
+    if(capacity<1) capacity = 1;
+
+    for(int i=0; i<3; i++)
+    {
+        frames[i].positions = NULL;
+        frames[i].ids = NULL;
+        frames[i].count = 0;
+        frames[i].capacity = 0;
+        frames[i].timestamp = 0;
+        frames[i].sequence = 0;
+
+        reserve(&frames[i], capacity);
+    }
+
+    back = 0;
+    middle.storeRelease(1);
+    front = 2;
+
+    sequence = 0;
+}
+
+frameBuffer::~frameBuffer()
+{
+    for(int i=0; i<3; i++)
+    {
+        delete [] frames[i].positions;
+        delete [] frames[i].ids;
+    }
+}
+
+visualization_frame *frameBuffer::beginFrame()
+{
+    frames[back].count = 0;
+    return &frames[back];
+}
+
+void frameBuffer::append(float x, float y, int id)
+{
+    visualization_frame * frame = &frames[back];
+
+    if(frame->count>=frame->capacity) reserve(frame, 2*frame->capacity);
+
+    frame->positions[frame->count*2] = x;
+    frame->positions[frame->count*2+1] = y;
+    frame->ids[frame->count] = id;
+    frame->count++;
+}
+
+void frameBuffer::publish(qint64 timestamp)
+{
+    frames[back].timestamp = timestamp;
+    frames[back].sequence = ++sequence;
+
+    // release ordering makes the frame content visible before its index
+    back = middle.fetchAndStoreOrdered(back | FRAME_BUFFER_FRESH) & ~FRAME_BUFFER_FRESH;
+}
+
+const visualization_frame *frameBuffer::latest()
+{
+    if(middle.loadAcquire() & FRAME_BUFFER_FRESH)
+    {
+        // reader gives its old frame back to writer through middle
+        front = middle.fetchAndStoreOrdered(front) & ~FRAME_BUFFER_FRESH;
+    }
+
+    return &frames[front];
+}
+
+void frameBuffer::reserve(visualization_frame *frame, int capacity)
+{
+    if(capacity<=frame->capacity) return;
+
+    float * positions = new float[capacity*2];
+    int * ids = new int[capacity];
+
+    if(frame->count>0)
+    {
+        memcpy(positions, frame->positions, frame->count*2*sizeof(float));
+        memcpy(ids, frame->ids, frame->count*sizeof(int));
+    }
+
+    delete [] frame->positions;
+    delete [] frame->ids;
+
+    frame->positions = positions;
+    frame->ids = ids;
+    frame->capacity = capacity;
+}
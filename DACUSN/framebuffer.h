@@ -0,0 +1,100 @@
+/**
+ * @file framebuffer.h
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Triple buffer passing the latest fused frame from stack manager to rendering.
+ *
+ * @section DESCRIPTION
+ *
+ * Stack manager produces one frame of target positions after each fusion and GUI timer renders the
+ * newest frame at its own rate. The 'frameBuffer' object holds three preallocated frames: the one being
+ * written, the one being rendered and the latest published one. Publishing and reading swap frame
+ * indexes by one atomic operation, so neither thread ever waits for the other, the reader always
+ * gets complete frame and no memory is allocated per target (arrays grow only if more targets than
+ * ever before are written).
+ *
+ * There must be only one writing thread and only one reading thread for each buffer.
+ *
+ */
+
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <string.h>
+#include <QtGlobal>
+#include <QAtomicInt>
+
+#include "stddefs.h"
+
+/**
+ * @brief The 'visualization_frame' structure holds positions of all targets of one fusion output.
+ */
+struct visualization_frame {
+    float * positions; ///< Array of [x, y] positions in meters
+    int * ids; ///< Identifier of each target, used for selection of color
+    int count; ///< Number of targets
+    int capacity; ///< Number of targets arrays are allocated for
+    qint64 timestamp; ///< Time of fusion in milliseconds since epoch
+    quint64 sequence; ///< Number of frame, 0 if nothing was published yet
+};
+
+class frameBuffer
+{
+public:
+    /**
+     * @brief Creates buffer with three empty frames.
+     * @param[in] capacity Number of targets each frame is prepared for.
+     */
+    frameBuffer(int capacity = MAX_N);
+    ~frameBuffer();
+
+    /**
+     * @brief Starts new frame. Called by writing thread only.
+     * @return Frame which is not accessible by reader until 'publish' is called, count is reset to 0.
+     */
+    visualization_frame * beginFrame(void);
+
+    /**
+     * @brief Appends target to the frame started by 'beginFrame'. Called by writing thread only.
+     * @param[in] x X coordinate in meters.
+     * @param[in] y Y coordinate in meters.
+     * @param[in] id Identifier of target.
+     */
+    void append(float x, float y, int id);
+
+    /**
+     * @brief Makes the frame started by 'beginFrame' the latest frame. Called by writing thread only.
+     * @param[in] timestamp Time of fusion in milliseconds since epoch.
+     */
+    void publish(qint64 timestamp);
+
+    /**
+     * @brief Returns the latest published frame. Called by reading thread only.
+     * @return Frame which stays unchanged until the next call of this function.
+     */
+    const visualization_frame * latest(void);
+
+    /**
+     * @brief Returns the frame returned by the last call of 'latest' without taking newer one. Called by reading thread only.
+     * @return Frame currently owned by reader.
+     */
+    const visualization_frame * current(void) { return &frames[front]; }
+
+private:
+    visualization_frame frames[3]; ///< Frames for writer, reader and the latest published one
+
+    int back; ///< Frame owned by writer
+    int front; ///< Frame owned by reader
+    QAtomicInt middle; ///< Latest published frame, FRAME_BUFFER_FRESH bit is set until reader takes it
+
+    quint64 sequence; ///< Number of the last published frame
+
+    /**
+     * @brief Reallocates arrays of frame, stored targets are kept.
+     * @param[in] frame Frame to grow.
+     * @param[in] capacity New number of targets.
+     */
+    void reserve(visualization_frame * frame, int capacity);
+};
+
+#endif // FRAMEBUFFER_H
@@ -81,7 +81,7 @@ MainWindow::MainWindow(QWidget *parent) :
     radarSubWindowListMutex = new QMutex;
     radarListMutex = new QMutex;
 
-    visualizationData = new QList<QPointF * >;
+    visualizationData = new frameBuffer;
     visualizationColor = new QList<QColor * >;
     // preparing some basic color set for targets
     visualizationColor->append(new QColor(Qt::red));
@@ -96,6 +96,10 @@ MainWindow::MainWindow(QWidget *parent) :
     visualizationColor->append(new QColor(Qt::darkBlue));
     visualizationDataMutex = new QMutex;
 
+    mttSnapshots = new QMap<unsigned int, mttSnapshot * >;
+    mttSnapshotsMutex = new QMutex;
+    mttStatesLoaded = false;
+
     lastKnownSchema = settings->getVisualizationSchema();
 
     this->setWindowTitle(tr("Centrum asociácie dát v UWB sensorovej sieti"));
@@ -134,6 +138,9 @@ MainWindow::MainWindow(QWidget *parent) :
 
     /* ------------------------------------------------- STACK MANAGER ------------------------------------------- */
 
+    backupWriterThread = NULL;
+    backupWriterWorker = NULL;
+
     /* ------------------------------------------------- VISUALIZATION ------------------------------------------- */
 
     averageRenderTime = renderIterationCount = 0;
@@ -149,7 +156,7 @@ MainWindow::MainWindow(QWidget *parent) :
 
     ui->radarViewLayout->addWidget(visualizationView, 0, 0);
 
-    visualizationManager = new animationManager(visualizationScene, visualizationView, visualizationData, visualizationColor, visualizationDataMutex, settings, settingsMutex);
+    visualizationManager = new animationManager(visualizationScene, visualizationView, visualizationData, visualizationColor, settings, settingsMutex);
     connect(this, SIGNAL(gridScaleValueUpdate(double)), visualizationManager, SLOT(updateObjectsScales(double)));
 
     connect(visualizationTimer, SIGNAL(timeout()), this, SLOT(visualizationSlot()));
@@ -224,9 +231,28 @@ void MainWindow::closeEvent(QCloseEvent *event)
 
 MainWindow::~MainWindow()
 {
+    // stack manager saves MTT states when it leaves its cycle, so we need to wait for it before states are written to disk
+    QThread * lastStackManagerThread = stackManagerThread;
+
     // if some of data recieving is still runnning, stopping it
     this->destroyDataInputThreadSlot();
 
+    // states must not be written or deleted while worker may still save them
+    if(lastStackManagerThread!=NULL) lastStackManagerThread->wait();
+
+    // backup may be running even if data recieving was not started (enabled from backup dialog)
+    deleteDiskBackupDependencies();
+
+    settingsMutex->lock();
+    bool mttPersistent = settings->getMTTWarmStart() && settings->getMTTStatePersistent();
+    settingsMutex->unlock();
+    if(mttPersistent) saveMTTStatesToFile();
+
+    mttSnapshotsMutex->lock();
+    qDeleteAll(*mttSnapshots);
+    mttSnapshots->clear();
+    mttSnapshotsMutex->unlock();
+
     // destroy all subwindows if exist
     radarSubWindowListMutex->lock();
     while(!radarSubWindowList->isEmpty())
@@ -311,7 +337,9 @@ void MainWindow::restartDataInputSlot()
 void MainWindow::establishDataInputThreadSlot()
 {
     settingsMutex->lock();
-    if (settings->getRecieverMethod() == RS232 && settings->getComPortName() == NULL)
+    if ((settings->getRecieverMethod() == RS232 && settings->getComPortName() == NULL) ||
+        (settings->getRecieverMethod() == RAW_IR && settings->getRawIRSource().isEmpty()) ||
+        (settings->getRecieverMethod() == REPLAY && settings->getReplayFile().isEmpty()))
     {
         settingsMutex->unlock();
         this->openDataInputDialog();
@@ -335,8 +363,19 @@ void MainWindow::establishDataInputThreadSlot()
 
     // Restart all MTTs since targets could be removed, replaced in the scene,
     // or new can appear, old values of MTT can lead to incorrect results. (tested)
+    // If warm start is enabled, stack manager restores saved states right after it starts.
     resetAllMTTs();
 
+    settingsMutex->lock();
+    bool mttPersistent = settings->getMTTWarmStart() && settings->getMTTStatePersistent();
+    settingsMutex->unlock();
+    if(mttPersistent && !mttStatesLoaded)
+    {
+        // states from the previous application run are read only once
+        loadMTTStatesFromFile();
+        mttStatesLoaded = true;
+    }
+
     // start data recieving thread
     establishDataInputRutineSlot();
 
@@ -428,10 +467,11 @@ void MainWindow::establishStackManagementThread()
     qDebug() << "Starting stack management thread...";
 
     stackManagerThread = new QThread(this);
-    stackManagerWorker = new stackManager(dataStack, dataStackMutex, radarList, radarListMutex, visualizationData, visualizationColor, radarSubWindowList, radarSubWindowListMutex, visualizationDataMutex, settings, settingsMutex);
+    stackManagerWorker = new stackManager(dataStack, dataStackMutex, radarList, radarListMutex, visualizationData, visualizationColor, visualizationDataMutex, settings, settingsMutex, mttSnapshots, mttSnapshotsMutex);
 
     // signals for safe deletion after thread has finished
-    connect(stackManagerWorker, SIGNAL(finished()), stackManagerThread, SLOT(quit()));
+    // quit is called directly from worker thread, so destructor blocked in 'wait' does not need GUI event loop to deliver it
+    connect(stackManagerWorker, SIGNAL(finished()), stackManagerThread, SLOT(quit()), Qt::DirectConnection);
     connect(stackManagerWorker, SIGNAL(finished()), stackManagerWorker, SLOT(deleteLater()));
     connect(stackManagerThread, SIGNAL(finished()), stackManagerThread, SLOT(deleteLater()));
 
@@ -845,9 +885,8 @@ void MainWindow::informationTableUpdateSlot()
     // MECHANISM WE DO NOT NEED USE MUTEXES HERE.
     ui->averageRenderTimeLabel->setText(QString("%1").arg(averageRenderTime));
 
-    visualizationDataMutex->lock();
-    ui->targetsCountLabel->setText(QString("%1").arg(visualizationData->count()));
-    visualizationDataMutex->unlock();
+    // frame taken by the last 'visualizationSlot()', buffer is not advanced here so newer frame is left for rendering
+    ui->targetsCountLabel->setText(QString("%1").arg(visualizationManager->renderedFrame()->count));
 
     // we do not have to use mutexes since it is done in 'getAverageProcessingSpeed()' method
     ui->averageProcessingTimeLabel->setText(QString("%1").arg(stackManagerWorker->getAverageProcessingSpeed()));
@@ -923,28 +962,52 @@ QString MainWindow::timeToString(qint64 timems)
 
 void MainWindow::manageDiskBackupSlot()
 {
-    // if data backup is enabled we need to open/create file in write in mode and prepare QTextStream object
+    // if data backup is enabled we need to create binary backup file and start writer thread
     settingsMutex->lock();
     bool backupIsEnabled = settings->getDiskBackupEnabled();
+    bool backupIsCompressed = settings->getDiskBackupCompressed();
+    unsigned int backupQuantum = settings->getDiskBackupQuantum();
+    QString filePath(settings->getDiskBackupFilePath());
+    filePath.append(QString("//%1.bin").arg(settings->getBackupFileName()));
+    // canonical path is empty for file which does not exist, so only existing replayed file can match
+    QString replayPath = (settings->getRecieverMethod()==REPLAY) ? QFileInfo(settings->getReplayFile()).canonicalFilePath() : QString();
     settingsMutex->unlock();
 
-    if(backupIsEnabled)
-    {
-        settingsMutex->lock();
-        // if enabled backup, we need to prepare all objects required for writing into file
-        QString filePath(settings->getDiskBackupFilePath());
-        filePath.append(QString("//%1.txt").arg(settings->getBackupFileName()));
-        QFile * backup_file = new QFile(filePath);
-        backup_file->open(QFile::Text | QIODevice::WriteOnly); // if doeas not exist, it will be created
+    bool backupIsReplayed = !replayPath.isEmpty() && QFileInfo(filePath).canonicalFilePath()==replayPath;
 
-        QTextStream * in_file_stream = new QTextStream(backup_file); // since now we can use just this stream object to write into file
+    // previous backup (if any) is finished first, so settings never point to two writers
+    deleteDiskBackupDependencies();
 
-        // saving new objects
-        settings->setBackupFileHandler(in_file_stream);
-        settings->setBackupMainFileHandler(backup_file);
-        settingsMutex->unlock();
+    if(!backupIsEnabled) return;
+
+    // opening writer would truncate the file which is being replayed
+    if(backupIsReplayed)
+    {
+        qDebug() << "Disk backup " << filePath << " is the replayed file, backup is not created.";
+        return;
+    }
+
+    backupWriterWorker = new backupWriter(filePath, backupIsCompressed, backupQuantum);
+    if(!backupWriterWorker->open())
+    {
+        delete backupWriterWorker;
+        backupWriterWorker = NULL;
+        return;
     }
-    else deleteDiskBackupDependencies();
+
+    backupWriterThread = new QThread(this);
+
+    // writer thread is waited for in 'deleteDiskBackupDependencies', so both objects are deleted there
+    connect(backupWriterWorker, SIGNAL(finished()), backupWriterThread, SLOT(quit()), Qt::DirectConnection);
+
+    backupWriterWorker->moveToThread(backupWriterThread);
+    backupWriterThread->start(QThread::LowPriority);
+    QMetaObject::invokeMethod(backupWriterWorker, "runWorker", Qt::QueuedConnection);
+
+    // since now stack manager can push frames into writer
+    settingsMutex->lock();
+    settings->setBackupWriter(backupWriterWorker);
+    settingsMutex->unlock();
 }
 
 void MainWindow::realTimeRecordingChanged(bool status)
@@ -974,21 +1037,22 @@ void MainWindow::gridScaleValueChanged(int m_to_pix_ratio)
 
 void MainWindow::deleteDiskBackupDependencies()
 {
-
+    // stack manager pushes frames only while holding settings mutex, so after this no frame can be pushed into old writer
     settingsMutex->lock();
-    // if file pointers are not NULL, some of previous backup is still pending and we should close the file securely
-    if(settings->getBackupFileHandler()!=NULL)
-    {
-        settings->getBackupFileHandler()->device()->close(); // equivalent to closing MainFileHandler directly.
-        delete settings->getBackupFileHandler();
-        delete settings->getBackupMainFileHandler();
-    }
+    settings->setBackupWriter(NULL);
+    settingsMutex->unlock();
 
-    // now we will set back to NULL so program will cannot use old (unexisting) pointers to files/streams
-    settings->setBackupFileHandler(NULL);
-    settings->setBackupMainFileHandler(NULL);
+    if(backupWriterWorker==NULL) return;
 
-    settingsMutex->unlock();
+    // writer stores all pushed frames and closes the file before the thread quits
+    backupWriterWorker->stopWorker();
+    backupWriterThread->wait();
+
+    delete backupWriterWorker;
+    delete backupWriterThread;
+
+    backupWriterWorker = NULL;
+    backupWriterThread = NULL;
 }
 
 void MainWindow::resetAllMTTs()
@@ -1029,6 +1093,108 @@ void MainWindow::resetMTTat(int id, int index)
 
 
 
+bool MainWindow::saveMTTStatesToFile()
+{
+    settingsMutex->lock();
+    QString path = settings->getMTTStateFilePath();
+    settingsMutex->unlock();
+
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qDebug() << "Cannot open file " << path << " for saving MTT states.";
+        return false;
+    }
+
+    mttSnapshotsMutex->lock();
+
+    // file header: identifier and number of records, each record is radar id, size and serialized snapshot
+    int magic = MTT_SNAPSHOT_MAGIC;
+    int count = mttSnapshots->count();
+    file.write((const char *)(&magic), sizeof(int));
+    file.write((const char *)(&count), sizeof(int));
+
+    QMap<unsigned int, mttSnapshot * >::const_iterator i;
+    for(i = mttSnapshots->constBegin(); i!=mttSnapshots->constEnd(); ++i)
+    {
+        unsigned int id = i.key();
+        int size = i.value()->getSerializedSize();
+        char * buffer = new char[size];
+        i.value()->serialize(buffer);
+
+        file.write((const char *)(&id), sizeof(unsigned int));
+        file.write((const char *)(&size), sizeof(int));
+        file.write(buffer, size);
+
+        delete [] buffer;
+    }
+
+    mttSnapshotsMutex->unlock();
+
+    file.close();
+
+    qDebug() << "MTT states saved to " << path;
+
+    return true;
+}
+
+bool MainWindow::loadMTTStatesFromFile()
+{
+    settingsMutex->lock();
+    QString path = settings->getMTTStateFilePath();
+    settingsMutex->unlock();
+
+    QFile file(path);
+    if(!file.exists() || !file.open(QIODevice::ReadOnly)) return false;
+
+    int magic = 0;
+    int count = 0;
+    int loaded = 0;
+
+    if(file.read((char *)(&magic), sizeof(int))!=sizeof(int) || magic!=MTT_SNAPSHOT_MAGIC ||
+       file.read((char *)(&count), sizeof(int))!=sizeof(int) || count<0)
+    {
+        qDebug() << "File " << path << " does not contain MTT states.";
+        file.close();
+        return false;
+    }
+
+    mttSnapshotsMutex->lock();
+    for(int i=0; i<count; i++)
+    {
+        unsigned int id;
+        int size;
+        if(file.read((char *)(&id), sizeof(unsigned int))!=sizeof(unsigned int)) break;
+        if(file.read((char *)(&size), sizeof(int))!=sizeof(int) || size<=0) break;
+
+        char * buffer = new char[size];
+        if(file.read(buffer, size)!=size)
+        {
+            delete [] buffer;
+            break;
+        }
+
+        mttSnapshot * snapshot = mttSnapshot::deserialize(buffer, size);
+        delete [] buffer;
+        if(snapshot==NULL) continue;
+
+        // states saved during this run are newer than states from file
+        if(mttSnapshots->contains(id)) delete snapshot;
+        else
+        {
+            mttSnapshots->insert(id, snapshot);
+            loaded++;
+        }
+    }
+    mttSnapshotsMutex->unlock();
+
+    file.close();
+
+    qDebug() << loaded << " MTT states loaded from " << path;
+
+    return loaded>0;
+}
+
 /* ------------------------------------------------- DIALOGS SLOTS ------------------------------------------- */
 
 void MainWindow::openDataInputDialog()
@@ -33,6 +33,7 @@
 #include <QImage>
 #include <QGLWidget>
 #include <QElapsedTimer>
+#include <QFileInfo>
 
 
 #include <QDebug>
@@ -52,6 +53,7 @@
 #include "uwbsettings.h"
 #include "datainputthreadworker.h"
 #include "stackmanager.h"
+#include "backupwriter.h"
 #include "radarunit.h"
 #include "radar_handler.h"
 #include "visualization.h"
@@ -74,9 +76,12 @@ public:
     QVector<rawData * > * dataStack; ///< Stack for data recieved by sensor network
     QMutex * dataStackMutex; ///< Mutex protecting dataStack object
 
-    QList<QPointF * > * visualizationData; ///< The final positions of targets
+    frameBuffer * visualizationData; ///< The final positions of targets, written by stack manager and read by visualization manager without locking
     QList<QColor * > * visualizationColor; ///< The colors assigned to all targets
-    QMutex * visualizationDataMutex; ///< Mutex protecting visualization data from being accessed by multiple threads at the same time
+    QMutex * visualizationDataMutex; ///< Mutex protecting color list from being accessed by multiple threads at the same time
+
+    QMap<unsigned int, mttSnapshot * > * mttSnapshots; ///< Saved MTT states of radar units indexed by radar id, global MTT state has id 0
+    QMutex * mttSnapshotsMutex; ///< Mutex protecting mttSnapshots object
 
     radarScene * visualizationScene; ///< Is the scene where all items/objects are rendered on.
     radarView * visualizationView; ///< The view widget where the viewport of 'visualizationScene' will be placed.
@@ -207,7 +212,7 @@ public slots:
     void radarListUpdated(void);
 
     /**
-     * @brief Returns all disk backup dependencies to their initial state. Deletes all objects and close file used for backup.
+     * @brief Returns all disk backup dependencies to their initial state. Waits until writer thread stores all pending frames and closes the backup file, then deletes writer and its thread.
      */
     void deleteDiskBackupDependencies(void);
 
@@ -223,6 +228,18 @@ public slots:
      */
     void resetMTTat(int id, int index = -1);
 
+    /**
+     * @brief Writes all saved MTT states into file specified in settings.
+     * @return The return value is true if file was written successfully.
+     */
+    bool saveMTTStatesToFile(void);
+
+    /**
+     * @brief Loads MTT states from file specified in settings. States are applied when stack manager starts.
+     * @return The return value is true if at least one state was loaded.
+     */
+    bool loadMTTStatesFromFile(void);
+
 protected:
 
     void closeEvent(QCloseEvent *event);
@@ -334,6 +351,9 @@ private:
     stackManager * stackManagerWorker; ///< Object with infinite cycle managing the stack
     QThread * stackManagerThread; ///< Thread where 'stackManagerWorker' object can run
 
+    backupWriter * backupWriterWorker; ///< Object writing disk backup, NULL if backup is not running
+    QThread * backupWriterThread; ///< Thread where 'backupWriterWorker' object runs
+
     QVector<radar_handler * > * radarList; ///< Vector of all availible radars
     QMutex * radarListMutex; ///< Mutex protecting the 'radarList' from multithread access
 
@@ -353,6 +373,8 @@ private:
     qint64 averageRenderTime; ///< Average time from all rendering iterations since the one measurement instance started.
     qint64 renderIterationCount; ///< Holds the information about how many rendering iteration were done so far.
 
+    bool mttStatesLoaded; ///< True if MTT states file was already read (it is read only once, before the first start of data input).
+
 };
 
 #endif // MAINWINDOW_H
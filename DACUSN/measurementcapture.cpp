@@ -0,0 +1,83 @@
+/**
+ * @file measurementcapture.cpp
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Definitions of measurementCapture class methods.
+ *
+ * @section DESCRIPTION
+ *
+ * Records are written exactly as they were pushed, so the default 'ringWriter' writing is used.
+ *
+ */
+
+#include "measurementcapture.h"
+
+measurementCapture::measurementCapture(QString file_path, int queue_size)
+    : ringWriter(file_path, queue_size)
+{
+}
+
+measurementCapture::~measurementCapture()
+{
+    if(file!=NULL) finish();
+}
+
+bool measurementCapture::open()
+{
+    if(!ringWriter::open()) return false;
+
+    capture_file_header header;
+    header.magic = CAPTURE_FILE_MAGIC;
+    header.version = CAPTURE_FILE_VERSION;
+    file->write((const char *)(&header), sizeof(capture_file_header));
+    fileOffset = sizeof(capture_file_header);
+
+    return true;
+}
+
+bool measurementCapture::push(rawData *data)
+{
+    capture_record_header record;
+    const float * coordinates;
+
+    record.sync = CAPTURE_RECORD_SYNC;
+    record.method = data->getRecieverMethod();
+    record.arrival_time = data->getArrivalTime();
+
+    if(data->getRecieverMethod()==SYNTHETIC)
+    {
+        record.radar_id = data->getSyntheticRadarId();
+        record.radar_time = data->getSyntheticTime();
+        record.packet_count = -1;
+        record.count = data->getSyntheticTargetsCount();
+        record.capacity = data->getSyntheticCoordinatesCapacity();
+        coordinates = data->getSyntheticCoordinates();
+    }
+    else
+    {
+        record.radar_id = data->getUwbPacketRadarId();
+        record.radar_time = data->getUwbPacketRadarTime();
+        record.packet_count = data->getUwbPacketPacketNumber();
+        record.count = data->getUwbPacketTargetsCount();
+        record.capacity = data->getUwbPacketCoordinatesCapacity();
+        coordinates = data->getUwbPacketCoordinates();
+    }
+
+    if(coordinates==NULL || record.capacity<0) record.capacity = 0;
+
+    quint32 size = CAPTURE_RECORD_SIZE(record.capacity);
+    quint32 used = sizeof(capture_record_header) + record.capacity*2*sizeof(float);
+    quint32 position;
+
+    if(!reserve(size, &position)) return false;
+
+    put(position, &record, sizeof(capture_record_header));
+    if(record.capacity>0) put(position+sizeof(capture_record_header), coordinates, record.capacity*2*sizeof(float));
+
+    static const char padding[8] = {0};
+    if(size>used) put(position+used, padding, size-used);
+
+    commit(position+size);
+
+    return true;
+}
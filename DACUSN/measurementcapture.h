@@ -0,0 +1,86 @@
+/**
+ * @file measurementcapture.h
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Sequential binary log of all recieved measurements.
+ *
+ * @section DESCRIPTION
+ *
+ * Disk backup contains only fused coordinates, so any change of MTT parameters or fusion can not be
+ * evaluated on recorded data. If capture is enabled, data input thread pushes every recieved 'rawData'
+ * object into 'measurementCapture' before it is placed on the stack (processing changes coordinates
+ * in place). Push only copies the values into lock-free ring of 'ringWriter', file is written by its
+ * own thread.
+ *
+ * File starts with 'capture_file_header'. Each measurement is stored as 'capture_record_header' followed
+ * by 'capacity' [x, y] positions (the whole coordinates array as it is passed to radar unit, including
+ * unused zeroed positions) and padded to multiple of 8 bytes. Measurement time is not stored, radar unit
+ * computes it from radar time and arrival time again, so replayed data are processed the same way.
+ * Native byte order is used.
+ *
+ */
+
+#ifndef MEASUREMENTCAPTURE_H
+#define MEASUREMENTCAPTURE_H
+
+#include <QString>
+
+#include "ringwriter.h"
+#include "rawdata.h"
+
+#define CAPTURE_FILE_MAGIC      (0x534D4344)    ///< "DCMS" identifier at the beginning of capture file
+#define CAPTURE_FILE_VERSION    (1)             ///< Version of capture layout
+#define CAPTURE_RECORD_SYNC     (0x5341454D)    ///< "MEAS" identifier at the beginning of each record
+
+#define CAPTURE_RECORD_SIZE(capacity) ((sizeof(capture_record_header)+(capacity)*2*sizeof(float)+7) & ~((size_t)(7))) ///< Size of record in file including padding
+
+/**
+ * @brief Header of capture file.
+ */
+struct capture_file_header {
+    quint32 magic; ///< Must be equal to CAPTURE_FILE_MAGIC
+    quint32 version; ///< Must be equal to CAPTURE_FILE_VERSION
+};
+
+/**
+ * @brief Header of one captured measurement.
+ */
+struct capture_record_header {
+    quint32 sync; ///< Must be equal to CAPTURE_RECORD_SYNC
+    qint32 method; ///< Reciever method which created data (see 'reciever_method')
+    qint64 arrival_time; ///< Host time of data arrival in milliseconds since epoch
+    double radar_time; ///< Radar time of packet, time of synthetic data for SYNTHETIC method
+    qint32 radar_id; ///< Identifier of radar
+    qint32 packet_count; ///< Packet number, -1 for SYNTHETIC method
+    qint32 count; ///< Number of targets
+    qint32 capacity; ///< Number of [x, y] positions following the header
+};
+
+class measurementCapture : public ringWriter
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Prepares capture. File is not opened until 'open' is called.
+     * @param[in] file_path Path of capture file, existing file is overwritten.
+     * @param[in] queue_size Size of ring buffer in bytes, rounded up to power of two.
+     */
+    measurementCapture(QString file_path, int queue_size = RING_WRITER_QUEUE_SIZE);
+    ~measurementCapture();
+
+    /**
+     * @brief Creates capture file and writes its header. Must be called before writer thread is started.
+     * @return False if file could not be opened.
+     */
+    bool open(void);
+
+    /**
+     * @brief Copies measurement into ring buffer. Never blocks, must be called from one thread at a time.
+     * @param[in] data Recieved data, not modified.
+     * @return False if ring is full and measurement was dropped.
+     */
+    bool push(rawData * data);
+};
+
+#endif // MEASUREMENTCAPTURE_H
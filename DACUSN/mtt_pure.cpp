@@ -14,43 +14,313 @@
 
 #include "mtt_pure.h"
 
-mtt_pure::mtt_pure()
+mtt_pure::mtt_pure(int capacity, mtt_state_model model)
 {
-    start = 1;
+    stateModel = model;
+
+    start = START_MTT_INIT;
     start_ex_av = 0;
+    nn_track = 0;
+    next_ID = 0;
+
+    // raw signal buffers are created only when needed
+    ir = NULL;
+    localization = NULL;
+    sa = NULL;
+
+    // all arrays depending on number of targets are placed in storage object
+    storage = createStorage(capacity);
+    this->capacity = storage->getCapacity();
+
+    Z = storage->Z;
+    Y_p = storage->Y_p;
+    P_p = storage->P_p;
+    K = storage->K;
+    Y_e = storage->Y_e;
+    P_e = storage->P_e;
+    OLGI = storage->OLGI;
+    ID = storage->ID;
+    M = storage->M;
+    MA = storage->MA;
+    C = storage->C;
+    P = storage->P;
+    T = storage->T;
 }
 
 mtt_pure::~mtt_pure()
 {
-    // so far no dynamic allocation was used - returned array will managed by external functions
+    // returned array is managed by external functions, only storage and raw buffers are owned by tracker
+    delete storage;
+    if(ir!=NULL) delete ir;
+    if(localization!=NULL) delete localization;
+    if(sa!=NULL) delete sa;
 }
 
-float *mtt_pure::MTT(float *P_mem, float r[], float q[], float dif_d, float dif_fi, int min_OLGI, int min_NTI)
+void mtt_pure::reset()
 {
-    if(P_mem==NULL) return NULL;
+    // START_MTT_INIT state clears all tracker arrays on the next MTT call, so only the state machine must be rewound
+    // identifiers are not rewound, so tracks started after reset never get identifier of an older track
+    start = START_MTT_INIT;
+    start_ex_av = 0;
+    nn_track = 0;
+
+    // background estimation must not survive the reset, buffers stay allocated
+    if(ir!=NULL) memset(ir, 0, sizeof(ir_buffers));
+    if(sa!=NULL) sa_clear();
+}
+
+mttSnapshot *mtt_pure::saveState()
+{
+    // tracks are stored only while tracking, before that the number of tracks is not initialized
+    int tracks = (start==MTT_TRACK) ? nn_track : 0;
+    if(tracks>capacity) tracks = capacity;
+    if(tracks<0) tracks = 0;
+
+    mttSnapshot * snapshot = new mttSnapshot(tracks);
+    mtt_snapshot_header * h = snapshot->getHeader();
+
+    h->state_model = stateModel;
+    h->fsm_state = start;
+    h->start_im = start_im;
+    h->nn_track = tracks;
+    memcpy(h->NTI, NTI, sizeof(h->NTI));
+    memcpy(h->last_obs, last_obs, sizeof(h->last_obs));
+    memcpy(h->P_init, P_init, sizeof(h->P_init));
+    h->Y_e_2_init = Y_e_2_init;
+    h->Y_e_4_init = Y_e_4_init;
+    memcpy(h->R, R, sizeof(h->R));
+    memcpy(h->Q, Q, sizeof(h->Q));
+
+    for(int track = 0; track<tracks; track++)
+    {
+        memcpy(snapshot->getTrackEstimation(track), &Y_e[track][0], 4*sizeof(real));
+        memcpy(snapshot->getTrackCovariance(track), &P_e[track][0][0], 16*sizeof(real));
+        *snapshot->getTrackOLGI(track) = OLGI[track];
+        *snapshot->getTrackID(track) = ID[track];
+    }
+    h->next_ID = next_ID;
+
+    return snapshot;
+}
+
+bool mtt_pure::restoreState(const mttSnapshot *snapshot)
+{
+    reset();
+
+    if(snapshot==NULL) return false;
+
+    const mtt_snapshot_header * h = snapshot->getHeader();
+    if(h->magic!=MTT_SNAPSHOT_MAGIC || h->version!=MTT_SNAPSHOT_VERSION) return false;
+
+    // states of polar and cartesian filters are not compatible
+    if(h->state_model!=(int)(stateModel)) return false;
 
-    /* FOR TEST PURPOSES ONLY - TESTING IF COVARIANCE MATRIX IS BEING CHANGED DURING ITERATIONS */
-    qDebug() << "Matrix Q: ";
-    for(int i = 0; i<4; i++)
-        qDebug() << Q[0] << " " << Q[1] << Q[2] << " " << Q[3];
+    // snapshot taken before initialization does not carry any state
+    if(h->fsm_state==START_MTT_INIT) return true;
 
-    qDebug() << "Matrix P_p: ";
-    for(int i = 0; i<MAX_N; i++)
+    int tracks = snapshot->getTracksCount();
+    if(tracks>capacity) tracks = capacity;
+
+    memcpy(NTI, h->NTI, sizeof(NTI));
+    memcpy(last_obs, h->last_obs, sizeof(last_obs));
+    memcpy(P_init, h->P_init, sizeof(P_init));
+    Y_e_2_init = h->Y_e_2_init;
+    Y_e_4_init = h->Y_e_4_init;
+    memcpy(R, h->R, sizeof(R));
+    memcpy(Q, h->Q, sizeof(Q));
+
+    memset(OLGI, 0, capacity*sizeof(word));
+    for(int track = 0; track<tracks; track++)
     {
-        for(int j = 0; j<4; j++)
-            qDebug() << P_p[0] << " " << P_p[1] << P_p[2] << " " << P_p[3];
+        memcpy(&Y_e[track][0], snapshot->getTrackEstimation(track), 4*sizeof(real));
+        memcpy(&P_e[track][0][0], snapshot->getTrackCovariance(track), 16*sizeof(real));
+        OLGI[track] = *snapshot->getTrackOLGI(track);
+        ID[track] = *snapshot->getTrackID(track);
     }
+    if(h->next_ID>next_ID) next_ID = h->next_ID;
+
+    start = h->fsm_state;
+    start_im = h->start_im;
+    nn_track = tracks;
+
+    return true;
+}
+
+int mtt_pure::detect(float *IR, const ir_detection_parameters *params, float *P_mem)
+{
+    int k, count;
+    toa_antenna_geometry geometry;
+    ir_buffers * buf = irBuffers();
+
+    detectTOA( IR, params, buf->TOA_mem );
+
+    // positions stay in radar coordinate system, they are transformed later together with coordinates from other inputs
+    geometry.x1 = params->x1;
+    geometry.x2 = params->x2;
+    geometry.xpos = geometry.ypos = geometry.rot_angle = 0;
 
-    qDebug() << "P_mem echo";
-    for(int i = 0;i<MAX_N; i++)
-        qDebug() << i << ". " << P_mem[i*2] << " " << P_mem[i*2+1];
+    if( localization == NULL )
+        localization = new batchLocalization( MAX_N );
+    localization->setRadar( 0, geometry );
+    localization->clear();
+    localization->addTOA( 0, buf->TOA_mem, MAX_N );
+
+    // ill conditioned intersections are dropped
+    count = localization->localize( P_mem, NULL );
+    for( k=count; k<MAX_N; k++ )
+        P_mem[2*k] = P_mem[2*k+1] = 0;
+
+    return count;
+}
+
+int mtt_pure::detectTOA(float *IR, const ir_detection_parameters *params, float *TOA_mem)
+{
+    int count;
+    ir_buffers * buf = irBuffers();
+
+    bg_subtraction_2ch( IR, params->exp_factor );
+    detector_cfar_2ch( IR, buf->det, params->beta_fast, params->beta_slow, params->alpha_det );
+
+    trace_connection( buf->det, &buf->TC, params->t_size, params->min_int, params->m, MAX_N, TOA_mem );
+
+    // TOA_couple stores couples from the beginning of array
+    count = 0;
+    while( count < MAX_N && (TOA_mem[2*count]!=0 || TOA_mem[2*count+1]!=0) )
+        count++;
+
+    return count;
+}
+
+void mtt_pure::setAveraging(int count, int hop)
+{
+    if(count<1) count = 1;
+    if(count>MAX_SA) count = MAX_SA;
+    if(hop<1) hop = 1;
+    if(hop>count) hop = count;
+
+    // without averaging the ring is not needed at all
+    if(sa==NULL && count==1) return;
+    if(sa!=NULL && sa->count==count && sa->hop==hop) return;
+
+    if(sa==NULL) sa = new sa_buffers;
+
+    sa->count = count;
+    sa->hop = hop;
+    sa_clear();
+}
+
+void mtt_pure::sa_clear()
+{
+    sa->filled = 0;
+    sa->next = 0;
+    sa->since_output = 0;
+    sa->since_refresh = 0;
+    memset(sa->sum, 0, sizeof(sa->sum));
+}
+
+bool mtt_pure::average(float *IR)
+{
+    int k, j;
+
+    if(sa==NULL || sa->count==1) return true;
+
+    float * slot = sa->ring[sa->next];
+    float * sum = sa->sum;
+    float scale = 1.0f/sa->count;
+
+    // the oldest scan leaves the sum only if ring is already full
+    k = 0;
+    if(sa->filled==sa->count) {
+    #if defined (MTT_SSE2)
+        for( ; k+4<=2*SCANLENGHT; k+=4 ) {
+            __m128 v_in = _mm_loadu_ps( &IR[k] );
+            _mm_storeu_ps( &sum[k], _mm_add_ps( _mm_sub_ps( _mm_loadu_ps( &sum[k] ), _mm_loadu_ps( &slot[k] ) ), v_in ) );
+            _mm_storeu_ps( &slot[k], v_in );
+        }
+    #endif
+        for( ; k<2*SCANLENGHT; k++ ) {
+            sum[k] = sum[k] - slot[k] + IR[k];
+            slot[k] = IR[k];
+        }
+    }
+    else {
+    #if defined (MTT_SSE2)
+        for( ; k+4<=2*SCANLENGHT; k+=4 ) {
+            __m128 v_in = _mm_loadu_ps( &IR[k] );
+            _mm_storeu_ps( &sum[k], _mm_add_ps( _mm_loadu_ps( &sum[k] ), v_in ) );
+            _mm_storeu_ps( &slot[k], v_in );
+        }
+    #endif
+        for( ; k<2*SCANLENGHT; k++ ) {
+            sum[k] += IR[k];
+            slot[k] = IR[k];
+        }
+        sa->filled++;
+    }
+    sa->next = (sa->next+1) % sa->count;
+
+    // rounding errors of adding and subtracting would accumulate forever, so the sum is rebuilt from time to time
+    if(++sa->since_refresh>=SA_REFRESH) {
+        sa->since_refresh = 0;
+        memcpy(sum, sa->ring[0], sizeof(sa->sum));
+        for( j=1; j<sa->filled; j++ )
+            for( k=0; k<2*SCANLENGHT; k++ )
+                sum[k] += sa->ring[j][k];
+    }
+
+    sa->since_output++;
+    if(sa->filled<sa->count || sa->since_output<sa->hop) return false;
+    sa->since_output = 0;
+
+    k = 0;
+#if defined (MTT_SSE2)
+    __m128 v_scale = _mm_set1_ps( scale );
+    for( ; k+4<=2*SCANLENGHT; k+=4 )
+        _mm_storeu_ps( &IR[k], _mm_mul_ps( _mm_loadu_ps( &sum[k] ), v_scale ) );
+#endif
+    for( ; k<2*SCANLENGHT; k++ )
+        IR[k] = sum[k]*scale;
+
+    return true;
+}
+
+ir_buffers * mtt_pure::irBuffers()
+{
+    if(ir==NULL)
+    {
+        ir = new ir_buffers;
+        memset(ir, 0, sizeof(ir_buffers));
+    }
+
+    return ir;
+}
+
+mttStorageBase *mtt_pure::createStorage(int capacity)
+{
+    // steps must be the same as in 'fitTargetCapacity' function
+    switch(fitTargetCapacity(capacity))
+    {
+        case 4: return new mttStorage<4>;
+        case MAX_N: return new mttStorage<MAX_N>;
+        case 16: return new mttStorage<16>;
+        case 32: return new mttStorage<32>;
+        case 64: return new mttStorage<64>;
+        default: break;
+    }
+
+    return new mttStorage<DYNAMIC_CAPACITY>(fitTargetCapacity(capacity));
+}
+
+float *mtt_pure::MTT(float *P_mem, float r[], float q[], float dif_d, float dif_fi, int min_OLGI, int min_NTI)
+{
+    if(P_mem==NULL) return NULL;
 
     int k;
 
     /*
      * Jednorozmerny vstup na dvojrozmerne pole
      */
-    for(k=0;k<MAX_N;k++){
+    for(k=0;k<capacity;k++){
         P[0][k]=P_mem[2*k];
         P[1][k]=P_mem[2*k+1];
     }
@@ -59,19 +329,19 @@ float *mtt_pure::MTT(float *P_mem, float r[], float q[], float dif_d, float dif_
     /*
      *Transformacia spat
      */
-    for(k=0;k<MAX_N;k++){
+    for(k=0;k<capacity;k++){
         P_mem[2*k]=T[0][k];
         P_mem[2*k+1]=T[1][k];
     }
     return P_mem;
 }
 
-void mtt_pure::MTT2(mtt_pure::real P[][MAX_N], mtt_pure::real r[], mtt_pure::real q[], mtt_pure::real dif_d, mtt_pure::real dif_fi, mtt_pure::word min_OLGI, mtt_pure::word min_NTI, mtt_pure::real T[][MAX_N], mtt_pure::word *start )
+void mtt_pure::MTT2(mtt_pure::realMatrix P, mtt_pure::real r[], mtt_pure::real q[], mtt_pure::real dif_d, mtt_pure::real dif_fi, mtt_pure::word min_OLGI, mtt_pure::word min_NTI, mtt_pure::realMatrix T, mtt_pure::word *start )
 {
 
     mtt_pure::word k, j, t, track;
     mtt_pure::real cost;
-    mtt_pure::word A[MAX_N][MAX_N];
+    mtt_pure::wordMatrix A = storage->A;
     mtt_pure::word max_MA, tmp;
     mtt_pure::word Clearing[3];
     mtt_pure::word new_track;
@@ -97,7 +367,7 @@ void mtt_pure::MTT2(mtt_pure::real P[][MAX_N], mtt_pure::real r[], mtt_pure::rea
             Y_e_4_init = 0.1; % pociatocny odhad uhlovej rychlosti
 
             */
-            for( k=0; k<MAX_N; k++ ) {
+            for( k=0; k<capacity; k++ ) {
                  T[0][k] = 0;
                  T[1][k] = 0;
             }
@@ -109,8 +379,17 @@ void mtt_pure::MTT2(mtt_pure::real P[][MAX_N], mtt_pure::real r[], mtt_pure::rea
             }
             P_init[0][0] = P_init[1][1] = P_init[2][2] = P_init[3][3] = (real) 0.01;
 
-            Y_e_2_init = (real) 0.1;
-            Y_e_4_init = (real) 0.1;
+            if(stateModel==MTT_CARTESIAN_STATE)
+            {
+                // direction of motion is unknown, new cartesian tracks start at rest
+                Y_e_2_init = (real) 0.0;
+                Y_e_4_init = (real) 0.0;
+            }
+            else
+            {
+                Y_e_2_init = (real) 0.1;
+                Y_e_4_init = (real) 0.1;
+            }
 
             /*
             R = diag(r);
@@ -140,13 +419,13 @@ void mtt_pure::MTT2(mtt_pure::real P[][MAX_N], mtt_pure::real r[], mtt_pure::rea
             Y_e = zeros(4,1,max_nn_tr); % state estimation vectors
             P_e = zeros(4,4,max_nn_tr); % estimation covariance matrix
             */
-            for( k=0; k<MAX_N; k++ ) {
+            for( k=0; k<capacity; k++ ) {
                 Z[k][0] = 0;
                 Z[k][1] = 0;
             }
 
             for( k=0; k<4; k++ ) {
-                for( j=0; j<MAX_N; j++ ) {
+                for( j=0; j<capacity; j++ ) {
                     Y_p[j][k] = 0;
                     Y_e[j][k] = 0;
                     K[j][k][0] = 0;
@@ -155,7 +434,7 @@ void mtt_pure::MTT2(mtt_pure::real P[][MAX_N], mtt_pure::real r[], mtt_pure::rea
             }
 
             for( k=0; k<4; k++ ) {
-                for( j=0; j<MAX_N; j++ ) {
+                for( j=0; j<capacity; j++ ) {
                         for( t=0; t<4; t++ ) {
                             P_p[j][t][k] = 0;
                             P_e[j][t][k] = 0;
@@ -170,7 +449,7 @@ void mtt_pure::MTT2(mtt_pure::real P[][MAX_N], mtt_pure::real r[], mtt_pure::rea
             NTI[0] = NTI[1] = NTI[2] = 0;
             last_obs[0][0] = last_obs[0][1] = last_obs[0][2] = 0;
             last_obs[1][0] = last_obs[1][1] = last_obs[1][2] = 0;
-            for( k=0; k< MAX_N; k++ ) {
+            for( k=0; k< capacity; k++ ) {
                 OLGI[k] = 0;
             }
 
@@ -218,8 +497,9 @@ void mtt_pure::MTT2(mtt_pure::real P[][MAX_N], mtt_pure::real r[], mtt_pure::rea
             if ( nn_obs == 0 ) {
                obs = 0;
                if( (P[0][obs] != 0) || (P[1][obs] != 0) ) {
-                   cartesian2polar( P[0][obs], P[1][obs], &Z[nn_obs][0], &Z[nn_obs][1] );
+                   to_observation( P[0][obs], P[1][obs], &Z[nn_obs][0], &Z[nn_obs][1] );
                    init_estimation (Z[nn_obs][0], Z[nn_obs][1], Y_e_2_init, Y_e_4_init, P_init, &Y_e[nn_obs][0], &P_e[nn_obs][0][0]);
+                   new_track_ID( nn_obs );
                    nn_obs++;
                    nn_track = nn_obs;
                    *start = MTT_TRACK;
@@ -242,15 +522,15 @@ void mtt_pure::MTT2(mtt_pure::real P[][MAX_N], mtt_pure::real r[], mtt_pure::rea
                     end
                 end
             */
-            for( k=0; k<MAX_N; k++ ) {      // Matlab code uses 3-d dimmension (im)
+            for( k=0; k<capacity; k++ ) {      // Matlab code uses 3-d dimmension (im)
                Z[k][0] = 0;
                Z[k][1] = 0;
             }
 
             nn_obs = 0;
-            for (obs=0; obs < MAX_N; obs++) {
+            for (obs=0; obs < capacity; obs++) {
                 if ( (P[0][obs] != 0) || (P[1][obs] != 0) ) {
-                    cartesian2polar( P[0][obs], P[1][obs], &Z[nn_obs][0], &Z[nn_obs][1] );
+                    to_observation( P[0][obs], P[1][obs], &Z[nn_obs][0], &Z[nn_obs][1] );
                     nn_obs = nn_obs + 1;
                 }
             }
@@ -266,6 +546,7 @@ void mtt_pure::MTT2(mtt_pure::real P[][MAX_N], mtt_pure::real r[], mtt_pure::rea
 
             if ( (nn_obs > 0) && (nn_track == 0) ) {
                  init_estimation (Z[nn_track][0], Z[nn_track][1], Y_e_2_init, Y_e_4_init, P_init, &Y_e[nn_track][0], &P_e[nn_track][0][0]);
+                 new_track_ID( nn_track );
                  nn_track = 1;
             }
 
@@ -273,8 +554,8 @@ void mtt_pure::MTT2(mtt_pure::real P[][MAX_N], mtt_pure::real r[], mtt_pure::rea
                 M = zeros(nn_obs,nn_track); % matica "Gate Mask"
                 C = 10^2*ones(nn_obs,nn_track); % nakladova matica
             */
-                for( k=0; k<MAX_N; k++ ) {
-                     for( j=0; j<MAX_N; j++ ) {
+                for( k=0; k<capacity; k++ ) {
+                     for( j=0; j<capacity; j++ ) {
                          M[k][j] = 0;
                          C[k][j] = 0;
                      }
@@ -297,11 +578,19 @@ void mtt_pure::MTT2(mtt_pure::real P[][MAX_N], mtt_pure::real r[], mtt_pure::rea
                     end
                 end
             */
-                 for( track=0; track<nn_track; track++ ) {
-                      prediction ( &Y_e[track][0], &P_e[track][0][0], Q, &Y_p[track][0], &P_p[track][0][0] );
-                      for( obs=0; obs<nn_obs; obs++ ) {
-                          gate_checker ( Z[obs][0], Z[obs][1], &Y_p[track][0], R, &P_p[track][0][0], &M[obs][track],  &C[obs][track]);
-                      }
+                 if( nn_obs*nn_track < GRID_GATING_PAIRS ) {
+                     for( track=0; track<nn_track; track++ ) {
+                          prediction ( &Y_e[track][0], &P_e[track][0][0], Q, &Y_p[track][0], &P_p[track][0][0] );
+                          for( obs=0; obs<nn_obs; obs++ ) {
+                              gate_checker ( Z[obs][0], Z[obs][1], &Y_p[track][0], R, &P_p[track][0][0], &M[obs][track],  &C[obs][track]);
+                          }
+                     }
+                 }
+                 else {
+                     // many targets, checking every pair would be quadratic, pairs far away from each other are skipped
+                     for( track=0; track<nn_track; track++ )
+                          prediction ( &Y_e[track][0], &P_e[track][0][0], Q, &Y_p[track][0], &P_p[track][0][0] );
+                     grid_gating ( nn_obs, nn_track );
                  }
 
 
@@ -324,8 +613,10 @@ void mtt_pure::MTT2(mtt_pure::real P[][MAX_N], mtt_pure::real r[], mtt_pure::rea
                         for( track=0; track<nn_track; track++ ) {
                 OLGI[track]++;
                 if (OLGI[track] >= min_OLGI) {
-                    obs_less_gate_ident (&OLGI[nn_track], track, nn_track, &Y_e[nn_track][0], &P_e[nn_track][0][0],
+                    // the last track is moved into freed slot (Matlab 'nn_track' is the last track, here it is 'nn_track-1')
+                    obs_less_gate_ident (&OLGI[nn_track-1], track, nn_track-1, &Y_e[nn_track-1][0], &P_e[nn_track-1][0][0],
                               &Y_e[track][0], &P_e[track][0][0], &OLGI[track]);
+                    ID[track] = ID[nn_track-1];
                     nn_track--;
                 }
             }
@@ -398,6 +689,7 @@ void mtt_pure::MTT2(mtt_pure::real P[][MAX_N], mtt_pure::real r[], mtt_pure::rea
                     if (OLGI[track] >= min_OLGI) {
                          obs_less_gate_ident (&OLGI[nn_track-1], track, nn_track-1, &Y_e[nn_track-1][0], &P_e[nn_track-1][0][0],
                               &Y_e[track][0], &P_e[track][0][0], &OLGI[track]);
+                         ID[track] = ID[nn_track-1];
                          nn_track--;
                     }
                 }
@@ -427,10 +719,15 @@ void mtt_pure::MTT2(mtt_pure::real P[][MAX_N], mtt_pure::real r[], mtt_pure::rea
         for( obs=0; obs<nn_obs; obs++ ) {
             if( find_max ( M, obs) == 0 ) {
                 new_tg_ident ( nn_NTI, min_NTI, NTI, &last_obs[0][0], &last_obs[1][0],
-                        Z[obs][0], Z[obs][1], dif_d, dif_fi, nn_track, Clearing, MAX_N,
+                        Z[obs][0], Z[obs][1], dif_d, dif_fi, nn_track, Clearing, capacity,
                         &new_track, Clearing );
                 if( new_track > 0 ) {
-                   init_estimation (Z[nn_obs-1][0],Z[nn_obs-1][1] , Y_e_2_init, Y_e_4_init, P_init, &Y_e[new_track-1][0], &P_e[new_track-1][0][0]);
+                   // reference implementation initializes new track from the last observation of scan, cartesian
+                   // model uses the observation which really confirmed new target (polar output is kept unchanged)
+                   k = (stateModel==MTT_CARTESIAN_STATE) ? obs : nn_obs-1;
+                   init_estimation (Z[k][0],Z[k][1] , Y_e_2_init, Y_e_4_init, P_init, &Y_e[new_track-1][0], &P_e[new_track-1][0][0]);
+                   // if tracker is full, the last track is replaced, so it gets new identifier as well
+                   new_track_ID( new_track-1 );
                    nn_track = new_track;
                 }
             }
@@ -457,21 +754,21 @@ void mtt_pure::MTT2(mtt_pure::real P[][MAX_N], mtt_pure::real r[], mtt_pure::rea
             end
         */
 
-        for( k=0; k< MAX_N; k++ ) {
+        for( k=0; k< capacity; k++ ) {
                     T[0][k] = T[1][k] = 0.0;         /* clear previous results */
         }
 
         for( track=0; track<nn_track; track++ ) {
-            polar2cartesian ( &Y_e[track][0], &T[0][track], &T[1][track] );
+            from_estimation ( &Y_e[track][0], &T[0][track], &T[1][track] );
         }
         break;
     }
 }
 
-mtt_pure::word mtt_pure::find_max ( mtt_pure::word in[][MAX_N], mtt_pure::word row ) {
+mtt_pure::word mtt_pure::find_max ( mtt_pure::wordMatrix in, mtt_pure::word row ) {
     mtt_pure::word k;
     mtt_pure::word val = INT_MIN;
-    for (k=0; k<MAX_N; k++) {
+    for (k=0; k<capacity; k++) {
          if( in[row][k] > val )
                   val =  in[row][k];
     }
@@ -673,6 +970,17 @@ void mtt_pure::cartesian2polar(mtt_pure::real x, mtt_pure::real y, mtt_pure::rea
     }
 }
 
+void mtt_pure::to_observation(mtt_pure::real x, mtt_pure::real y, mtt_pure::real *z1, mtt_pure::real *z2)
+{
+    if(stateModel==MTT_CARTESIAN_STATE)
+    {
+        // cartesian filter observes positions directly
+        *z1 = x;
+        *z2 = y;
+    }
+    else cartesian2polar(x, y, z1, z2);
+}
+
 void mtt_pure::connected_covering(mtt_pure::word value_ch_b, mtt_pure::word ch, mtt_pure::word cover_b, mtt_pure::word w, mtt_pure::word trace_con[], mtt_pure::word c[])
 {
     UNUSED(value_ch_b);
@@ -861,22 +1169,16 @@ void mtt_pure::prediction(mtt_pure::real Y_e_p[], mtt_pure::real *P_e_p, mtt_pur
 
 }
 
-void mtt_pure::covering(mtt_pure::word value_ch_b, mtt_pure::word *ch, mtt_pure::word m, mtt_pure::word trace_con[], mtt_pure::word c[], mtt_pure::word *cover_b)
+void mtt_pure::covering(mtt_pure::word value_ch_b, mtt_pure::word *ch, mtt_pure::word m, det_map *trace_con, mtt_pure::word c[], mtt_pure::word *cover_b)
 {
-    word chip;
-    word cover_b_found;
-    //word i; // seems to be unsued
+    word run;
 
     c[0] = c[1] = c[2] = 0;
-    cover_b_found = 0;
-    chip = *ch +1;
-    while( (cover_b_found == 0) && (chip <= *ch+2*m) ) {
-       if (trace_con[ chip ] == 3) {
-               *cover_b = chip;
-               cover_b_found = 1;
-       }
-       else {
-               chip += 1;
+    // the first sample with value 3 after ch (there is always one, since trace_con(ch+2*m) == 3)
+    for( run=find_run( trace_con, *ch+1 ); run<trace_con->count && trace_con->run[run].begin<=*ch+2*m; run++ ) {
+       if (trace_con->run[run].value == 3) {
+               *cover_b = (trace_con->run[run].begin > *ch+1) ? trace_con->run[run].begin : *ch+1;
+               break;
        }
     }
     c[0] = (*cover_b) + ((*ch+2*m-(*cover_b)+1)/2);
@@ -885,10 +1187,9 @@ void mtt_pure::covering(mtt_pure::word value_ch_b, mtt_pure::word *ch, mtt_pure:
     *ch = (*cover_b) + 2*m + 1;
 }
 
-void mtt_pure::different_values(mtt_pure::word trace_con[], mtt_pure::word *ch, mtt_pure::word m, mtt_pure::word value_ch_b, mtt_pure::word value_ch_e, mtt_pure::word nn_ch, mtt_pure::word c[])
+void mtt_pure::different_values(det_map *trace_con, mtt_pure::word *ch, mtt_pure::word m, mtt_pure::word value_ch_b, mtt_pure::word value_ch_e, mtt_pure::word nn_ch, mtt_pure::word c[])
 {
-    word pos_three[SCANLENGHT];
-    word nn_three, k, pos;
+    word first_three, last_three, nn_three, run, pos, b, e;
 
     c[0] = c[1] = c[2] = 0;
     /*
@@ -897,10 +1198,15 @@ void mtt_pure::different_values(mtt_pure::word trace_con[], mtt_pure::word *ch,
     */
 
     nn_three = 0;
-    for( k=*ch; k<= (*ch+2*m); k++ ) {
-       if( trace_con[k] == 3 ) {
-            pos_three[ nn_three ] = k - *ch;
-            nn_three++;
+    first_three = last_three = 0;
+    for( run=find_run( trace_con, *ch ); run<trace_con->count && trace_con->run[run].begin<=*ch+2*m; run++ ) {
+       if( trace_con->run[run].value == 3 ) {
+            b = (trace_con->run[run].begin > *ch) ? trace_con->run[run].begin : *ch;
+            e = (trace_con->run[run].end < *ch+2*m+1) ? trace_con->run[run].end : *ch+2*m+1;
+            if( nn_three == 0 )
+                first_three = b - *ch;
+            last_three = e - 1 - *ch;
+            nn_three += e - b;
        }
     }
 
@@ -909,12 +1215,16 @@ void mtt_pure::different_values(mtt_pure::word trace_con[], mtt_pure::word *ch,
     if nn_three == 0 % bez prekrytia
         ch = ch - 1 + find(trace_con(ch:ch+2*m)~=value_ch_b,1);
     */
-    pos = -1;
-    for( k=*ch; k<= *ch+2*m; k++ ) {
-        if( (trace_con[k] != value_ch_b) && (pos==-1) ) {
-           pos = k;
-        }
-    }
+    pos = *ch;
+    run = find_run( trace_con, pos );
+    while( pos <= *ch+2*m ) {
+        if( run >= trace_con->count || trace_con->run[run].begin > pos || trace_con->run[run].value != value_ch_b )
+            break;      // zero or other value at pos
+        pos = trace_con->run[run].end;
+        run++;
+    }
+    if( pos > *ch+2*m )
+        pos = -1;
     *ch = pos;                // vector is searched in absolute positions!
     /*
                      if (pos < 0 )
@@ -938,19 +1248,105 @@ void mtt_pure::different_values(mtt_pure::word trace_con[], mtt_pure::word *ch,
             ch = ch + 1;
         end
     */
-         c[0] = (pos_three[0]+pos_three[nn_three-1])/2 + *ch;   // -1 removed
+         c[0] = (first_three+last_three)/2 + *ch;   // -1 removed
          c[1] = nn_three;
          if (value_ch_e == 0)
               c[2] = 1;
          else
               c[2] = 3 - value_ch_e;
          *ch = ( c[0] + nn_three/2 );
-         while( (trace_con[*ch] != 0) & ((*ch+2) < nn_ch) )
-               *ch += 1;
+         if( (*ch+2) < nn_ch ) {
+              *ch = block_end( trace_con, *ch );
+              if( *ch > nn_ch-2 )
+                   *ch = nn_ch-2;
+         }
+
+    }
+}
+
+void mtt_pure::grid_gating(mtt_pure::word nn_obs, mtt_pure::word nn_track)
+{
+    word obs, track, k, j, g, cells, cx0, cx1, cy0, cy1;
+    real min0, max0, min1, max1, size0, size1, half0, half1;
+    word * gridCell = storage->gridCell;
+    word * gridOrder = storage->gridOrder;
+    word * gridStart = storage->gridStart;
+
+    /*
+     * gate_checker accepts observation only if it lies inside of rectangle +-GATE_SIGMA*sigma around predicted
+     * position. Observations are sorted into uniform g x g grid covering all of them (about one observation per cell)
+     * and only observations from cells overlapped by this rectangle are passed to gate_checker. Result is the same
+     * as checking all pairs, because rejected pairs would not pass the rectangle test anyway.
+     */
+
+    // pairs which are not examined are outside of gate
+    for( obs=0; obs<nn_obs; obs++ ) {
+        for( track=0; track<nn_track; track++ ) {
+            M[obs][track] = 0;
+            C[obs][track] = LARGE_NUMBER;
+        }
+    }
 
+    min0 = max0 = Z[0][0];
+    min1 = max1 = Z[0][1];
+    for( obs=1; obs<nn_obs; obs++ ) {
+        if( Z[obs][0] < min0 ) min0 = Z[obs][0];
+        if( Z[obs][0] > max0 ) max0 = Z[obs][0];
+        if( Z[obs][1] < min1 ) min1 = Z[obs][1];
+        if( Z[obs][1] > max1 ) max1 = Z[obs][1];
+    }
+
+    g = (word) ceil( sqrt( (real) nn_obs ) );
+    cells = g*g;
+    size0 = ( max0 > min0 ) ? ( max0 - min0 ) / g : 1;
+    size1 = ( max1 > min1 ) ? ( max1 - min1 ) / g : 1;
+
+    // counting sort of observations by cell index, gridStart[cell] is the first observation of cell in gridOrder
+    for( k=0; k<cells; k++ )
+        gridStart[k] = 0;
+    for( obs=0; obs<nn_obs; obs++ ) {
+        cx0 = grid_cell( Z[obs][0], min0, size0, g );
+        cy0 = grid_cell( Z[obs][1], min1, size1, g );
+        gridCell[obs] = cy0*g + cx0;
+        gridStart[gridCell[obs]]++;
+    }
+    for( k=1; k<cells; k++ )
+        gridStart[k] += gridStart[k-1];
+    gridStart[cells] = nn_obs;
+    for( obs=nn_obs-1; obs>=0; obs-- )
+        gridOrder[--gridStart[gridCell[obs]]] = obs;
+
+    for( track=0; track<nn_track; track++ ) {
+        // the same gate size as in gate_checker
+        half0 = GATE_SIGMA * (real) sqrt( R[0][0] + P_p[track][1][1] );
+        half1 = GATE_SIGMA * (real) sqrt( R[1][1] + P_p[track][3][3] );
+
+        if( Y_p[track][0] + half0 < min0 || Y_p[track][0] - half0 > max0 ) continue;
+        if( Y_p[track][2] + half1 < min1 || Y_p[track][2] - half1 > max1 ) continue;
+
+        cx0 = grid_cell( Y_p[track][0] - half0, min0, size0, g );
+        cx1 = grid_cell( Y_p[track][0] + half0, min0, size0, g );
+        cy0 = grid_cell( Y_p[track][2] - half1, min1, size1, g );
+        cy1 = grid_cell( Y_p[track][2] + half1, min1, size1, g );
+
+        for( k=cy0; k<=cy1; k++ ) {
+            for( j=gridStart[k*g+cx0]; j<gridStart[k*g+cx1+1]; j++ ) {
+                obs = gridOrder[j];
+                gate_checker ( Z[obs][0], Z[obs][1], &Y_p[track][0], R, &P_p[track][0][0], &M[obs][track],  &C[obs][track]);
+            }
+        }
     }
 }
 
+mtt_pure::word mtt_pure::grid_cell(mtt_pure::real value, mtt_pure::real min, mtt_pure::real size, mtt_pure::word g)
+{
+    real cell = ( value - min ) / size;
+
+    if( cell <= 0 ) return 0;
+    if( cell >= g ) return g-1;
+    return (word) cell;
+}
+
 void mtt_pure::gate_checker(mtt_pure::real r, mtt_pure::real fi, mtt_pure::real Y_p[], mtt_pure::real R[][2], mtt_pure::real *P_p, mtt_pure::word *m, mtt_pure::real *c)
 {
     word  k, j;
@@ -1063,26 +1459,58 @@ void mtt_pure::init_estimation(mtt_pure::real r, mtt_pure::real fi, mtt_pure::re
                 P_e[4*k+j] = P_init[k][j];
 }
 
-void mtt_pure::t_integration(mtt_pure::word *inptr, mtt_pure::word t_size, mtt_pure::word min_int, mtt_pure::word nn_ch)
+void mtt_pure::t_integration(det_map *inptr, mtt_pure::word t_size, mtt_pure::word min_int, mtt_pure::word nn_ch, det_map *int_IR)
 {
-    word integ[ SCANLENGHT ];
-    word   i, sum;
-
+    word ia, ib, a, s, pos, next, sum, slope, cross;
 
+    /*
+     * Sliding sum of t_size samples integ(i) = in(i-t_size+1) + ... + in(i) (growing window at the beginning of the
+     * vector, integ(0) is always 0 as in Matlab code) is compared with min_int. The slope of integ changes only at
+     * boundaries of runs and at boundaries shifted by t_size, between them integ is linear and threshold crossing
+     * is computed directly. 'ia'/'ib' count boundaries (begin, end, begin, ...) of input runs which are behind
+     * the current position without/with shift, so the sample enters the window if 'ia' is odd and leaves it if 'ib' is odd.
+     */
+    int_IR->count = 0;
+    ia = ib = 0;
     sum = 0;
-    for( i=0; i<t_size; i++ ) {      // "growing" window at the beginning of the vector
-            sum += inptr[i];
-                            integ[i] = sum;
-    }
-            integ[0] = 0;                    // Matlab code starts from integ[1] ...
-
-    for( i=t_size; i<nn_ch; i++ ) {  // "sliding" window up to the end of vector
-            sum += inptr[i] - inptr[i-t_size];
-                            integ[i] = sum;
-    }
-
-    for( i=0; i<nn_ch; i++ ) {
-            inptr[ i ] = integ[ i ] >=  min_int;
+    pos = 0;
+    while( pos < nn_ch ) {
+        while( ia < 2*inptr->count && run_boundary( inptr, ia ) <= pos )
+            ia++;
+        while( ib < 2*inptr->count && run_boundary( inptr, ib ) + t_size <= pos )
+            ib++;
+        a = ia&1;
+        s = ib&1;
+
+        // the first sample is separate piece because of integ(0) = 0
+        next = nn_ch;
+        if( pos == 0 ) next = 1;
+        if( ia < 2*inptr->count && run_boundary( inptr, ia ) < next )
+            next = run_boundary( inptr, ia );
+        if( ib < 2*inptr->count && run_boundary( inptr, ib ) + t_size < next )
+            next = run_boundary( inptr, ib ) + t_size;
+
+        slope = a - s;
+        if( pos == 0 ) {
+            if( 0 >= min_int ) add_run( int_IR, 0, 1, 1 );
+        }
+        else if( slope > 0 ) {
+            // integ(i) = sum + (i-pos+1) reaches min_int at the sample 'cross'
+            cross = pos - 1 + min_int - sum;
+            if( cross < pos ) cross = pos;
+            if( cross < next ) add_run( int_IR, cross, next, 1 );
+        }
+        else if( slope < 0 ) {
+            // integ(i) = sum - (i-pos+1) falls below min_int at the sample 'cross'
+            cross = pos + sum - min_int;
+            if( cross > next ) cross = next;
+            if( cross > pos ) add_run( int_IR, pos, cross, 1 );
+        }
+        else if( sum >= min_int ) {
+            add_run( int_IR, pos, next, 1 );
+        }
+        sum += slope*(next-pos);
+        pos = next;
     }
 }
 
@@ -1115,13 +1543,14 @@ void mtt_pure::intersection2ellipses(mtt_pure::real d0, mtt_pure::real d1, mtt_p
     }
 }
 
-float *mtt_pure::trace_connection(int *inptr1, int *inptr2, int *TC, int t_size, int min_int, int m, int max_nn_tg, float *TOA_mem)
+float *mtt_pure::trace_connection(det_map *out_det, det_map *TC, int t_size, int min_int, int m, int max_nn_tg, float *TOA_mem)
 {
     int k;
-    for( k=0; k<SCANLENGHT; k++ ){
-        out_det[0][k]=inptr1[k];
-        out_det[1][k]=inptr2[k];
-    }
+    ir_buffers * buf = irBuffers();
+    int (*center_previous)[3] = buf->center_previous;
+    real (*TOA_m)[MAX_N] = buf->TOA_m;
+
+    // detector maps are not modified, so they can be passed directly
     trace_connection2(out_det, t_size, min_int, m, max_nn_tg, center_previous,TC,TOA_m);
     for(k=0;k<MAX_N;k++){
         TOA_mem[2*k]=TOA_m[0][k];
@@ -1131,7 +1560,7 @@ float *mtt_pure::trace_connection(int *inptr1, int *inptr2, int *TC, int t_size,
     return TOA_mem;
 }
 
-void mtt_pure::trace_connection2(mtt_pure::word out_det[][SCANLENGHT], mtt_pure::word t_size, mtt_pure::word min_int, mtt_pure::word m, mtt_pure::word max_nn_tg, mtt_pure::word center_previous[][3], mtt_pure::word *TC, mtt_pure::real TOA_m[][MAX_N])
+void mtt_pure::trace_connection2(det_map *out_det, mtt_pure::word t_size, mtt_pure::word min_int, mtt_pure::word m, mtt_pure::word max_nn_tg, mtt_pure::word center_previous[][3], det_map *TC, mtt_pure::real TOA_m[][MAX_N])
 {
     UNUSED(max_nn_tg);
 
@@ -1146,15 +1575,16 @@ void mtt_pure::trace_connection2(mtt_pure::word out_det[][SCANLENGHT], mtt_pure:
     center_previous = zeros (max_nn_tg,3);
     c2 =  zeros(max_nn_tg,nn_im);
     */
-    word k, j;
+    word k;
     word nn_obs;
     word value_ch_b, value_ch_e;
     word cover_b;
     word c2[MAX_N]; UNUSED(c2); // seems to be unused
     word center[MAX_N][3];
-    word first_reflection[2][SCANLENGHT];
-    word IR[SCANLENGHT];
-    word trace_con[SCANLENGHT];
+    ir_buffers * buf = irBuffers();
+    det_map * first_reflection = buf->first_reflection;
+    det_map * int_IR = &buf->int_IR;
+    det_map * trace_con = TC;      // all maps are run-length encoded, see 'det_map'
     word c[3];
     word ch;
     word pos;
@@ -1163,9 +1593,6 @@ void mtt_pure::trace_connection2(mtt_pure::word out_det[][SCANLENGHT], mtt_pure:
        TOA_m[0][k] = TOA_m[1][k] = 0.0;
        c2[k] = 0;
     }
-    for( k=0; k<SCANLENGHT; k++ ){
-        TC[k] = 0;
-    }
 
     /*
     %-------------------------------------------------------------------------%
@@ -1210,11 +1637,8 @@ void mtt_pure::trace_connection2(mtt_pure::word out_det[][SCANLENGHT], mtt_pure:
         end % koniec cyklu cez oba prijimace
     */
     for(k=0; k<2; k++ ) {
-        for( j=0; j<SCANLENGHT; j++ ) {
-            IR[j] = out_det[k][j];
-        }
-        t_integration( IR, t_size, min_int, SCANLENGHT );
-        point_targets( SCANLENGHT, IR, min_int, m, k, &first_reflection[k][0] );
+        t_integration( &out_det[k], t_size, min_int, SCANLENGHT, int_IR );
+        point_targets( SCANLENGHT, int_IR, min_int, m, k, &first_reflection[k] );
 
     }
 
@@ -1233,17 +1657,14 @@ void mtt_pure::trace_connection2(mtt_pure::word out_det[][SCANLENGHT], mtt_pure:
         % ciel bude znacne velky
 
     */
-    for( j=0; j<SCANLENGHT; j++ ) {
-        trace_con[j] = first_reflection[0][j] + first_reflection[1][j];
-        TC[j] = trace_con[j];
-    }
+    connect_traces( first_reflection, trace_con );
 
     /*
         nn_obs = 0; % pocet najdenych prekryti
         ch = find(trace_con > 0,1); % prva kladna chipova hodnota
     */
     nn_obs = 0;
-    ch = find_vec( trace_con, SCANLENGHT );       // -1 if "empty"
+    ch = (trace_con->count > 0) ? trace_con->run[0].begin : EMPTY;       // -1 if "empty"
 
     /*
         while ch < nn_ch - 2*m  % prehladavanie celej impulzovej odpovede
@@ -1259,7 +1680,7 @@ void mtt_pure::trace_connection2(mtt_pure::word out_det[][SCANLENGHT], mtt_pure:
     /*
     if trace_con(ch) > 0 % hladanie kladnej hodnoty
     */
-    if( trace_con[ch] > 0 ) {
+    if( run_value( trace_con, ch ) > 0 ) {
     /*
     %-------------------------------------------------------------------------%
     % prvy odraz od ciela zabera po umelom rozsireni 2*m+1 chipov; ak sa
@@ -1269,8 +1690,8 @@ void mtt_pure::trace_connection2(mtt_pure::word out_det[][SCANLENGHT], mtt_pure:
     value_ch_b = trace_con(ch);
     value_ch_e = trace_con(ch+2*m);
     */
-    value_ch_b = trace_con[ch];
-    value_ch_e = trace_con[ch+2*m];
+    value_ch_b = run_value( trace_con, ch );
+    value_ch_e = run_value( trace_con, ch+2*m );
     /*
     if value_ch_b == value_ch_e
     */
@@ -1351,7 +1772,7 @@ void mtt_pure::trace_connection2(mtt_pure::word out_det[][SCANLENGHT], mtt_pure:
     end
     */
       if( ch < SCANLENGHT ) {
-           if( trace_con[ch] > 0 ) {
+           if( run_value( trace_con, ch ) > 0 ) {
               if ( nn_obs +1 <=MAX_N ) {
                 // connected_covering (value_ch_b, ch, cover_b, center[nn_obs-1][1], trace_con, &center[nn_obs][0]);
                  /*zmenit za connected_reflections*/
@@ -1416,11 +1837,13 @@ void mtt_pure::trace_connection2(mtt_pure::word out_det[][SCANLENGHT], mtt_pure:
     %-------------------------------------------------------------------------%
                 ch = ch + find(trace_con(ch+1:end) > 0,1);
     */
-    pos = find_vec( &trace_con[ch+1], SCANLENGHT - ch -1 );
-    if (pos < 0)
-         ch = pos;              // if "empty" vector
+    pos = find_run( trace_con, ch+1 );
+    if (pos >= trace_con->count)
+         ch = EMPTY;              // if "empty" vector
+    else if (trace_con->run[pos].begin > ch+1)
+         ch = trace_con->run[pos].begin;
     else
-         ch += 1+pos;
+         ch += 1;
 
     /*
        end % koniec "if" cyklu
@@ -1576,49 +1999,44 @@ void mtt_pure::polar2cartesian(mtt_pure::real Y_e[], mtt_pure::real *x, mtt_pure
     *y = Y_e[0]* (real)sin(Y_e[2]);
 }
 
-void mtt_pure::point_targets(mtt_pure::word nn_ch, mtt_pure::word int_IR[], mtt_pure::word min_int, mtt_pure::word m, mtt_pure::word rx, mtt_pure::word first_reflection[])
+void mtt_pure::from_estimation(mtt_pure::real Y_e[], mtt_pure::real *x, mtt_pure::real *y)
 {
-    word dif_int_IR[ SCANLENGHT ];
-    word pos_ones[ SCANLENGHT ];
-    word k, j, pp, ch_pos, f_ch, l_ch;
+    if(stateModel==MTT_CARTESIAN_STATE)
+    {
+        *x = Y_e[0];
+        *y = Y_e[2];
+    }
+    else polar2cartesian(Y_e, x, y);
+}
+
+void mtt_pure::point_targets(mtt_pure::word nn_ch, det_map *int_IR, mtt_pure::word min_int, mtt_pure::word m, mtt_pure::word rx, det_map *first_reflection)
+{
+    word k, ch_pos, f_ch, l_ch;
 
     /*
     first_reflection = zeros (nn_ch,1);
-    dif_int_IR = zeros (nn_ch,1);
     */
-    clear_int_vector( first_reflection, nn_ch );
-    clear_int_vector( dif_int_IR, nn_ch );
+    first_reflection->count = 0;
     /*
     dif_int_IR(2:end) = int_IR(2:end) - int_IR(1:end-1);
-    */
-    for( k=1; k<nn_ch; k++ ) {
-         dif_int_IR[k] = int_IR[k] - int_IR[k-1];
-    }
-    /*
     pos_ones = find(dif_int_IR==1);
     */
-    pp = 0;
-    for( k=1; k<nn_ch; k++ ) {
-         if (dif_int_IR[k] == 1) {
-             pos_ones[ pp ] = k;
-             pp++;
-         }
-    }
-    if (pp > 0 ) {
-        for( k=0; k<pp; k++ ) {
-             ch_pos = pos_ones[k] - min_int;
+    for( k=0; k<int_IR->count; k++ ) {
+         if( int_IR->run[k].begin < 1 )    // beginning of run at the first sample is not a rising edge
+             continue;
 
-             f_ch = 0;
-             while( ch_pos-m+f_ch < 0 )
-                   f_ch += 1;
+         ch_pos = int_IR->run[k].begin - min_int;
 
-             l_ch = 0;
-             while( ch_pos+m-l_ch > nn_ch )       // strange, but I copy Matlab code ...
-                   l_ch += 1;
+         f_ch = ch_pos-m;
+         if( f_ch < 0 )
+               f_ch = 0;
 
-             for( j=ch_pos-m+f_ch; j<=ch_pos+m-l_ch; j++ )
-                   first_reflection[j] = (rx+1);  // Matlab code uses values 1 and 2!!!
-        }
+         l_ch = ch_pos+m+1;
+         if( l_ch > nn_ch )      // Matlab code uses '>' with indexing from 1
+               l_ch = nn_ch;
+
+         if( f_ch < l_ch )
+               add_run( first_reflection, f_ch, l_ch, rx+1 );  // Matlab code uses values 1 and 2!!!
     }
 }
 
@@ -1705,10 +2123,10 @@ float *mtt_pure::normalizing_new(float *inptr)
     return inptr;
 }
 
-void mtt_pure::connected_reflections(mtt_pure::word *ch, mtt_pure::word trace_con[], mtt_pure::word c[], mtt_pure::word m, mtt_pure::word *nn_obs)
+void mtt_pure::connected_reflections(mtt_pure::word *ch, det_map *trace_con, mtt_pure::word c[], mtt_pure::word m, mtt_pure::word *nn_obs)
 {
-    word pos=0;
-    word i,j;
+    word pos=-1;
+    word run;
     word reflection_e=0;
     word cover_e=0;
     c[0] = c[1] = c[2] = 0;
@@ -1718,19 +2136,17 @@ void mtt_pure::connected_reflections(mtt_pure::word *ch, mtt_pure::word trace_co
     /*   reflection_e = ch + find(trace_con(ch+1:end)==0,1) - 1; first zero entry
     reflection_e = ch + find(trace_con(ch+1:end)==0,1) - 1;*/
 
-    for(i= (*ch)+1,j=0;i<=SCANLENGHT;i++,j++){
-        if(trace_con[i]==0){
-            pos=j;
-            break;
-        }
-    }
-    reflection_e= *ch+pos-1;
-    pos=-1;
+    // the end of the vector counts as zero entry
+    reflection_e = block_end( trace_con, *ch+1 ) - 2;
 
     /*cover_e = reflection_e - find(trace_con(reflection_e:-1:reflection_e-2*m)==3,1) + 1;*/
-    for(i=reflection_e,j=0;i>=reflection_e-2*m;i--,j++){
-        if(trace_con[i]==3){
-            pos=j;
+    for( run=find_run( trace_con, reflection_e ); run>=0; run-- ) {
+        if( run >= trace_con->count || trace_con->run[run].begin > reflection_e )
+            continue;
+        if( trace_con->run[run].end - 1 < reflection_e-2*m )
+            break;
+        if( trace_con->run[run].value == 3 ) {
+            pos = reflection_e - ((trace_con->run[run].end - 1 < reflection_e) ? trace_con->run[run].end - 1 : reflection_e);
             break;
         }
     }
@@ -1749,7 +2165,7 @@ void mtt_pure::connected_reflections(mtt_pure::word *ch, mtt_pure::word trace_co
     end
          if(find_vec(cover_e)!=EMPTY){*/
     if(pos!=-1){
-         c[2]=3 - trace_con[reflection_e];
+         c[2]=3 - run_value( trace_con, reflection_e );
          c[1]=2*m + 1 - (reflection_e - cover_e);
          c[0]=cover_e - c[2]/2;
          if(c[1]%2==0){
@@ -1765,22 +2181,117 @@ void mtt_pure::connected_reflections(mtt_pure::word *ch, mtt_pure::word trace_co
     *ch=reflection_e+1;
 }
 
-void mtt_pure::munkres(mtt_pure::real costMat[][MAX_N], mtt_pure::word rows, mtt_pure::word cols, mtt_pure::real *cost, mtt_pure::word assign[][MAX_N])
+void mtt_pure::add_run(det_map *map, mtt_pure::word begin, mtt_pure::word end, mtt_pure::word value)
 {
-    word validCol[ MAX_N ];
-    word validRow[ MAX_N ];
-    real dMat[ MAX_N ][ MAX_N ], minval;
-    real M[ MAX_N ][ MAX_N ];
+    det_run * last;
+
+    // runs are always added in increasing order, so only the last one can touch the new one
+    if( map->count > 0 ) {
+        last = &map->run[map->count-1];
+        if( last->value == value && begin <= last->end ) {
+            if( end > last->end )
+                last->end = end;
+            return;
+        }
+    }
+
+    last = &map->run[map->count];
+    last->begin = begin;
+    last->end = end;
+    last->value = value;
+    map->count++;
+}
+
+mtt_pure::word mtt_pure::find_run(det_map *map, mtt_pure::word pos)
+{
+    word low = 0, high = map->count, mid;
+
+    // binary search, runs are sorted
+    while( low < high ) {
+        mid = (low + high)/2;
+        if( map->run[mid].end > pos )
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    return low;
+}
+
+mtt_pure::word mtt_pure::run_value(det_map *map, mtt_pure::word pos)
+{
+    word run = find_run( map, pos );
+
+    if( run < map->count && map->run[run].begin <= pos )
+        return map->run[run].value;
+    return 0;
+}
+
+mtt_pure::word mtt_pure::block_end(det_map *map, mtt_pure::word pos)
+{
+    word run = find_run( map, pos );
+
+    if( run >= map->count || map->run[run].begin > pos )
+        return pos;
+
+    // runs with different values may follow each other without gap
+    pos = map->run[run].end;
+    while( run+1 < map->count && map->run[run+1].begin == pos ) {
+        run++;
+        pos = map->run[run].end;
+    }
+    return pos;
+}
+
+mtt_pure::word mtt_pure::run_boundary(det_map *map, mtt_pure::word k)
+{
+    return (k&1) ? map->run[k/2].end : map->run[k/2].begin;
+}
+
+void mtt_pure::connect_traces(det_map *first_reflection, det_map *trace_con)
+{
+    word i0 = 0, i1 = 0, pos = 0, next, value;
+    det_map * fr0 = &first_reflection[0];
+    det_map * fr1 = &first_reflection[1];
+
+    // sweep over boundaries of both maps, between two boundaries the sum of maps is constant
+    trace_con->count = 0;
+    while( i0 < 2*fr0->count || i1 < 2*fr1->count ) {
+        next = INT_MAX;
+        if( i0 < 2*fr0->count && run_boundary( fr0, i0 ) < next )
+            next = run_boundary( fr0, i0 );
+        if( i1 < 2*fr1->count && run_boundary( fr1, i1 ) < next )
+            next = run_boundary( fr1, i1 );
+
+        value = ((i0&1) ? fr0->run[i0/2].value : 0) + ((i1&1) ? fr1->run[i1/2].value : 0);
+        if( value > 0 && next > pos )
+            add_run( trace_con, pos, next, value );
+
+        pos = next;
+        while( i0 < 2*fr0->count && run_boundary( fr0, i0 ) <= pos )
+            i0++;
+        while( i1 < 2*fr1->count && run_boundary( fr1, i1 ) <= pos )
+            i1++;
+    }
+}
+
+void mtt_pure::munkres(mtt_pure::realMatrix costMat, mtt_pure::word rows, mtt_pure::word cols, mtt_pure::real *cost, mtt_pure::wordMatrix assign)
+{
+    // work space is preallocated in storage, capacity may be too large for stack
+    word * validCol = storage->validCol;
+    word * validRow = storage->validRow;
+    realMatrix dMat = storage->dMat;
+    real minval;
+    realMatrix M = storage->munkresM;
     word M_row, M_col;
     real min_row;
 
-    word zP[ MAX_N ][ MAX_N ];
-    word starZ[ MAX_N ][ MAX_N ];
-    word primeZ[ MAX_N ][ MAX_N ];
-    word coverColumn[ MAX_N ];
-    word coverRow[ MAX_N ];
-    word stz[ MAX_N ];
-    word rowZ1[ MAX_N ];
+    wordMatrix zP = storage->zP;
+    wordMatrix starZ = storage->starZ;
+    wordMatrix primeZ = storage->primeZ;
+    word * coverColumn = storage->coverColumn;
+    word * coverRow = storage->coverRow;
+    word * stz = storage->stz;
+    word * rowZ1 = storage->rowZ1;
 
     word nRows, nCols, j, k, n, r, c, uZr, uZc, Step;
 
@@ -2122,7 +2633,7 @@ void mtt_pure::munkres(mtt_pure::real costMat[][MAX_N], mtt_pure::word rows, mtt
 /* -------------------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------------------- */
 
-void mtt_pure::zeros( mtt_pure::real in[][MAX_N], mtt_pure::word m, mtt_pure::word n )
+void mtt_pure::zeros( mtt_pure::realMatrix in, mtt_pure::word m, mtt_pure::word n )
 {
     mtt_pure::word i,j;
         for( i=0; i<m; i++ )
@@ -2130,7 +2641,7 @@ void mtt_pure::zeros( mtt_pure::real in[][MAX_N], mtt_pure::word m, mtt_pure::wo
                     in[i][j] = 0.0;
 }
 
-void mtt_pure::log_negate( mtt_pure::real in[][MAX_N], mtt_pure::word m, mtt_pure::word n, mtt_pure::word out[][MAX_N]  )
+void mtt_pure::log_negate( mtt_pure::realMatrix in, mtt_pure::word m, mtt_pure::word n, mtt_pure::wordMatrix out  )
 {
     mtt_pure::word i,j;
     for( i=0; i<m; i++ )
@@ -2141,7 +2652,7 @@ void mtt_pure::log_negate( mtt_pure::real in[][MAX_N], mtt_pure::word m, mtt_pur
                       out[i][j] = FALSE;
 }
 
-void mtt_pure::falses( mtt_pure::word in[][MAX_N], mtt_pure::word m, mtt_pure::word n )
+void mtt_pure::falses( mtt_pure::wordMatrix in, mtt_pure::word m, mtt_pure::word n )
 {
     mtt_pure::word i,j;
     for( i=0; i<m; i++ )
@@ -2158,7 +2669,7 @@ void mtt_pure::falses_vector( mtt_pure::word in[], mtt_pure::word n )
 }
 
 
-mtt_pure::word mtt_pure::any( mtt_pure::word in[][MAX_N], mtt_pure::word m, mtt_pure::word n )
+mtt_pure::word mtt_pure::any( mtt_pure::wordMatrix in, mtt_pure::word m, mtt_pure::word n )
 {
     mtt_pure::word i,j;
     for( i=0; i<m; i++ )
@@ -2177,7 +2688,7 @@ mtt_pure::word mtt_pure::any_vector( mtt_pure::word in[], mtt_pure::word n )
     return FALSE;
 }
 
-mtt_pure::word mtt_pure::any_not_selected (mtt_pure::word in[][MAX_N], mtt_pure::word row_sel[], mtt_pure::word col_sel[], mtt_pure::word m, mtt_pure::word n )
+mtt_pure::word mtt_pure::any_not_selected (mtt_pure::wordMatrix in, mtt_pure::word row_sel[], mtt_pure::word col_sel[], mtt_pure::word m, mtt_pure::word n )
 {
     mtt_pure::word i,j;
     for( i=0; i<m; i++ )
@@ -2201,7 +2712,7 @@ mtt_pure::word mtt_pure::any_vector_not_selected ( mtt_pure::word in[], mtt_pure
     return FALSE;
 }
 
-void mtt_pure::any_col( mtt_pure::word in[][MAX_N], mtt_pure::word m, mtt_pure::word n, mtt_pure::word out[]  )
+void mtt_pure::any_col( mtt_pure::wordMatrix in, mtt_pure::word m, mtt_pure::word n, mtt_pure::word out[]  )
 {
     mtt_pure::word i,j;
     for( j=0; j<n; j++ ) {
@@ -2212,7 +2723,7 @@ void mtt_pure::any_col( mtt_pure::word in[][MAX_N], mtt_pure::word m, mtt_pure::
     }
 }
 
-void mtt_pure::find( mtt_pure::word in[][MAX_N], mtt_pure::word m, mtt_pure::word n, mtt_pure::word *r, mtt_pure::word *s )
+void mtt_pure::find( mtt_pure::wordMatrix in, mtt_pure::word m, mtt_pure::word n, mtt_pure::word *r, mtt_pure::word *s )
 {
     mtt_pure::word i,j;
     *r = -1;
@@ -2237,7 +2748,7 @@ mtt_pure::word mtt_pure::find_vec( mtt_pure::word in[], mtt_pure::word n ) {
 }
 */
 
-void mtt_pure::copy_row ( mtt_pure::word in[][MAX_N], mtt_pure::word m, mtt_pure::word n, mtt_pure::word out[] )
+void mtt_pure::copy_row ( mtt_pure::wordMatrix in, mtt_pure::word m, mtt_pure::word n, mtt_pure::word out[] )
 {
     mtt_pure::word i;
     for (i=0; i<n; i++) {
@@ -2245,7 +2756,7 @@ void mtt_pure::copy_row ( mtt_pure::word in[][MAX_N], mtt_pure::word m, mtt_pure
     }
 }
 
-void mtt_pure::copy_col ( mtt_pure::word in[][MAX_N], mtt_pure::word m, mtt_pure::word n, mtt_pure::word out[] )
+void mtt_pure::copy_col ( mtt_pure::wordMatrix in, mtt_pure::word m, mtt_pure::word n, mtt_pure::word out[] )
 {
     mtt_pure::word i;
     for (i=0; i<m; i++) {
@@ -2253,7 +2764,7 @@ void mtt_pure::copy_col ( mtt_pure::word in[][MAX_N], mtt_pure::word m, mtt_pure
     }
 }
 
-mtt_pure::real mtt_pure::find_min ( mtt_pure::real in[][MAX_N], mtt_pure::word m, mtt_pure::word n )
+mtt_pure::real mtt_pure::find_min ( mtt_pure::realMatrix in, mtt_pure::word m, mtt_pure::word n )
 {
     mtt_pure::word i, j;
     mtt_pure::real val = FLT_MAX;
@@ -2266,7 +2777,7 @@ mtt_pure::real mtt_pure::find_min ( mtt_pure::real in[][MAX_N], mtt_pure::word m
     return val;
 }
 
-void mtt_pure::extract_valid( mtt_pure::real in[][MAX_N], mtt_pure::word row_sel[], mtt_pure::word col_sel[], mtt_pure::real out[][MAX_N], mtt_pure::word m, mtt_pure::word n)
+void mtt_pure::extract_valid( mtt_pure::realMatrix in, mtt_pure::word row_sel[], mtt_pure::word col_sel[], mtt_pure::realMatrix out, mtt_pure::word m, mtt_pure::word n)
 {
     mtt_pure::word i,j, i_out, j_out;
     i_out = 0;
@@ -2284,7 +2795,7 @@ void mtt_pure::extract_valid( mtt_pure::real in[][MAX_N], mtt_pure::word row_sel
     }
 }
 
-void mtt_pure::extract_not_valid( mtt_pure::real in[][MAX_N], mtt_pure::word row_sel[], word col_sel[], mtt_pure::word m, mtt_pure::word n, mtt_pure::real out[][MAX_N], mtt_pure::word *r, mtt_pure::word *c)
+void mtt_pure::extract_not_valid( mtt_pure::realMatrix in, mtt_pure::word row_sel[], word col_sel[], mtt_pure::word m, mtt_pure::word n, mtt_pure::realMatrix out, mtt_pure::word *r, mtt_pure::word *c)
 {
     UNUSED(m);
 
@@ -2307,7 +2818,7 @@ void mtt_pure::extract_not_valid( mtt_pure::real in[][MAX_N], mtt_pure::word row
     *c = j_out;
 }
 
-void mtt_pure::insert_to_not_valid( mtt_pure::real in[][MAX_N], mtt_pure::word m, mtt_pure::word n, mtt_pure::real out[][MAX_N], mtt_pure::word row_sel[], mtt_pure::word col_sel[] )
+void mtt_pure::insert_to_not_valid( mtt_pure::realMatrix in, mtt_pure::word m, mtt_pure::word n, mtt_pure::realMatrix out, mtt_pure::word row_sel[], mtt_pure::word col_sel[] )
 {
     mtt_pure::word i,j, i_in, j_in;
     i_in = 0; i=0;
@@ -2327,7 +2838,7 @@ void mtt_pure::insert_to_not_valid( mtt_pure::real in[][MAX_N], mtt_pure::word m
     }
 }
 
-void mtt_pure::insert_to_valid( mtt_pure::word in[][MAX_N], mtt_pure::word m, mtt_pure::word n, word out[][MAX_N], mtt_pure::word row_sel[], mtt_pure::word col_sel[] )
+void mtt_pure::insert_to_valid( mtt_pure::wordMatrix in, mtt_pure::word m, mtt_pure::word n, mtt_pure::wordMatrix out, mtt_pure::word row_sel[], mtt_pure::word col_sel[] )
 {
     mtt_pure::word i,j, i_in, j_in;
     i_in = 0; i = 0;
@@ -2374,6 +2885,10 @@ void mtt_pure::insert_to_valid( mtt_pure::word in[][MAX_N], mtt_pure::word m, mt
 float *mtt_pure::exponential_bg_subtraction(float *data_in, int ch, float exp_factor)
 {
     int k;
+    ir_buffers * buf = irBuffers();
+    float (*IR_buffer)[SCANLENGHT] = buf->IR_buffer;
+    float * bg_estimation = buf->bg_estimation;
+    float * data_out = buf->data_out;
 
     /*    if (start_ex_av != 0) {
         start_ex_av = 0;
@@ -2402,6 +2917,12 @@ int *mtt_pure::detector_cfar(float *inptr, int *outptr, float beta_fast, float b
       int i;
     //   int* outptr;
        float  X_initial, Y_initial, S_2_initial;
+       ir_buffers * buf = irBuffers();
+       float * data = buf->data;
+       float * tmp = buf->tmp;
+       float * X = buf->X;
+       float * Y = buf->Y;
+       float * S_2 = buf->S_2;
 
 
 
@@ -2481,6 +3002,155 @@ int *mtt_pure::detector_cfar(float *inptr, int *outptr, float beta_fast, float b
     return outptr;
 }
 
+void mtt_pure::bg_subtraction_2ch(float *IR, float exp_factor)
+{
+    int k, ch;
+    float bg;
+    float new_factor = (float) (1.0-exp_factor);
+    ir_buffers * buf = irBuffers();
+
+    /*
+     * The same computation as in exponential_bg_subtraction, but background estimation, subtraction and copy
+     * back to input are done in one pass over both channels. Results are identical.
+     */
+    for( ch=0; ch<2; ch++ ) {
+        float * data = &IR[ch*SCANLENGHT];
+        float * IR_buffer = buf->IR_buffer[ch];
+
+        k = 0;
+    #if defined (MTT_SSE2)
+        __m128 v_new = _mm_set1_ps( new_factor );
+        __m128 v_exp = _mm_set1_ps( exp_factor );
+        for( ; k+4<=SCANLENGHT; k+=4 ) {
+            __m128 v_in = _mm_loadu_ps( &data[k] );
+            __m128 v_bg = _mm_add_ps( _mm_mul_ps( v_in, v_new ), _mm_mul_ps( v_exp, _mm_loadu_ps( &IR_buffer[k] ) ) );
+            _mm_storeu_ps( &IR_buffer[k], v_bg );
+            _mm_storeu_ps( &data[k], _mm_sub_ps( v_in, v_bg ) );
+        }
+    #endif
+        for( ; k<SCANLENGHT; k++ ) {
+            bg = data[k] * new_factor + exp_factor*IR_buffer[k];
+            IR_buffer[k] = bg;
+            data[k] = data[k] - bg;
+        }
+    }
+}
+
+void mtt_pure::detector_cfar_2ch(float *IR, det_map *out_det, float beta_fast, float beta_slow, float alpha_det)
+{
+    int i, ch;
+    float mag, X, Y, S_2;
+    float a_fast = 1-beta_fast;
+    float a_slow = 1-beta_slow;
+
+    /*
+     * detector_cfar evaluates three first order filters
+     *     X(i+1) = beta_fast*|x(i)| + (1-beta_fast)*X(i)
+     *     Y(i+1) = beta_slow*|x(i+1)| + (1-beta_slow)*Y(i)
+     *     S_2(i+1) = beta_slow*x(i+1)^2 + (1-beta_slow)*S_2(i)
+     * in separate passes and compares X with alpha*sqrt(S_2)+Y. Here all is done in one pass. With SSE, four samples of
+     * each filter are computed at once as blocked scan: inside of block y(j) = b(j) + a*b(j-1) + a^2*b(j-2) + ... is
+     * obtained by two shifted multiply-adds and the output of previous block is added multiplied by [a a^2 a^3 a^4].
+     * Summation order differs from sequential filters, so filter outputs differ by at most CFAR_2CH_TOLERANCE (relative)
+     * and detections may differ only for samples this close to the threshold. Detections are written directly as runs
+     * (see 'det_map'), the first 5 samples are never detected.
+     */
+    for( ch=0; ch<2; ch++ ) {
+        float * data = &IR[ch*SCANLENGHT];
+        det_map * map = &out_det[ch];
+
+        map->count = 0;
+
+        // initial values, the same as in detector_cfar
+        X = Y = S_2 = 0;
+        for( i=0; i<200; i++ ) {
+            mag = (float) fabs( data[i] );
+            X = beta_fast*mag + a_fast*X;
+            Y = beta_slow*mag + a_slow*Y;
+            S_2 = beta_slow*(mag*mag) + a_slow*S_2;
+        }
+
+        // the first 5 samples never produce detection, filters only run through them
+        for( i=1; i<5; i++ ) {
+            mag = (float) fabs( data[i] );
+            X = beta_fast*(float)fabs( data[i-1] ) + a_fast*X;
+            Y = beta_slow*mag + a_slow*Y;
+            S_2 = beta_slow*(mag*mag) + a_slow*S_2;
+        }
+
+        i = 5;
+    #if defined (MTT_SSE2)
+        int k, mask;
+        const __m128 v_sign = _mm_set1_ps( -0.0f );
+        const __m128 v_bf = _mm_set1_ps( beta_fast );
+        const __m128 v_bs = _mm_set1_ps( beta_slow );
+        const __m128 v_alpha = _mm_set1_ps( alpha_det );
+        const __m128 v_af1 = _mm_set1_ps( a_fast );
+        const __m128 v_af2 = _mm_set1_ps( a_fast*a_fast );
+        const __m128 v_afc = _mm_setr_ps( a_fast, a_fast*a_fast, a_fast*a_fast*a_fast, a_fast*a_fast*a_fast*a_fast );
+        const __m128 v_as1 = _mm_set1_ps( a_slow );
+        const __m128 v_as2 = _mm_set1_ps( a_slow*a_slow );
+        const __m128 v_asc = _mm_setr_ps( a_slow, a_slow*a_slow, a_slow*a_slow*a_slow, a_slow*a_slow*a_slow*a_slow );
+
+        __m128 v_X = _mm_set1_ps( X );
+        __m128 v_Y = _mm_set1_ps( Y );
+        __m128 v_S_2 = _mm_set1_ps( S_2 );
+        __m128 v_prev = _mm_set1_ps( (float) fabs( data[4] ) );
+
+        for( ; i+4<=SCANLENGHT; i+=4 ) {
+            __m128 v_mag = _mm_andnot_ps( v_sign, _mm_loadu_ps( &data[i] ) );
+            // [|x(i-1)| |x(i)| |x(i+1)| |x(i+2)|] for X filter
+            __m128 v_lag = _mm_shuffle_ps( _mm_shuffle_ps( v_prev, v_mag, _MM_SHUFFLE(0,0,3,3) ), v_mag, _MM_SHUFFLE(2,1,2,0) );
+            __m128 b_X = _mm_mul_ps( v_bf, v_lag );
+            __m128 b_Y = _mm_mul_ps( v_bs, v_mag );
+            __m128 b_S_2 = _mm_mul_ps( v_bs, _mm_mul_ps( v_mag, v_mag ) );
+            v_prev = v_mag;
+
+            // prefix inside of block
+            b_X = _mm_add_ps( b_X, _mm_mul_ps( v_af1, _mm_castsi128_ps( _mm_slli_si128( _mm_castps_si128( b_X ), 4 ) ) ) );
+            b_Y = _mm_add_ps( b_Y, _mm_mul_ps( v_as1, _mm_castsi128_ps( _mm_slli_si128( _mm_castps_si128( b_Y ), 4 ) ) ) );
+            b_S_2 = _mm_add_ps( b_S_2, _mm_mul_ps( v_as1, _mm_castsi128_ps( _mm_slli_si128( _mm_castps_si128( b_S_2 ), 4 ) ) ) );
+            b_X = _mm_add_ps( b_X, _mm_mul_ps( v_af2, _mm_castsi128_ps( _mm_slli_si128( _mm_castps_si128( b_X ), 8 ) ) ) );
+            b_Y = _mm_add_ps( b_Y, _mm_mul_ps( v_as2, _mm_castsi128_ps( _mm_slli_si128( _mm_castps_si128( b_Y ), 8 ) ) ) );
+            b_S_2 = _mm_add_ps( b_S_2, _mm_mul_ps( v_as2, _mm_castsi128_ps( _mm_slli_si128( _mm_castps_si128( b_S_2 ), 8 ) ) ) );
+
+            // contribution of previous block
+            v_X = _mm_add_ps( b_X, _mm_mul_ps( v_afc, v_X ) );
+            v_Y = _mm_add_ps( b_Y, _mm_mul_ps( v_asc, v_Y ) );
+            v_S_2 = _mm_add_ps( b_S_2, _mm_mul_ps( v_asc, v_S_2 ) );
+
+            __m128 v_thr = _mm_add_ps( _mm_mul_ps( v_alpha, _mm_sqrt_ps( v_S_2 ) ), v_Y );
+            mask = _mm_movemask_ps( _mm_cmpgt_ps( v_X, v_thr ) );
+            if( mask == 0xF ) {
+                add_run( map, i, i+4, 1 );
+            }
+            else if( mask != 0 ) {
+                for( k=0; k<4; k++ )
+                    if( mask & (1<<k) ) add_run( map, i+k, i+k+1, 1 );
+            }
+
+            // last sample of block is the initial value of the next one
+            v_X = _mm_shuffle_ps( v_X, v_X, _MM_SHUFFLE(3,3,3,3) );
+            v_Y = _mm_shuffle_ps( v_Y, v_Y, _MM_SHUFFLE(3,3,3,3) );
+            v_S_2 = _mm_shuffle_ps( v_S_2, v_S_2, _MM_SHUFFLE(3,3,3,3) );
+        }
+
+        X = _mm_cvtss_f32( v_X );
+        Y = _mm_cvtss_f32( v_Y );
+        S_2 = _mm_cvtss_f32( v_S_2 );
+    #endif
+
+        // remaining samples (all samples without SSE)
+        for( ; i<SCANLENGHT; i++ ) {
+            mag = (float) fabs( data[i] );
+            X = beta_fast*(float)fabs( data[i-1] ) + a_fast*X;
+            Y = beta_slow*mag + a_slow*Y;
+            S_2 = beta_slow*(mag*mag) + a_slow*S_2;
+            if( X > (float) (alpha_det*sqrt(S_2) + Y) ) add_run( map, i, i+1, 1 );
+        }
+    }
+}
+
 void mtt_pure::TOA_couple(mtt_pure::word max_nn_tg, mtt_pure::word center[][3], mtt_pure::word m, mtt_pure::real TOA_m[][MAX_N])
 {
     UNUSED(max_nn_tg);
@@ -19,9 +19,18 @@
 #include <math.h>
 #include <float.h>
 #include <limits.h>
+// SSE2 paths can be switched off (DEFINES += MTT_NO_SSE2), so the scalar form of the same algorithms can be built and measured
+#if defined (__SSE2__) && !defined (MTT_NO_SSE2)
+#define MTT_SSE2
+#include <emmintrin.h>
+#endif
 #include <QDebug>
 
 #include "stddefs.h"
+#include "targetcapacity.h"
+#include "mttstorage.h"
+#include "mttsnapshot.h"
+#include "batchlocalization.h"
 
 #define UNUSED(x) (void)x
 
@@ -29,8 +38,13 @@
 //#define MAX_N               (10)        // max dimension of cost matrix in Munkres algorithm
                                         // (max number of targets)
 #define EMPTY               (-1)
-#define TRUE                (1)
-#define FALSE               (0)
+// the same tokens as in uwbpacketclass.h (and windows.h), so including both headers does not redefine them
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
 
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 
@@ -38,10 +52,15 @@
 #define SCANLENGHT        (4095)        // length of processed m-sequence
 #define CH_NUMBER            (2)        // number of channels
 #define SA                   (5)        // Software averaging
+#define MAX_SA              (16)        // max. number of scans averaged by streaming software averaging (see 'mtt_pure::average')
+#define SA_REFRESH        (1024)        // running sum of software averaging is recomputed from ring after this number of scans
 #define HA                 (256)        // Hardware averaging
 #define uS                 (512)        // subsampling
 
 #define LARGE_NUMBER       (100)        // arbitrary large value ...
+#define CFAR_2CH_TOLERANCE (1e-5)       // max. relative difference of detector_cfar_2ch filters from sequential detector_cfar
+#define GATE_SIGMA           (3)        // "3 sigma rule" used by gate_checker
+#define GRID_GATING_PAIRS   (64)        // minimal number of observation x track pairs for which grid pre-gating is used
 #define MIN_Y_COORDINATE  (0.02)        // points [x,y] with y<MIN_Y_COORDINATE => [0,0]
 
 #define INDEX_CORRECTION     (1)        // to compensate Matlab indexing from 1
@@ -61,32 +80,229 @@
 #define MTT_TRACK             (0)       // process all other IRs
 
 
+/**
+ * @brief Run of samples with the same nonzero value in detection map, samples from 'begin' up to 'end'-1.
+ */
+struct det_run {
+    int begin;
+    int end;
+    int value;      // 1 for detections, 1 or 2 (receiver) for first reflections, 1, 2 or 3 for connected traces
+};
+
+/**
+ * @brief Run-length encoded detection map of one scan.
+ *
+ * Detector output and all following maps of trace connection are mostly zeros with only a few short groups of ones, so they
+ * are stored as sorted runs. Neighbouring runs with the same value are always merged (see 'mtt_pure::add_run'), so the map
+ * has unique representation. Processing of such maps takes time proportional to the number of runs, not to SCANLENGHT.
+ */
+struct det_map {
+    int count;                         // number of valid runs
+    det_run run[ SCANLENGHT ];         // each run is at least one sample long, so SCANLENGHT runs is always enough
+};
+
+/**
+ * @brief Buffers required only by raw impulse response processing (background subtraction, CFAR detector, trace connection).
+ *
+ * These are several SCANLENGHT long vectors (about 300 KB together, but run-length maps are touched only up to their
+ * 'count') while the coordinate tracker itself needs only a few kilobytes. Therefore they are kept separately and allocated
+ * only if raw data are really processed.
+ */
+struct ir_buffers {
+    int center_previous[MAX_N][3];     // temporary memory between scans
+    float TOA_m[2][MAX_N];
+
+    float tmp[ SCANLENGHT ];           // temporary vector storage
+    float data[ SCANLENGHT ];          // temporary vector storage
+    float X[ SCANLENGHT ];             // temporary vector storage
+    float Y[ SCANLENGHT  ];            // temporary vector storage
+    float S_2[ SCANLENGHT ];           // temporary vector storage
+
+    float IR_buffer[2][ SCANLENGHT ];
+    float bg_estimation[ SCANLENGHT ];
+    float data_out[ SCANLENGHT ];
+
+    det_map det[2];                    // CFAR detector output of both channels
+    det_map int_IR;                    // integrated detector output of one channel
+    det_map first_reflection[2];       // point targets of both channels
+    det_map TC;                        // connected traces of both channels
+    float TOA_mem[ 2*MAX_N ];          // TOA couples and later [x, y] positions of detected targets
+};
+
+/**
+ * @brief Ring of the last scans used by streaming software averaging.
+ *
+ * Memory is allocated for MAX_SA scans at once (about 520 KB), so the number of averaged scans can be changed at runtime
+ * without reallocation. Running sum is updated by adding the new scan and subtracting the oldest one.
+ */
+struct sa_buffers {
+    float ring[ MAX_SA ][ 2*SCANLENGHT ];  // last scans of both channels
+    float sum[ 2*SCANLENGHT ];             // sum of all scans in ring
+    int count;                             // number of averaged scans (ring length)
+    int hop;                               // averaged scan is produced every 'hop' scans
+    int filled;                            // number of valid scans in ring
+    int next;                              // ring slot for the next scan
+    int since_output;                      // scans pushed since the last averaged scan
+    int since_refresh;                     // scans pushed since the running sum was recomputed
+};
+
 class mtt_pure
 {
 public:
-    mtt_pure();
+    /**
+     * @brief Creates tracker for required number of targets.
+     * @param[in] capacity Maximum number of targets (and observations) tracker can handle. See 'fitTargetCapacity' for capacity actually used.
+     * @param[in] model State vector used by Kalman filters. With MTT_CARTESIAN_STATE parameters of MTT function are interpreted in cartesian coordinates (see 'MTT').
+     */
+    mtt_pure(int capacity = MAX_N, mtt_state_model model = MTT_POLAR_STATE);
     ~mtt_pure();
 
+    /**
+     * @brief Runs one MTT iteration.
+     * @param[in,out] P_mem Array of [x, y] observations. Must contain 'getCapacity()*2' values, unused positions must be zeroed. Estimated positions are written back.
+     * @param[in] r Measurement noise variances, [range, angle] for polar model, [x, y] for cartesian model.
+     * @param[in] q Process noise variances of state vector, [r, dr, fi, dfi] for polar model, [x, dx, y, dy] for cartesian model.
+     * @param[in] dif_d Maximum range difference (polar) or x difference (cartesian) of observations considered as the same new target.
+     * @param[in] dif_fi Maximum angle difference (polar) or y difference (cartesian) of observations considered as the same new target.
+     * @return The return value is 'P_mem' or NULL if 'P_mem' is NULL.
+     */
     float* MTT(float* P_mem,float r[], float q[],float dif_d,float dif_fi, int min_OLGI,int min_NTI);
 
+    /**
+     * @brief Runs complete detection chain (background subtraction, CFAR detector, trace connection, localization) on one scan of raw impulse responses.
+     * @param[in,out] IR Impulse responses of channel 1 and channel 2, SCANLENGHT samples each. Background is subtracted in place.
+     * @param[in] params Parameters of detection chain.
+     * @param[out] P_mem Array for MAX_N [x, y] positions of detected targets. Positions after the last detected target are zeroed.
+     * @return Number of detected targets.
+     *
+     * Background estimation and traces from previous scan are kept by the object, so each radar must use its own
+     * 'mtt_pure' object for detection.
+     */
+    int detect(float * IR, const ir_detection_parameters * params, float * P_mem);
+
+    /**
+     * @brief Runs detection chain without localization, so TOA couples of many radars can be localized together (see 'batchLocalization').
+     * @param[in,out] IR Impulse responses of channel 1 and channel 2, SCANLENGHT samples each. Background is subtracted in place.
+     * @param[in] params Parameters of detection chain, antenna positions are not used.
+     * @param[out] TOA_mem Array for MAX_N [d1, d2] TOA couples in meters. Positions after the last couple are zeroed.
+     * @return Number of TOA couples.
+     */
+    int detectTOA(float * IR, const ir_detection_parameters * params, float * TOA_mem);
+
+    /**
+     * @brief Sets streaming software averaging placed ahead of detection chain. Can be changed at any time, buffers are never reallocated.
+     * @param[in] count Number of averaged scans (1 up to MAX_SA), 1 switches averaging off.
+     * @param[in] hop Averaged scan is produced every 'hop' scans (1 up to 'count'). With hop equal to 1 moving average is produced
+     *                for each scan, with hop equal to count the output rate is reduced 'count' times.
+     *
+     * Averaging of N scans improves SNR of uncorrelated noise N times. Scans collected so far are dropped when settings change,
+     * calling the function with current settings has no effect.
+     */
+    void setAveraging(int count, int hop);
+
+    /**
+     * @brief Returns the number of averaged scans.
+     * @return Number of scans, 1 if averaging is off.
+     */
+    int getAveragingCount(void) { return (sa==NULL) ? 1 : sa->count; }
+
+    /**
+     * @brief Returns how often averaged scan is produced.
+     * @return Number of scans between two averaged scans, 1 if averaging is off.
+     */
+    int getAveragingHop(void) { return (sa==NULL) ? 1 : sa->hop; }
+
+    /**
+     * @brief Pushes scan into software averaging ring.
+     * @param[in,out] IR Impulse responses of channel 1 and channel 2, SCANLENGHT samples each. Replaced by averaged scan if function returns true.
+     * @return The return value is true if averaged scan is ready in IR and should be passed to 'detect', false if scan was only stored.
+     */
+    bool average(float * IR);
+
+    /**
+     * @brief Returns the number of targets tracker was created for.
+     * @return Capacity of tracker (length of 'P_mem' array passed to MTT is twice this value).
+     */
+    int getCapacity(void) { return capacity; }
+
+    /**
+     * @brief Returns the state model tracker was created for.
+     * @return State model of Kalman filters.
+     */
+    mtt_state_model getStateModel(void) { return stateModel; }
+
+    /**
+     * @brief Returns the number of active tracks. Estimated positions of tracks are the first values written back into 'P_mem' by 'MTT'.
+     * @return Number of tracks, 0 until tracking is started.
+     */
+    int getTracksCount(void) { return (start==MTT_TRACK) ? nn_track : 0; }
+
+    /**
+     * @brief Returns identifiers of active tracks. Identifier is assigned when track is started and stays the same for its whole
+     * life, although the position of track in 'P_mem' changes when other tracks are dropped. Identifiers are not reused.
+     * @return Array of 'getTracksCount()' identifiers, i-th identifier belongs to i-th position in 'P_mem'. Valid until the next 'MTT' call.
+     */
+    const int * getTrackIds(void) { return ID; }
+
+    /**
+     * @brief Reinitializes tracker in place. All tracks are dropped and the next MTT call starts from initialization state. No memory is reallocated.
+     */
+    void reset(void);
+
+    /**
+     * @brief Creates snapshot of complete tracker state (only active tracks are stored).
+     * @return Pointer to newly allocated snapshot. Caller is responsible for its deletion.
+     */
+    mttSnapshot * saveState(void);
+
+    /**
+     * @brief Restores tracker state from snapshot, so tracking continues without initialization phase.
+     * @param[in] snapshot Snapshot created by 'saveState', possibly by tracker with different capacity. Tracks exceeding capacity are dropped.
+     * @return The return value is false if snapshot is not valid. Tracker is reset in such case.
+     */
+    bool restoreState(const mttSnapshot * snapshot);
+
+    /*
+     * Steps of 'detect' chain. Per-channel functions are the reference implementation, '_2ch' functions are used by 'detect'.
+     * They are public so both can be compared on the same scans (see benchmarks/rawdetection).
+     */
+    float *exponential_bg_subtraction (float* data_in, int ch, float exp_factor);
+    int *detector_cfar( float *inptr,int* outptr, float beta_fast, float beta_slow, float alpha_det );
+    void bg_subtraction_2ch( float *IR, float exp_factor );     // exponential_bg_subtraction of both channels in one pass, identical results
+    void detector_cfar_2ch( float *IR, det_map *out_det, float beta_fast, float beta_slow, float alpha_det ); // detector_cfar of both channels in one pass producing run-length maps, see CFAR_2CH_TOLERANCE
+
 private:
     typedef float   real;                   // use 32-bit float format
     //typedef double  real;                 // use 64-bit double format (not tested!)
     typedef int     word;                   // use 32-bit integer format
 
-    int center_previous[MAX_N][3];   // temporary memory between scans
-    int out_det[2][SCANLENGHT];
-    real TOA_m[2][MAX_N];
+    typedef capacityMatrix<real> realMatrix;
+    typedef capacityMatrix<word> wordMatrix;
 
-    float tmp[ SCANLENGHT ];           // temporary vector storage
-    float data[ SCANLENGHT ];          // temporary vector storage
-    float X[ SCANLENGHT ];             // temporary vector storage
-    float Y[ SCANLENGHT  ];            // temporary vector storage
-    float S_2[ SCANLENGHT ];           // temporary vector storage
+    int capacity;                      // number of targets, all target arrays below are sized according to this value
+    mtt_state_model stateModel;        // polar or cartesian state vector
+    mttStorageBase * storage;          // owner of all target arrays
 
-    float IR_buffer[2][ SCANLENGHT ];
-    float bg_estimation[ SCANLENGHT ];
-    float data_out[ SCANLENGHT ];
+    /**
+     * @brief Creates storage for the smallest fixed capacity able to hold 'capacity' targets or dynamic one if no such exists.
+     * @param[in] capacity Required number of targets.
+     * @return Pointer to newly allocated storage.
+     */
+    static mttStorageBase * createStorage(int capacity);
+
+    ir_buffers * ir;                   // raw impulse response processing state, NULL until first raw function is used
+
+    /**
+     * @brief Returns raw impulse response buffers. They are allocated on the first call, so trackers working only with coordinates never pay for them.
+     * @return Pointer to buffers owned by tracker.
+     */
+    ir_buffers * irBuffers(void);
+
+    batchLocalization * localization;  // localization of detected TOA couples, NULL until the first 'detect' call
+
+    sa_buffers * sa;                   // software averaging ring, NULL until averaging of more than one scan is requested
+
+    void sa_clear(void);               // drops all scans from software averaging ring
 
     /* MTT variables and arrays */
     real P_init[4][4];
@@ -96,26 +312,30 @@ private:
     real Q[4][4];
 
 
-    real Z[MAX_N][2];
-    real Y_p[MAX_N][4];
-    real P_p[MAX_N][4][4];
-    real K[MAX_N][4][2];
-    real Y_e[MAX_N][4];
-    real P_e[MAX_N][4][4];
-    word M[MAX_N][MAX_N];
-    word MA[MAX_N][MAX_N];
-    real C[MAX_N][MAX_N];
-    real P[2][MAX_N];
-    real T[2][MAX_N];
+    /* arrays sized by capacity, they point into 'storage' */
+    real (*Z)[2];
+    real (*Y_p)[4];
+    real (*P_p)[4][4];
+    real (*K)[4][2];
+    real (*Y_e)[4];
+    real (*P_e)[4][4];
+    wordMatrix M;
+    wordMatrix MA;
+    realMatrix C;
+    realMatrix P;
+    realMatrix T;
 
     word NTI[3];
     real last_obs[2][3];
-    word OLGI[MAX_N];
+    word * OLGI;
+    word * ID;                         // identifier of track in each slot
+    word next_ID;                      // identifier of the next started track
     word nn_obs, obs, start_im, nn_track;
     word start;
     int start_ex_av; // this start was defined as static in original C library, here it is replaced with start_ex_av in 'exponential_bg_subtraction' function
 
     /* supporting functions */
+    void new_track_ID( word track ) { ID[track] = next_ID; next_ID = (next_ID==INT_MAX) ? 0 : next_ID+1; }   // assigns identifier to track started in slot
     real mean_vector( real *inptr, word samples);
     real std_vector( real *inptr, word samples);
     real max_vector( real *inptr, word samples);
@@ -132,20 +352,23 @@ private:
     void matrix_transpose_4x4( real out[][4], real in[][4] );
     void matrix_add_4x4( real c[][4], real a[][4], real b[][4] );
     void cartesian2polar( real x, real y, real *r, real *fi);
+    void to_observation( real x, real y, real *z1, real *z2 );   // converts cartesian input into observation of selected state model
     void connected_covering (word value_ch_b, word ch, word cover_b, word w, word trace_con[], word c[]); // ???? definition not found in original C library
-    void munkres( real costMat[][MAX_N], word rows, word cols, real *cost, word assign[][MAX_N] );
+    void munkres( realMatrix costMat, word rows, word cols, real *cost, wordMatrix assign );
     void correction ( real Y_e[], real *P_e, real Y_p[], real *P_p, real r, real fi, real R[][2]);
     void prediction ( real Y_e_p[], real *P_e_p, real Q[][4], real Y_p[], real *P_p );
-    void covering (word value_ch_b, word *ch, word m, word trace_con[], word c[], word *cover_b);
-    void different_values( word trace_con[], word *ch, word m, word value_ch_b, word value_ch_e, word nn_ch, word c[]);
+    void covering (word value_ch_b, word *ch, word m, det_map *trace_con, word c[], word *cover_b);
+    void different_values( det_map *trace_con, word *ch, word m, word value_ch_b, word value_ch_e, word nn_ch, word c[]);
     void gate_checker ( real r, real fi, real Y_p[], real R[][2], real *P_p, word *m, real *c);
+    void grid_gating ( word nn_obs, word nn_track );    // runs gate_checker only for pairs whose observation lies in grid cells covered by track gate
+    word grid_cell ( real value, real min, real size, word g );    // index of grid column (row) containing value, clamped to grid
     void identical_values (word value_ch_b, word *ch, word m, word max_nn_tg, word center_previous[][3], word c[3]);
     void init_estimation (real r, real fi, real Y_e_2_init,real Y_e_4_init,real P_init[][4], real Y_e[], real *P_e);
-    void t_integration( word *inptr, word t_size, word min_int, word nn_ch );
+    void t_integration( det_map *inptr, word t_size, word min_int, word nn_ch, det_map *int_IR );
     void intersection2ellipses(real d0, real d1, real x1, real x2, real *x, real *y);
-    float *trace_connection (int* inptr1,int* inptr2,int* TC,int t_size, int min_int, int m, int max_nn_tg, float* TOA_mem);
-    void trace_connection2 (word out_det[][SCANLENGHT], word t_size, word min_int, word m, word max_nn_tg,
-                           word center_previous[][3], word* TC, real TOA_m[][MAX_N]);
+    float *trace_connection (det_map *out_det, det_map *TC, int t_size, int min_int, int m, int max_nn_tg, float* TOA_mem);
+    void trace_connection2 (det_map *out_det, word t_size, word min_int, word m, word max_nn_tg,
+                           word center_previous[][3], det_map *TC, real TOA_m[][MAX_N]);
     void new_tg_ident ( word nn_NTI, word min_NTI, word NTI[], real r_last_obs[], real fi_last_obs[],
                         real r, real fi, real dif_d, real dif_fi, word nn_track, word cl[], word max_nn_tr,
                         word *new_track, word clearing[]
@@ -153,42 +376,49 @@ private:
     void obs_less_gate_ident (word *OLGI_last,word track, word nn_track, real Y_e_last[], real *P_e_last,
                               real Y_e[], real *P_e, word *OLGI);
     void polar2cartesian (real Y_e[], real *x, real *y);
-    void point_targets(word nn_ch, word int_IR[], word min_int, word m, word rx, word first_reflection[] );
+    void from_estimation (real Y_e[], real *x, real *y);    // converts state estimation of selected state model into cartesian output
+    void point_targets(word nn_ch, det_map *int_IR, word min_int, word m, word rx, det_map *first_reflection );
     float *MT_localization (float* TOA_mem, float x1, float x2);
 
     float *normalizing(float *inptr);
     float *normalizing_new(float *inptr );
-    void connected_reflections(word* ch, word trace_con[],word c[],word m,word* nn_obs);
+    void connected_reflections(word* ch, det_map *trace_con,word c[],word m,word* nn_obs);
+
+    /* run-length detection map support functions */
+    void add_run( det_map *map, word begin, word end, word value );   // appends run, merges it with the last one if they touch and have the same value
+    word find_run( det_map *map, word pos );     // index of the first run which ends after pos
+    word run_value( det_map *map, word pos );    // value of sample at pos (0 outside of runs)
+    word block_end( det_map *map, word pos );    // first zero sample at or after pos
+    word run_boundary( det_map *map, word k );   // k-th boundary of map (begin of the first run, its end, begin of the second run, ...)
+    void connect_traces( det_map *first_reflection, det_map *trace_con );  // trace_con = first_reflection[0] + first_reflection[1]
 
     /* munkres support function */
-    void zeros( real in[][MAX_N], word m, word n );
-    void log_negate(real in[][MAX_N], word m, word n, word out[][MAX_N]);
-    void falses(word in[][MAX_N], word m, word n);
+    void zeros( realMatrix in, word m, word n );
+    void log_negate(realMatrix in, word m, word n, wordMatrix out);
+    void falses(wordMatrix in, word m, word n);
     void falses_vector(word in[], word n);
-    word any(word in[][MAX_N], word m, word n);
+    word any(wordMatrix in, word m, word n);
     word any_vector(word in[], word n);
-    word any_not_selected(word in[][MAX_N], word row_sel[], word col_sel[], word m, word n);
+    word any_not_selected(wordMatrix in, word row_sel[], word col_sel[], word m, word n);
     word any_vector_not_selected(word in[], word m);
-    void any_col(word in[][MAX_N], word m, word n, word out[]);
-    void find(word in[][MAX_N], word m, word n, word *r, word *s);
-    void copy_row(word in[][MAX_N], word m, word n, word out[]);
-    void copy_col(word in[][MAX_N], word m, word n, word out[]);
-    real find_min(real in[][MAX_N], word m, word n);
-    void extract_valid(real in[][MAX_N], word row_sel[], word col_sel[], real out[][MAX_N], word m, word n);
-    void extract_not_valid(real in[][MAX_N], word row_sel[], word col_sel[], word m, word n, real out[][MAX_N], word *r, word *c);
-    void insert_to_not_valid(real in[][MAX_N], word m, word n, real out[][MAX_N], word row_sel[], word col_sel[]);
-    void insert_to_valid(word in[][MAX_N], word m, word n, word out[][MAX_N], word row_sel[], word col_sel[]);
+    void any_col(wordMatrix in, word m, word n, word out[]);
+    void find(wordMatrix in, word m, word n, word *r, word *s);
+    void copy_row(wordMatrix in, word m, word n, word out[]);
+    void copy_col(wordMatrix in, word m, word n, word out[]);
+    real find_min(realMatrix in, word m, word n);
+    void extract_valid(realMatrix in, word row_sel[], word col_sel[], realMatrix out, word m, word n);
+    void extract_not_valid(realMatrix in, word row_sel[], word col_sel[], word m, word n, realMatrix out, word *r, word *c);
+    void insert_to_not_valid(realMatrix in, word m, word n, realMatrix out, word row_sel[], word col_sel[]);
+    void insert_to_valid(wordMatrix in, word m, word n, wordMatrix out, word row_sel[], word col_sel[]);
 
     /* radar data processing functions */
-    float *exponential_bg_subtraction (float* data_in, int ch, float exp_factor);
-    int *detector_cfar( float *inptr,int* outptr, float beta_fast, float beta_slow, float alpha_det );
     void trace_online( real *inptr, word ch, word t_size, real thr, word min_integration,                  word h_window, word m, word samples);
     void TOA_couple (word max_nn_tg, word center[][3], word m, real TOA_m[][MAX_N]);
     void InitScan( void );
 
     /* MTT supporting functions */
-    void MTT2 (real P[][MAX_N], real r[], real q[], real dif_d, real dif_fi, word min_OLGI, word min_NTI, real T[][MAX_N], word *start );
-    word find_max ( mtt_pure::word in[][MAX_N], mtt_pure::word row );
+    void MTT2 (realMatrix P, real r[], real q[], real dif_d, real dif_fi, word min_OLGI, word min_NTI, realMatrix T, word *start );
+    word find_max ( mtt_pure::wordMatrix in, mtt_pure::word row );
 };
 
 #endif // MTT_PURE_H
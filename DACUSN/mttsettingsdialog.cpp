@@ -27,6 +27,16 @@ mttsettingsdialog::mttsettingsdialog(uwbSettings *setts, QMutex *settings_mutex,
 
     ui->mttGlobalCheckBox->setChecked(settings->getGlobalRadarMTT());
     ui->mttPerSingleRadarUnitCheckBox->setChecked(settings->getSingleRadarMTT());
+    ui->targetCapacitySpinBox->setMaximum(MAX_TARGET_CAPACITY);
+    ui->targetCapacitySpinBox->setValue(settings->getTargetCapacity());
+    ui->mttWarmStartCheckBox->setChecked(settings->getMTTWarmStart());
+    ui->mttStatePersistentCheckBox->setChecked(settings->getMTTStatePersistent());
+    // combo box item indexes are equal to mtt_state_model values
+    ui->singleRadarMTTModelComboBox->setCurrentIndex((int)(settings->getSingleRadarMTTModel()));
+    ui->globalMTTModelComboBox->setCurrentIndex((int)(settings->getGlobalRadarMTTModel()));
+    // combo box item indexes are equal to fusion_estimator values
+    ui->fusionEstimatorComboBox->setCurrentIndex((int)(settings->getFusionEstimator()));
+    ui->fusionTrimSpinBox->setValue(settings->getFusionTrimFraction());
 
     settingsMutex->unlock();
 
@@ -53,6 +63,17 @@ void mttsettingsdialog::acceptedSlot()
 
     settings->setSingleRadarMTT(ui->mttPerSingleRadarUnitCheckBox->isChecked());
     settings->setGlobalRadarMTT(ui->mttGlobalCheckBox->isChecked());
+    // capacity is read by reciever when data input starts and by radar units when new data are processed
+    settings->setTargetCapacity(ui->targetCapacitySpinBox->value());
+    // warm start is applied by stack manager when data input starts
+    settings->setMTTWarmStart(ui->mttWarmStartCheckBox->isChecked());
+    settings->setMTTStatePersistent(ui->mttStatePersistentCheckBox->isChecked());
+    // radar units change their model with next data, global model is applied when data input starts
+    settings->setSingleRadarMTTModel((mtt_state_model)(ui->singleRadarMTTModelComboBox->currentIndex()));
+    settings->setGlobalRadarMTTModel((mtt_state_model)(ui->globalMTTModelComboBox->currentIndex()));
+    // fusion estimator is applied by stack manager with the next fused frame
+    settings->setFusionEstimator((fusion_estimator)(ui->fusionEstimatorComboBox->currentIndex()));
+    settings->setFusionTrimFraction(ui->fusionTrimSpinBox->value());
 
     settingsMutex->unlock();
 }
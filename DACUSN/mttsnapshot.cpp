@@ -0,0 +1,105 @@
+/**
+ * @file mttsnapshot.cpp
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Definitions of mttSnapshot class methods.
+ *
+ * @section DESCRIPTION
+ *
+ * Serialized snapshot consists of 'mtt_snapshot_header' structure followed by the number of tracks,
+ * MTT_SNAPSHOT_TRACK_SIZE floats for each track, OLGI values of all tracks and identifiers of all tracks. Native byte order is
+ * used, since snapshots are expected to be read on the same machine they were created.
+ *
+ */
+
+#include "mttsnapshot.h"
+
+mttSnapshot::mttSnapshot(int tracks)
+{
+    if(tracks<0) tracks = 0;
+
+    memset(&header, 0, sizeof(mtt_snapshot_header));
+    header.magic = MTT_SNAPSHOT_MAGIC;
+    header.version = MTT_SNAPSHOT_VERSION;
+
+    tracksCount = tracks;
+    tracksData = new float[tracks*MTT_SNAPSHOT_TRACK_SIZE+1];
+    tracksOLGI = new int[tracks+1];
+    tracksID = new int[tracks+1];
+}
+
+mttSnapshot::mttSnapshot(const mttSnapshot &other)
+{
+    header = other.header;
+
+    tracksCount = other.tracksCount;
+    tracksData = new float[tracksCount*MTT_SNAPSHOT_TRACK_SIZE+1];
+    tracksOLGI = new int[tracksCount+1];
+    tracksID = new int[tracksCount+1];
+
+    memcpy(tracksData, other.tracksData, tracksCount*MTT_SNAPSHOT_TRACK_SIZE*sizeof(float));
+    memcpy(tracksOLGI, other.tracksOLGI, tracksCount*sizeof(int));
+    memcpy(tracksID, other.tracksID, tracksCount*sizeof(int));
+}
+
+mttSnapshot::~mttSnapshot()
+{
+    delete [] tracksData;
+    delete [] tracksOLGI;
+    delete [] tracksID;
+}
+
+int mttSnapshot::getSerializedSize() const
+{
+    return sizeof(mtt_snapshot_header) + sizeof(int) + tracksCount*(MTT_SNAPSHOT_TRACK_SIZE*sizeof(float) + 2*sizeof(int));
+}
+
+void mttSnapshot::serialize(char *buffer) const
+{
+    memcpy(buffer, &header, sizeof(mtt_snapshot_header));
+    buffer += sizeof(mtt_snapshot_header);
+
+    memcpy(buffer, &tracksCount, sizeof(int));
+    buffer += sizeof(int);
+
+    memcpy(buffer, tracksData, tracksCount*MTT_SNAPSHOT_TRACK_SIZE*sizeof(float));
+    buffer += tracksCount*MTT_SNAPSHOT_TRACK_SIZE*sizeof(float);
+
+    memcpy(buffer, tracksOLGI, tracksCount*sizeof(int));
+    buffer += tracksCount*sizeof(int);
+
+    memcpy(buffer, tracksID, tracksCount*sizeof(int));
+}
+
+mttSnapshot *mttSnapshot::deserialize(const char *buffer, int size)
+{
+    if(buffer==NULL || size<(int)(sizeof(mtt_snapshot_header) + sizeof(int))) return NULL;
+
+    mtt_snapshot_header h;
+    int tracks;
+
+    memcpy(&h, buffer, sizeof(mtt_snapshot_header));
+    memcpy(&tracks, buffer + sizeof(mtt_snapshot_header), sizeof(int));
+
+    // check if the buffer really contains snapshot of known version
+    if(h.magic!=MTT_SNAPSHOT_MAGIC || h.version!=MTT_SNAPSHOT_VERSION) return NULL;
+    if(tracks<0 || tracks!=h.nn_track) return NULL;
+
+    // tracks count comes from file, so it is checked against data size before anything is allocated (64 bit, no overflow)
+    long long required = (long long)(sizeof(mtt_snapshot_header) + sizeof(int))
+            + (long long)(tracks)*(MTT_SNAPSHOT_TRACK_SIZE*sizeof(float) + 2*sizeof(int));
+    if((long long)(size)<required) return NULL; // truncated or corrupted data
+
+    mttSnapshot * snapshot = new mttSnapshot(tracks);
+
+    snapshot->header = h;
+
+    buffer += sizeof(mtt_snapshot_header) + sizeof(int);
+    memcpy(snapshot->tracksData, buffer, tracks*MTT_SNAPSHOT_TRACK_SIZE*sizeof(float));
+    buffer += tracks*MTT_SNAPSHOT_TRACK_SIZE*sizeof(float);
+    memcpy(snapshot->tracksOLGI, buffer, tracks*sizeof(int));
+    buffer += tracks*sizeof(int);
+    memcpy(snapshot->tracksID, buffer, tracks*sizeof(int));
+
+    return snapshot;
+}
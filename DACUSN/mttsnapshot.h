@@ -0,0 +1,140 @@
+/**
+ * @file mttsnapshot.h
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Compact copy of complete MTT tracker state.
+ *
+ * @section DESCRIPTION
+ *
+ * After reset, mtt_pure starts in START_MTT_INIT state and skips SKIP_IR scans before
+ * any target is tracked. The 'mttSnapshot' object holds everything the tracker needs
+ * to continue exactly where it stopped: state of finite state machine, new target identification
+ * counters, last observations and estimations/covariances/OLGI of all active tracks. Snapshots
+ * are taken when data input is stopped and applied again when it is started. They can also be
+ * serialized into the byte buffer and stored on disk, so they can be used as reproducible
+ * checkpoints for offline testing.
+ *
+ */
+
+#ifndef MTTSNAPSHOT_H
+#define MTTSNAPSHOT_H
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MTT_SNAPSHOT_MAGIC      (0x5354544D)    ///< "MTTS" identifier at the beginning of each serialized snapshot
+#define MTT_SNAPSHOT_VERSION    (3)             ///< Version of serialized snapshot layout
+#define MTT_SNAPSHOT_TRACK_SIZE (20)            ///< Number of floats stored for one track (state estimation 4 + covariance matrix 16)
+
+/**
+ * @brief Fixed part of snapshot. Layout is also used directly as the header of serialized snapshot.
+ */
+struct mtt_snapshot_header
+{
+    int magic; ///< Must be equal to MTT_SNAPSHOT_MAGIC
+    int version; ///< Must be equal to MTT_SNAPSHOT_VERSION
+    int state_model; ///< State model of tracker (see 'mtt_state_model'), snapshot can be restored only by tracker with the same model
+    int fsm_state; ///< State of MTT finite state machine (START_MTT_INIT, WAIT_MTT, ...)
+    int start_im; ///< Remaining number of skipped impulse responses in WAIT_MTT state
+    int nn_track; ///< Number of active tracks
+    int NTI[3]; ///< New target identification counters
+    float last_obs[2][3]; ///< Last observations used by new target identification
+    float P_init[4][4]; ///< Initial covariance matrix for new tracks
+    float Y_e_2_init; ///< Initial velocity estimation of the first coordinate (range or x)
+    float Y_e_4_init; ///< Initial velocity estimation of the second coordinate (angle or y)
+    float R[2][2]; ///< Measurement noise covariance matrix
+    float Q[4][4]; ///< Process noise covariance matrix
+    int next_ID; ///< Identifier of the next started track
+};
+
+class mttSnapshot
+{
+public:
+    /**
+     * @brief Creates empty snapshot able to hold required number of tracks.
+     * @param[in] tracks Number of tracks. Snapshot stores only active tracks, so this is usually much lower than tracker capacity.
+     */
+    mttSnapshot(int tracks);
+    mttSnapshot(const mttSnapshot & other);
+    ~mttSnapshot();
+
+    /**
+     * @brief Provides access to fixed part of snapshot.
+     * @return Pointer to header owned by snapshot.
+     */
+    mtt_snapshot_header * getHeader(void) { return &header; }
+
+    /**
+     * @brief Provides read only access to fixed part of snapshot.
+     * @return Pointer to header owned by snapshot.
+     */
+    const mtt_snapshot_header * getHeader(void) const { return &header; }
+
+    /**
+     * @brief Returns the number of tracks stored in snapshot.
+     * @return Number of tracks.
+     */
+    int getTracksCount(void) const { return tracksCount; }
+
+    /**
+     * @brief Returns pointer to state estimation vector (4 values) of track.
+     * @param[in] track Index of track.
+     * @return Pointer to values.
+     */
+    float * getTrackEstimation(int track) const { return tracksData + track*MTT_SNAPSHOT_TRACK_SIZE; }
+
+    /**
+     * @brief Returns pointer to estimation covariance matrix (4x4 values, row by row) of track.
+     * @param[in] track Index of track.
+     * @return Pointer to values.
+     */
+    float * getTrackCovariance(int track) const { return tracksData + track*MTT_SNAPSHOT_TRACK_SIZE + 4; }
+
+    /**
+     * @brief Returns pointer to observation-less gate identificator of track.
+     * @param[in] track Index of track.
+     * @return Pointer to value.
+     */
+    int * getTrackOLGI(int track) const { return tracksOLGI + track; }
+
+    /**
+     * @brief Returns pointer to identifier of track.
+     * @param[in] track Index of track.
+     * @return Pointer to value.
+     */
+    int * getTrackID(int track) const { return tracksID + track; }
+
+    /**
+     * @brief Returns the number of bytes required by 'serialize' function.
+     * @return Size of serialized snapshot in bytes.
+     */
+    int getSerializedSize(void) const;
+
+    /**
+     * @brief Writes snapshot into buffer.
+     * @param[out] buffer Target buffer, must be at least 'getSerializedSize()' bytes long.
+     */
+    void serialize(char * buffer) const;
+
+    /**
+     * @brief Creates new snapshot from serialized data.
+     * @param[in] buffer Serialized snapshot.
+     * @param[in] size Number of bytes availible in buffer.
+     * @return Pointer to newly allocated snapshot or NULL if buffer does not contain valid snapshot.
+     */
+    static mttSnapshot * deserialize(const char * buffer, int size);
+
+private:
+    mtt_snapshot_header header; ///< Fixed part of snapshot
+    int tracksCount; ///< Number of stored tracks
+    float * tracksData; ///< Estimations and covariances of all tracks, MTT_SNAPSHOT_TRACK_SIZE values per track
+    int * tracksOLGI; ///< Observation-less gate identificators of all tracks
+    int * tracksID; ///< Identifiers of all tracks
+
+    /**
+     * @brief Assignment is not supported, snapshots are copied by copy constructor only. Declared but not defined.
+     */
+    mttSnapshot & operator=(const mttSnapshot & other);
+};
+
+#endif // MTTSNAPSHOT_H
@@ -0,0 +1,196 @@
+/**
+ * @file mttstorage.h
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Storage of all MTT arrays which size depends on the number of targets.
+ *
+ * @section DESCRIPTION
+ *
+ * Class mtt_pure was originally written for fixed MAX_N targets and all arrays were its members.
+ * These arrays are now placed in separate storage object so the tracker capacity can be chosen
+ * when the tracker is created. 'mttStorage<N>' template holds all arrays directly (tight layout for
+ * small N, no indirection besides the row views), 'mttStorage<DYNAMIC_CAPACITY>' specialization
+ * allocates them from 'targetArena' for any capacity. mtt_pure works only with pointers published
+ * by 'mttStorageBase', so the algorithm itself is the same for all storages.
+ *
+ */
+
+#ifndef MTTSTORAGE_H
+#define MTTSTORAGE_H
+
+#include "targetcapacity.h"
+
+#define GRID_CELLS(n)       (3*(n)+1)   ///< Upper bound of cells in pre-gating grid with ceil(sqrt(n)) x ceil(sqrt(n)) cells for n observations
+
+class mttStorageBase
+{
+public:
+    typedef float   real;                   // must match mtt_pure::real
+    typedef int     word;                   // must match mtt_pure::word
+
+    virtual ~mttStorageBase() {}
+
+    /**
+     * @brief Returns the number of targets this storage was created for.
+     * @return Capacity of storage.
+     */
+    int getCapacity(void) { return capacity; }
+
+    /* tracker arrays, first dimension is always target index */
+    real (*Z)[2];
+    real (*Y_p)[4];
+    real (*P_p)[4][4];
+    real (*K)[4][2];
+    real (*Y_e)[4];
+    real (*P_e)[4][4];
+    word * OLGI;
+    word * ID;                          // identifier of track held by each slot, moves together with the track
+
+    capacityMatrix<word> M;
+    capacityMatrix<word> MA;
+    capacityMatrix<word> A;
+    capacityMatrix<real> C;
+    capacityMatrix<real> P;
+    capacityMatrix<real> T;
+
+    /* munkres work space, originally allocated on stack for each call */
+    word * validCol;
+    word * validRow;
+    word * coverColumn;
+    word * coverRow;
+    word * stz;
+    word * rowZ1;
+    capacityMatrix<real> dMat;
+    capacityMatrix<real> munkresM;
+    capacityMatrix<word> zP;
+    capacityMatrix<word> starZ;
+    capacityMatrix<word> primeZ;
+
+    /* uniform grid pre-gating work space (see mtt_pure::grid_gating) */
+    word * gridCell;
+    word * gridOrder;
+    word * gridStart;
+
+protected:
+    mttStorageBase(int storage_capacity) : capacity(storage_capacity) {}
+
+    int capacity; ///< Number of targets this storage can hold
+};
+
+/**
+ * @brief Fixed size storage, all arrays are members of object.
+ */
+template <int N>
+class mttStorage : public mttStorageBase
+{
+public:
+    mttStorage() : mttStorageBase(N)
+    {
+        memset(&data, 0, sizeof(data));
+
+        Z = data.Z; Y_p = data.Y_p; P_p = data.P_p; K = data.K; Y_e = data.Y_e; P_e = data.P_e; OLGI = data.OLGI; ID = data.ID;
+
+        M = capacityMatrix<word>(&data.M[0][0], N);
+        MA = capacityMatrix<word>(&data.MA[0][0], N);
+        A = capacityMatrix<word>(&data.A[0][0], N);
+        C = capacityMatrix<real>(&data.C[0][0], N);
+        P = capacityMatrix<real>(&data.P[0][0], N);
+        T = capacityMatrix<real>(&data.T[0][0], N);
+
+        validCol = data.validCol; validRow = data.validRow; coverColumn = data.coverColumn;
+        coverRow = data.coverRow; stz = data.stz; rowZ1 = data.rowZ1;
+
+        dMat = capacityMatrix<real>(&data.dMat[0][0], N);
+        munkresM = capacityMatrix<real>(&data.munkresM[0][0], N);
+        zP = capacityMatrix<word>(&data.zP[0][0], N);
+        starZ = capacityMatrix<word>(&data.starZ[0][0], N);
+        primeZ = capacityMatrix<word>(&data.primeZ[0][0], N);
+
+        gridCell = data.gridCell; gridOrder = data.gridOrder; gridStart = data.gridStart;
+    }
+
+private:
+    struct {
+        real Z[N][2];
+        real Y_p[N][4];
+        real P_p[N][4][4];
+        real K[N][4][2];
+        real Y_e[N][4];
+        real P_e[N][4][4];
+        word OLGI[N];
+        word ID[N];
+        word M[N][N];
+        word MA[N][N];
+        word A[N][N];
+        real C[N][N];
+        real P[2][N];
+        real T[2][N];
+
+        word validCol[N];
+        word validRow[N];
+        word coverColumn[N];
+        word coverRow[N];
+        word stz[N];
+        word rowZ1[N];
+        real dMat[N][N];
+        real munkresM[N][N];
+        word zP[N][N];
+        word starZ[N][N];
+        word primeZ[N][N];
+
+        word gridCell[N];
+        word gridOrder[N];
+        word gridStart[GRID_CELLS(N)+1];
+    } data; ///< All arrays in one block so whole storage can be zeroed at once
+};
+
+/**
+ * @brief Dynamically sized storage used for capacities without fixed specialization. All arrays are allocated from one arena.
+ */
+template <>
+class mttStorage<DYNAMIC_CAPACITY> : public mttStorageBase
+{
+public:
+    mttStorage(int storage_capacity) : mttStorageBase(storage_capacity)
+    {
+        int n = storage_capacity;
+
+        Z = (real (*)[2])(arena.allocateArray<real>(n*2));
+        Y_p = (real (*)[4])(arena.allocateArray<real>(n*4));
+        P_p = (real (*)[4][4])(arena.allocateArray<real>(n*16));
+        K = (real (*)[4][2])(arena.allocateArray<real>(n*8));
+        Y_e = (real (*)[4])(arena.allocateArray<real>(n*4));
+        P_e = (real (*)[4][4])(arena.allocateArray<real>(n*16));
+        OLGI = arena.allocateArray<word>(n);
+        ID = arena.allocateArray<word>(n);
+
+        M = capacityMatrix<word>(arena.allocateArray<word>(n*n), n);
+        MA = capacityMatrix<word>(arena.allocateArray<word>(n*n), n);
+        A = capacityMatrix<word>(arena.allocateArray<word>(n*n), n);
+        C = capacityMatrix<real>(arena.allocateArray<real>(n*n), n);
+        P = capacityMatrix<real>(arena.allocateArray<real>(2*n), n);
+        T = capacityMatrix<real>(arena.allocateArray<real>(2*n), n);
+
+        validCol = arena.allocateArray<word>(n);
+        validRow = arena.allocateArray<word>(n);
+        coverColumn = arena.allocateArray<word>(n);
+        coverRow = arena.allocateArray<word>(n);
+        stz = arena.allocateArray<word>(n);
+        rowZ1 = arena.allocateArray<word>(n);
+
+        dMat = capacityMatrix<real>(arena.allocateArray<real>(n*n), n);
+        munkresM = capacityMatrix<real>(arena.allocateArray<real>(n*n), n);
+        zP = capacityMatrix<word>(arena.allocateArray<word>(n*n), n);
+        starZ = capacityMatrix<word>(arena.allocateArray<word>(n*n), n);
+        primeZ = capacityMatrix<word>(arena.allocateArray<word>(n*n), n);
+
+        gridCell = arena.allocateArray<word>(n);
+        gridOrder = arena.allocateArray<word>(n);
+        gridStart = arena.allocateArray<word>(GRID_CELLS(n)+1);
+    }
+
+private:
+    targetArena arena; ///< Owner of all arrays
+};
+
+#endif // MTTSTORAGE_H
@@ -26,6 +26,8 @@ struct radar_handler
     class radarUnit * radar; ///< Pointer to the 'radarUnit' object
     bool updated; ///< If the data where updated since the last filtration/rendering
     unsigned int id; ///< ID of the 'radarUnit'
+    qint64 lastUpdate; ///< Arrival time of the last data in milliseconds since epoch (see 'stackManager::fusionTime'), -1 if no data were recieved yet
+    bool stale; ///< If the radar did not send data for longer than stale time. Positions of stale radars are not fused and fusion does not wait for them.
 };
 
 #endif // RADAR_HANDLER
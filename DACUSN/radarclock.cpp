@@ -0,0 +1,83 @@
+/**
+ * @file radarclock.cpp
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Definitions of radarClock class methods.
+ *
+ * @section DESCRIPTION
+ *
+ * Difference of two consecutive radar times is known only modulo RADAR_TIME_MODULUS. If packets arrive
+ * more than one overflow apart (lost packets, slow radar), the number of overflows is chosen so the
+ * tick difference agrees with arrival times and estimated period.
+ *
+ */
+
+#include "radarclock.h"
+
+radarClock::radarClock(int modulus)
+{
+    this->modulus = (modulus>1) ? modulus : RADAR_TIME_MODULUS;
+    reset();
+}
+
+void radarClock::reset()
+{
+    packets = 0;
+    lastRadarTime = 0;
+    lastArrival = 0;
+    ticks = 0;
+
+    weight = 0.0;
+    meanTicks = meanArrival = 0.0;
+    Ctt = Cta = 0.0;
+}
+
+double radarClock::update(int radar_time, qint64 arrival)
+{
+    radar_time %= modulus;
+    if(radar_time<0) radar_time += modulus;
+
+    if(packets>0)
+    {
+        qint64 delta = (radar_time-lastRadarTime+modulus) % modulus;
+
+        // whole overflows between packets are estimated from arrival times
+        double period = getPeriod();
+        if(packets>=2 && period>0.0)
+        {
+            double expected = (arrival-lastArrival)/period;
+            qint64 overflows = (qint64) floor((expected-delta)/modulus+0.5);
+            if(overflows>0) delta += overflows*modulus;
+        }
+
+        ticks += delta;
+
+        // packet far away from fitted line means that radar was restarted or link was lost for a long time
+        if(packets>=RADAR_CLOCK_MIN_PACKETS && fabs(toHostTime(ticks)-arrival)>RADAR_CLOCK_MAX_ERROR)
+        {
+            reset();
+        }
+    }
+
+    lastRadarTime = radar_time;
+    lastArrival = arrival;
+    fit((double) ticks, (double) arrival);
+    packets++;
+
+    if(packets<RADAR_CLOCK_MIN_PACKETS) return (double) arrival;
+    return toHostTime(ticks);
+}
+
+void radarClock::fit(double t, double a)
+{
+    // weighted Welford update, older points fade with forgetting factor
+    weight = RADAR_CLOCK_FORGETTING*weight + 1.0;
+
+    double dt = t-meanTicks;
+    meanTicks += dt/weight;
+    double da = a-meanArrival;
+    meanArrival += da/weight;
+
+    Ctt = RADAR_CLOCK_FORGETTING*Ctt + dt*(t-meanTicks);
+    Cta = RADAR_CLOCK_FORGETTING*Cta + dt*(a-meanArrival);
+}
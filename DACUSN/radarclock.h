@@ -0,0 +1,95 @@
+/**
+ * @file radarclock.h
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Alignment of radar time with host time.
+ *
+ * @section DESCRIPTION
+ *
+ * Each radar packet carries short radar time (8 bits in uwb packet) which overflows every RADAR_TIME_MODULUS
+ * ticks. The 'radarClock' object unwraps it into 64-bit tick counter and fits the line
+ * host_time = offset + period*ticks to arrival times of packets. Arrival times are disturbed by jitter
+ * of serial link, network and operating system, the fitted line is not, so the time of measurement
+ * expressed in host time is obtained from radar time. Period is estimated as well, so drift of radar
+ * oscillator does not matter. Old packets are forgotten exponentially, so slow changes of drift are followed.
+ *
+ * The constant part of transport delay can not be observed from arrival times, it is included in offset.
+ *
+ */
+
+#ifndef RADARCLOCK_H
+#define RADARCLOCK_H
+
+#include <math.h>
+#include <QtGlobal>
+
+#define RADAR_TIME_MODULUS          (256)       ///< Radar time overflows after this number of ticks
+#define RADAR_CLOCK_FORGETTING      (0.995)     ///< Weight of older packets is multiplied by this value with each new packet
+#define RADAR_CLOCK_MIN_PACKETS     (4)         ///< Number of packets needed before fitted line is used instead of arrival time
+#define RADAR_CLOCK_MAX_ERROR       (1000.0)    ///< Packets arriving more than this number of milliseconds away from fitted line restart the fit (radar restart, lost link)
+
+class radarClock
+{
+public:
+    /**
+     * @brief Creates clock without any packets.
+     * @param[in] modulus Number of ticks after which radar time overflows.
+     */
+    radarClock(int modulus = RADAR_TIME_MODULUS);
+
+    /**
+     * @brief Forgets all packets, e.g. if radar was restarted.
+     */
+    void reset(void);
+
+    /**
+     * @brief Adds packet and returns estimated time of its measurement.
+     * @param[in] radar_time Radar time from packet (0 up to modulus-1).
+     * @param[in] arrival Host time of packet arrival in milliseconds.
+     * @return Host time in milliseconds the packet was measured at. Until enough packets are known, arrival time is returned.
+     */
+    double update(int radar_time, qint64 arrival);
+
+    /**
+     * @brief Returns unwrapped radar time of the last packet.
+     * @return Number of ticks since the first packet.
+     */
+    qint64 getTicks(void) { return ticks; }
+
+    /**
+     * @brief Returns estimated length of one radar tick.
+     * @return Tick period in host milliseconds, 0 if not known yet.
+     */
+    double getPeriod(void) { return (packets>=2 && Ctt>0) ? Cta/Ctt : 0.0; }
+
+    /**
+     * @brief Returns host time of radar tick.
+     * @param[in] tick Unwrapped radar time.
+     * @return Host time in milliseconds.
+     */
+    double toHostTime(qint64 tick) { return meanArrival + getPeriod()*((double) tick - meanTicks); }
+
+private:
+    int modulus; ///< Number of ticks after which radar time overflows
+
+    int packets; ///< Number of packets since the last reset
+    int lastRadarTime; ///< Radar time of the last packet
+    qint64 lastArrival; ///< Arrival of the last packet
+    qint64 ticks; ///< Unwrapped radar time of the last packet
+
+    /* exponentially weighted least squares fit, kept as weighted means and co-moments so large tick values do not lose precision */
+    double weight; ///< Sum of weights
+    double meanTicks; ///< Weighted mean of unwrapped radar time
+    double meanArrival; ///< Weighted mean of arrival time
+    double Ctt; ///< Weighted co-moment of radar time with itself
+    double Cta; ///< Weighted co-moment of radar time and arrival time
+
+    /**
+     * @brief Adds point to the fit.
+     * @param[in] t Unwrapped radar time.
+     * @param[in] a Arrival time.
+     */
+    void fit(double t, double a);
+};
+
+#endif // RADARCLOCK_H
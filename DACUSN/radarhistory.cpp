@@ -0,0 +1,167 @@
+/**
+ * @file radarhistory.cpp
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Definitions of radarHistory class methods.
+ *
+ * @section DESCRIPTION
+ *
+ * Frames live in slots of fixed arrays and index 0 always refers to the oldest frame, so the history behaves
+ * like the list of the last packets radar unit used to keep, but without allocation for each packet.
+ *
+ */
+
+#include "radarhistory.h"
+
+radarHistory::radarHistory(int depth, int capacity)
+{
+    this->depth = 0;
+    stride = 0;
+    head = count = 0;
+
+    storage = NULL;
+    idStorage = NULL;
+    targets = NULL;
+    measurementTimes = NULL;
+    arrivalTimes = NULL;
+    trackedFlags = NULL;
+
+    if(depth<1) depth = 1;
+    else if(depth>RADAR_HISTORY_MAX_DEPTH) depth = RADAR_HISTORY_MAX_DEPTH;
+
+    reallocate(depth, (capacity>0) ? capacity : MAX_N);
+}
+
+radarHistory::~radarHistory()
+{
+    delete [] storage;
+    delete [] idStorage;
+    delete [] targets;
+    delete [] measurementTimes;
+    delete [] arrivalTimes;
+    delete [] trackedFlags;
+}
+
+void radarHistory::setDepth(int depth)
+{
+    if(depth<1) depth = 1;
+    else if(depth>RADAR_HISTORY_MAX_DEPTH) depth = RADAR_HISTORY_MAX_DEPTH;
+
+    if(depth!=this->depth) reallocate(depth, stride);
+}
+
+void radarHistory::push(const float *coordinates, const int *ids, int targets, int capacity, double measurement_time, qint64 arrival_time, bool tracked)
+{
+    if(capacity<targets) capacity = targets;
+    if(capacity>stride) reallocate(depth, capacity);
+
+    // the newest frame takes the slot after the last one, or the slot of the oldest frame if history is full
+    int s;
+    if(count<depth) s = slot(count++);
+    else
+    {
+        s = head;
+        head = (head+1) % depth;
+    }
+
+    float * destination = &storage[s*stride*2];
+    if(capacity>0) memcpy(destination, coordinates, capacity*2*sizeof(float));
+    if(capacity<stride) memset(&destination[capacity*2], 0, (stride-capacity)*2*sizeof(float));
+
+    int * destination_ids = &idStorage[s*stride];
+    if(ids!=NULL) memcpy(destination_ids, ids, targets*sizeof(int));
+    else for(int i=0; i<targets; i++) destination_ids[i] = i;
+
+    this->targets[s] = targets;
+    measurementTimes[s] = measurement_time;
+    arrivalTimes[s] = arrival_time;
+    trackedFlags[s] = tracked;
+}
+
+bool radarHistory::getFrame(int index, radar_frame *frame)
+{
+    if(index<0 || index>=count) return false;
+
+    int s = slot(index);
+    frame->coordinates = &storage[s*stride*2];
+    frame->ids = &idStorage[s*stride];
+    frame->count = targets[s];
+    frame->capacity = stride;
+    frame->measurement_time = measurementTimes[s];
+    frame->arrival_time = arrivalTimes[s];
+    frame->tracked = trackedFlags[s];
+
+    return true;
+}
+
+int radarHistory::findTime(double time)
+{
+    // binary search for the first frame not older than time
+    int low = 0;
+    int high = count;
+
+    while(low<high)
+    {
+        int middle = (low+high)/2;
+        if(measurementTimes[slot(middle)]<time) low = middle+1;
+        else high = middle;
+    }
+
+    return low;
+}
+
+int radarHistory::getRange(double from, double to, int *first)
+{
+    *first = findTime(from);
+    if(to<=from) return 0;
+
+    return findTime(to)-*first;
+}
+
+void radarHistory::reallocate(int new_depth, int new_stride)
+{
+    int kept = (count<new_depth) ? count : new_depth;
+    int skipped = count-kept;
+    int i;
+
+    float * new_storage = new float[new_depth*new_stride*2];
+    int * new_id_storage = new int[new_depth*new_stride];
+    int * new_targets = new int[new_depth];
+    double * new_measurement_times = new double[new_depth];
+    qint64 * new_arrival_times = new qint64[new_depth];
+    bool * new_tracked = new bool[new_depth];
+
+    // the newest frames are copied in order, so the oldest kept frame gets slot 0
+    for(i=0; i<kept; i++)
+    {
+        int s = slot(skipped+i);
+
+        memcpy(&new_storage[i*new_stride*2], &storage[s*stride*2], stride*2*sizeof(float));
+        if(new_stride>stride) memset(&new_storage[(i*new_stride+stride)*2], 0, (new_stride-stride)*2*sizeof(float));
+        memcpy(&new_id_storage[i*new_stride], &idStorage[s*stride], stride*sizeof(int));
+
+        new_targets[i] = targets[s];
+        new_measurement_times[i] = measurementTimes[s];
+        new_arrival_times[i] = arrivalTimes[s];
+        new_tracked[i] = trackedFlags[s];
+    }
+
+    delete [] storage;
+    delete [] idStorage;
+    delete [] targets;
+    delete [] measurementTimes;
+    delete [] arrivalTimes;
+    delete [] trackedFlags;
+
+    storage = new_storage;
+    idStorage = new_id_storage;
+    targets = new_targets;
+    measurementTimes = new_measurement_times;
+    arrivalTimes = new_arrival_times;
+    trackedFlags = new_tracked;
+
+    depth = new_depth;
+    stride = new_stride;
+    head = 0;
+    count = kept;
+}
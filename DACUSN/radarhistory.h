@@ -0,0 +1,167 @@
+/**
+ * @file radarhistory.h
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Ring buffer of the latest processed frames of one radar unit.
+ *
+ * @section DESCRIPTION
+ *
+ * The 'radarHistory' object keeps the last 'depth' frames (targets positions of one packet after MTT) of
+ * one radar together with their arrival and measurement times. All frames are stored in one block of memory
+ * with the same stride, so pushing new frame only copies coordinates over the oldest one and never allocates
+ * (unless radar starts to send more targets than ever before). Frames are accessed in place, either by index
+ * (0 is the oldest frame) or by measurement time, which is useful for smoothing, subwindows and export.
+ *
+ */
+
+#ifndef RADARHISTORY_H
+#define RADARHISTORY_H
+
+#include <string.h>
+#include <QtGlobal>
+
+#include "stddefs.h"
+
+#define RADAR_HISTORY_DEPTH     (256)       ///< Default number of frames kept for each radar
+#define RADAR_HISTORY_MAX_DEPTH (65536)     ///< Upper limit of history depth which can be set by user
+
+/**
+ * @brief The 'radar_frame' structure describes one frame stored in history. Coordinates point into history and are valid until the frame is overwritten.
+ */
+struct radar_frame {
+    float * coordinates; ///< Array of [x, y] positions, 'capacity' positions are valid and positions after 'count' are zero
+    int * ids; ///< Identifier of each of 'count' positions, track identifiers if frame is tracked, position indexes otherwise
+    int count; ///< Number of targets in frame
+    int capacity; ///< Number of [x, y] positions in 'coordinates' array (the same for all frames of history)
+    double measurement_time; ///< Host time of measurement in milliseconds since epoch
+    qint64 arrival_time; ///< Host time of data arrival in milliseconds since epoch
+    bool tracked; ///< True if positions went through MTT, so index of position is index of track
+};
+
+class radarHistory
+{
+public:
+    /**
+     * @brief Creates empty history.
+     * @param[in] depth Maximum number of frames kept, older frames are overwritten.
+     * @param[in] capacity Number of [x, y] positions prepared for each frame, grows automatically if radar sends more targets.
+     */
+    radarHistory(int depth = RADAR_HISTORY_DEPTH, int capacity = MAX_N);
+    ~radarHistory();
+
+    /**
+     * @brief Changes maximum number of frames. The newest frames are kept if history is shortened.
+     * @param[in] depth New number of frames (1 up to RADAR_HISTORY_MAX_DEPTH).
+     */
+    void setDepth(int depth);
+
+    /**
+     * @brief Returns maximum number of frames.
+     * @return Number of frames history can hold.
+     */
+    int getDepth(void) { return depth; }
+
+    /**
+     * @brief Returns the number of stored frames.
+     * @return Number of frames, at most 'getDepth()'.
+     */
+    int getCount(void) { return count; }
+
+    /**
+     * @brief Removes all frames. Memory is kept.
+     */
+    void clear(void) { head = count = 0; }
+
+    /**
+     * @brief Copies positions as the newest frame. If history is full, the oldest frame is overwritten.
+     * @param[in] coordinates Array of [x, y] positions.
+     * @param[in] ids Array of 'targets' identifiers (e.g. MTT track identifiers) or NULL if positions are identified by their index.
+     * @param[in] targets Number of targets.
+     * @param[in] capacity Number of [x, y] positions in array (not less than 'targets'), all of them are copied.
+     * @param[in] measurement_time Host time of measurement in milliseconds since epoch.
+     * @param[in] arrival_time Host time of data arrival in milliseconds since epoch.
+     * @param[in] tracked True if positions went through MTT.
+     */
+    void push(const float * coordinates, const int * ids, int targets, int capacity, double measurement_time, qint64 arrival_time, bool tracked);
+
+    /**
+     * @brief Describes stored frame without copying its coordinates.
+     * @param[in] index Index of frame, 0 is the oldest one and 'getCount()-1' the newest one.
+     * @param[out] frame Description of frame.
+     * @return False if index is out of range.
+     */
+    bool getFrame(int index, radar_frame * frame);
+
+    /**
+     * @brief Returns coordinates of stored frame.
+     * @param[in] index Index of frame, 0 is the oldest one.
+     * @return Pointer to coordinates inside of history or NULL if index is out of range.
+     */
+    float * getCoordinates(int index) { return (index>=0 && index<count) ? &storage[slot(index)*stride*2] : NULL; }
+
+    /**
+     * @brief Returns identifiers of targets of stored frame.
+     * @param[in] index Index of frame, 0 is the oldest one.
+     * @return Pointer to identifiers inside of history or NULL if index is out of range.
+     */
+    int * getIds(int index) { return (index>=0 && index<count) ? &idStorage[slot(index)*stride] : NULL; }
+
+    /**
+     * @brief Returns the number of targets in stored frame.
+     * @param[in] index Index of frame, 0 is the oldest one.
+     * @return Number of targets or -1 if index is out of range.
+     */
+    int getTargetsCount(int index) { return (index>=0 && index<count) ? targets[slot(index)] : -1; }
+
+    /**
+     * @brief Returns measurement time of stored frame.
+     * @param[in] index Index of frame, 0 is the oldest one.
+     * @return Milliseconds since epoch or -1 if index is out of range.
+     */
+    double getMeasurementTime(int index) { return (index>=0 && index<count) ? measurementTimes[slot(index)] : -1; }
+
+    /**
+     * @brief Finds the oldest frame measured at or after given time. Frames are expected to be pushed in order of measurement.
+     * @param[in] time Host time in milliseconds since epoch.
+     * @return Index of frame, 'getCount()' if all frames are older.
+     */
+    int findTime(double time);
+
+    /**
+     * @brief Finds frames measured in time interval [from, to).
+     * @param[in] from Start of interval in milliseconds since epoch.
+     * @param[in] to End of interval in milliseconds since epoch.
+     * @param[out] first Index of the first frame in interval.
+     * @return Number of frames in interval, frames 'first' up to 'first+count-1'.
+     */
+    int getRange(double from, double to, int * first);
+
+private:
+    int depth; ///< Maximum number of frames
+    int stride; ///< Number of [x, y] positions reserved for each frame
+    int head; ///< Slot of the oldest frame
+    int count; ///< Number of stored frames
+
+    float * storage; ///< Coordinates of all slots, slot 's' starts at 's*stride*2'
+    int * idStorage; ///< Identifiers of all slots, slot 's' starts at 's*stride'
+    int * targets; ///< Number of targets of each slot
+    double * measurementTimes; ///< Measurement time of each slot
+    qint64 * arrivalTimes; ///< Arrival time of each slot
+    bool * trackedFlags; ///< MTT flag of each slot
+
+    /**
+     * @brief Converts index of frame to slot in arrays.
+     * @param[in] index Index of frame, 0 is the oldest one.
+     * @return Slot of frame.
+     */
+    int slot(int index) { return (head+index) % depth; }
+
+    /**
+     * @brief Reallocates all arrays for new depth and stride. The newest frames which fit are kept and moved to the beginning.
+     * @param[in] new_depth New number of frames.
+     * @param[in] new_stride New number of positions per frame, not less than current stride.
+     */
+    void reallocate(int new_depth, int new_stride);
+};
+
+#endif // RADARHISTORY_H
@@ -381,6 +381,8 @@ void radarListDialog::accepted()
         radarList->append(new radar_handler);
         radarList->last()->id = id;
         radarList->last()->updated = false;
+        radarList->last()->lastUpdate = -1;
+        radarList->last()->stale = true;
         radarList->last()->radar = new radarUnit(id, x_pos, y_pos, angle, enabled->isChecked());
     }
 
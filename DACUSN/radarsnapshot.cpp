@@ -0,0 +1,89 @@
+/**
+ * @file radarsnapshot.cpp
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Definitions of radarSnapshot and snapshotSlot class methods.
+ *
+ * @section DESCRIPTION
+ *
+ * Snapshot is filled while nobody except the slot can reach it and becomes visible to readers only by
+ * exchange of 'current' pointer, so its data are never changed after reader gets it.
+ *
+ */
+
+#include "radarsnapshot.h"
+
+radarSnapshot::radarSnapshot(int capacity)
+    : references(1)
+{
+    if(capacity<1) capacity = 1;
+
+    coordinates = new float[capacity*2];
+    ids = new int[capacity];
+    this->capacity = capacity;
+    count = 0;
+    measurementTime = 0.0;
+    arrivalTime = 0;
+    sequence = 0;
+}
+
+radarSnapshot::~radarSnapshot()
+{
+    delete [] coordinates;
+    delete [] ids;
+}
+
+snapshotSlot::snapshotSlot()
+    : references(1)
+{
+    current = NULL;
+    spare = NULL;
+    sequence = 0;
+}
+
+snapshotSlot::~snapshotSlot()
+{
+    if(current!=NULL) current->release();
+    if(spare!=NULL) spare->release();
+}
+
+void snapshotSlot::publish(const float *coordinates, const int *ids, int targets, double measurement_time, qint64 arrival_time)
+{
+    if(targets<0) targets = 0;
+
+    // spare is not current, so if slot holds its only reference, no reader can get it any more
+    radarSnapshot * snapshot = spare;
+    if(snapshot!=NULL && (snapshot->references.loadAcquire()!=1 || snapshot->capacity<targets))
+    {
+        snapshot->release();
+        snapshot = NULL;
+    }
+    if(snapshot==NULL) snapshot = new radarSnapshot((targets>MAX_N) ? targets : MAX_N);
+
+    if(targets>0)
+    {
+        memcpy(snapshot->coordinates, coordinates, targets*2*sizeof(float));
+        memcpy(snapshot->ids, ids, targets*sizeof(int));
+    }
+    snapshot->count = targets;
+    snapshot->measurementTime = measurement_time;
+    snapshot->arrivalTime = arrival_time;
+    snapshot->sequence = ++sequence;
+
+    currentMutex.lock();
+    spare = current;
+    current = snapshot;
+    currentMutex.unlock();
+}
+
+const radarSnapshot *snapshotSlot::acquire()
+{
+    const radarSnapshot * snapshot;
+
+    currentMutex.lock();
+    snapshot = current;
+    if(snapshot!=NULL) snapshot->ref();
+    currentMutex.unlock();
+
+    return snapshot;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file radarsnapshot.h
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Immutable reference counted frames of one radar unit shared with radar subwindows.
+ *
+ * @section DESCRIPTION
+ *
+ * Radar unit publishes the newest frame after each processed packet into its 'snapshotSlot' and
+ * any number of readers (radar subwindows) can take reference to it at their own rendering rate.
+ * Published 'radarSnapshot' is never modified, so readers access it without copying and without
+ * locking of radar list. The cost of publishing does not depend on the number of readers.
+ *
+ * Slot keeps two snapshots, the current one and the previous one, which is reused for the next frame
+ * if no reader holds it anymore. Readers release snapshots right after use, so in normal operation
+ * no memory is allocated. If some reader still holds the previous snapshot, new one is allocated
+ * and the held one is deleted by its last reader.
+ *
+ * Slot itself is reference counted too, so subwindow can keep it even if radar unit is deleted before
+ * the subwindow is closed.
+ *
+ */
+
+#ifndef RADARSNAPSHOT_H
+#define RADARSNAPSHOT_H
+
+#include <string.h>
+#include <QtGlobal>
+#include <QAtomicInt>
+#include <QMutex>
+
+#include "stddefs.h"
+
+class snapshotSlot;
+
+class radarSnapshot
+{
+    friend class snapshotSlot;
+
+public:
+    /**
+     * @brief Takes another reference to snapshot.
+     */
+    void ref(void) const { references.ref(); }
+
+    /**
+     * @brief Releases reference to snapshot. Snapshot is deleted when the last reference is released, pointer must not be used after this call.
+     */
+    void release(void) const { if(!references.deref()) delete this; }
+
+    /**
+     * @brief Returns positions of targets.
+     * @return Array of 'getCount()' [x, y] positions.
+     */
+    const float * getCoordinates(void) const { return coordinates; }
+
+    /**
+     * @brief Returns identifiers of targets (track identifiers if radar unit uses MTT, indexes of positions otherwise).
+     * @return Array of 'getCount()' identifiers.
+     */
+    const int * getIds(void) const { return ids; }
+
+    /**
+     * @brief Returns the number of targets.
+     * @return Number of [x, y] positions in snapshot.
+     */
+    int getCount(void) const { return count; }
+
+    /**
+     * @brief Returns host time of measurement.
+     * @return Milliseconds since epoch.
+     */
+    double getMeasurementTime(void) const { return measurementTime; }
+
+    /**
+     * @brief Returns host time of data arrival.
+     * @return Milliseconds since epoch.
+     */
+    qint64 getArrivalTime(void) const { return arrivalTime; }
+
+    /**
+     * @brief Returns number of frame, which is increased with each published frame of the same slot. Readers can skip frames they already have.
+     * @return Sequence number, the first frame has 1.
+     */
+    quint64 getSequence(void) const { return sequence; }
+
+private:
+    radarSnapshot(int capacity);
+    ~radarSnapshot();
+
+    mutable QAtomicInt references; ///< Number of holders of snapshot, including slot
+
+    float * coordinates; ///< Array of [x, y] positions
+    int * ids; ///< Identifier of each position
+    int count; ///< Number of targets
+    int capacity; ///< Number of positions 'coordinates' array is allocated for
+    double measurementTime; ///< Host time of measurement in milliseconds since epoch
+    qint64 arrivalTime; ///< Host time of data arrival in milliseconds since epoch
+    quint64 sequence; ///< Number of frame
+};
+
+class snapshotSlot
+{
+public:
+    /**
+     * @brief Creates empty slot with one reference owned by creator.
+     */
+    snapshotSlot();
+
+    /**
+     * @brief Takes another reference to slot.
+     */
+    void ref(void) { references.ref(); }
+
+    /**
+     * @brief Releases reference to slot. Slot and its snapshots are deleted when the last reference is released.
+     */
+    void release(void) { if(!references.deref()) delete this; }
+
+    /**
+     * @brief Copies positions into new snapshot and makes it the current one. Must be called from one thread only.
+     * @param[in] coordinates Array of [x, y] positions.
+     * @param[in] ids Array of 'targets' identifiers.
+     * @param[in] targets Number of targets.
+     * @param[in] measurement_time Host time of measurement in milliseconds since epoch.
+     * @param[in] arrival_time Host time of data arrival in milliseconds since epoch.
+     */
+    void publish(const float * coordinates, const int * ids, int targets, double measurement_time, qint64 arrival_time);
+
+    /**
+     * @brief Takes reference to the current snapshot. Can be called from any thread.
+     * @return The current snapshot, which must be released by 'radarSnapshot::release', or NULL if nothing was published yet.
+     */
+    const radarSnapshot * acquire(void);
+
+private:
+    ~snapshotSlot();
+
+    QAtomicInt references; ///< Number of holders of slot
+
+    QMutex currentMutex; ///< Protects only exchange of 'current' pointer with taking of reference, snapshot data are never accessed under it
+    radarSnapshot * current; ///< The latest published snapshot, NULL if nothing was published
+    radarSnapshot * spare; ///< Previously published snapshot, reused if slot holds its only reference
+
+    quint64 sequence; ///< Number of the last published frame
+};
+
+#endif // RADARSNAPSHOT_H
@@ -31,6 +31,8 @@ radarSubWindow::radarSubWindow(int radar_Id, uwbSettings *setts, QMutex *setting
 
     // find the pointer to the correct radar according radarId
     thisRadarUnit = NULL;
+    radarSnapshots = NULL;
+    lastSequence = 0;
     radar_List_Mutex->lock();
 
         for(int i = 0; i<radar_List->count(); i++)
@@ -38,6 +40,10 @@ radarSubWindow::radarSubWindow(int radar_Id, uwbSettings *setts, QMutex *setting
             if(radar_List->at(i)->id==radar_Id)
             {
                 thisRadarUnit = radar_List->at(i)->radar;
+
+                // slot is kept even if radar unit is deleted before this window is closed
+                radarSnapshots = thisRadarUnit->getSnapshotSlot();
+                radarSnapshots->ref();
                 break;
             }
         }
@@ -62,13 +68,19 @@ radarSubWindow::radarSubWindow(int radar_Id, uwbSettings *setts, QMutex *setting
     visualizationDataMutex = visualization_Data_Mutex;
 
     // create own scenes, view and manager
-    thisVisualizationData = new QList<QPointF * >;
+    thisVisualizationData = new frameBuffer;
 
     thisVisualizationScene = new radarScene(settings, settingsMutex, this);
     thisVisualizationView = new radarView(thisVisualizationScene, settings, settingsMutex, this);
     thisVisualizationDataMutex = new QMutex;
     thisVisualizationColor = new QList<QColor * >;
-    thisVisualizationManager = new animationManager(thisVisualizationScene, thisVisualizationView, thisVisualizationData, thisVisualizationColor, thisVisualizationDataMutex, settings, settingsMutex);
+
+    // colors are copied once, manager reads them without locking
+    visualizationDataMutex->lock();
+    updateColorList();
+    visualizationDataMutex->unlock();
+
+    thisVisualizationManager = new animationManager(thisVisualizationScene, thisVisualizationView, thisVisualizationData, thisVisualizationColor, settings, settingsMutex);
 
     ui->radarSubWindowViewLayout->addWidget(thisVisualizationView);
 
@@ -87,83 +99,45 @@ radarSubWindow::~radarSubWindow()
     delete thisVisualizationView;
     delete thisVisualizationManager;
 
+    delete thisVisualizationData;
+
+    if(radarSnapshots!=NULL) radarSnapshots->release();
+
     // need to lock, since no mutex protection is used inside clear function
     thisVisualizationDataMutex->lock();
 
-    clearRadarData();
     clearColorList();
 
     thisVisualizationDataMutex->unlock();
 }
 
-void radarSubWindow::addVisualizationData(float *data_array, int count)
+void radarSubWindow::updateVisualizationData()
 {
-    // locking local mutex
-    thisVisualizationDataMutex->lock();
-
-    // delete all current data in list
-    clearRadarData();
+    if(radarSnapshots==NULL) return;
 
-    // check for colors in list, if not enough, update
-    if(thisVisualizationColor->count()<count) updateColorList();
+    const radarSnapshot * snapshot = radarSnapshots->acquire();
+    if(snapshot==NULL) return;
 
-    // fill list with new values
-    for(int j = 0; j<count; j++)
+    // frame is rebuilt only if radar unit published something new since the last rendering
+    if(snapshot->getSequence()!=lastSequence)
     {
-        thisVisualizationData->append(new QPointF(data_array[j*2], data_array[j*2+1]));
-    }
+        lastSequence = snapshot->getSequence();
 
-    // unlocking local mutex
-    thisVisualizationDataMutex->unlock();
-}
-
-void radarSubWindow::addVisualizationData(double *data_array, int count)
-{
-    // locking local mutex
-    thisVisualizationDataMutex->lock();
-
-    // delete all current data in list
-    clearRadarData();
-
-    // check for colors in list, if not enough, update
-    if(thisVisualizationColor->count()<count) updateColorList();
-
-    // fill list with new values
-    for(int j = 0; j<count; j++)
-    {
-        thisVisualizationData->append(new QPointF(data_array[j*2], data_array[j*2+1]));
+        const float * coordinates = snapshot->getCoordinates();
+        const int * ids = snapshot->getIds();
+        thisVisualizationData->beginFrame();
+        for(int j = 0; j<snapshot->getCount(); j++) thisVisualizationData->append(coordinates[j*2], coordinates[j*2+1], ids[j]);
+        thisVisualizationData->publish(snapshot->getArrivalTime());
     }
 
-    // unlocking local mutex
-    thisVisualizationDataMutex->unlock();
-}
-
-void radarSubWindow::addVisualizationData(QList<QPointF *> data_list)
-{
-    // locking local mutex
-    thisVisualizationDataMutex->lock();
-
-    // delete all current data in list
-    clearRadarData();
-
-    // check for colors in list, if not enough, update
-    if(thisVisualizationColor->count()<data_list.count()) updateColorList();
-
-    // fill list with new values
-    for(int j = 0; j<data_list.count(); j++)
-    {
-        thisVisualizationData->append(new QPointF(*data_list.at(j)));
-    }
-
-    // unlocking local mutex
-    thisVisualizationDataMutex->unlock();
+    snapshot->release();
 }
 
 void radarSubWindow::updateColorList()
 {
     // IMPORTANT NOTE: ALTHOUGH WE SHOULD USE MUTEXES HERE TO PROTECT VECTORS/LISTS, IN THIS CASE IT IS NOT REQUIRED.
-    // thisVisualizationDataMutex is not needed since update is always called inside addVisualizationData function and here already mutexes are used
-    // visualizationDataMutex is not needed but only in this particular case. addVisualizationData function is called inside fusion or already protected area with visualizationDataMutexes.
+    // thisVisualizationDataMutex is not needed since list is copied in constructor before local manager exists
+    // visualizationDataMutex is locked by constructor around this call.
 
     // remove old colors in list
     //thisVisualizationDataMutex->lock();
@@ -190,13 +164,9 @@ void radarSubWindow::updateRadarMarkers()
 
 void radarSubWindow::clearRadarData()
 {
-    // not using mutex, since another processing is usually done in higher function so mutex should be used there.
-
-    while(!thisVisualizationData->isEmpty())
-    {
-        delete thisVisualizationData->first();
-        thisVisualizationData->removeFirst();
-    }
+    // must be called from the same thread as updateVisualizationData, since frame buffer has only one writer
+    thisVisualizationData->beginFrame();
+    thisVisualizationData->publish(QDateTime::currentMSecsSinceEpoch());
 }
 
 void radarSubWindow::clearColorList()
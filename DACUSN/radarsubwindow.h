@@ -69,27 +69,12 @@ public:
     int getRadarId(void) { return radarId; }
 
     /**
-     * @brief Function will extract data from array and passes them into 'thisVisualizationData' list. Private visualization manager will then access them as the one in main window.
-     * @param[in] data_array Pointer to the array containing data
-     * @param[in] count Number of [x,y] points in array.
+     * @brief Takes the newest snapshot of radar unit and publishes it through 'thisVisualizationData' buffer if it was not displayed yet. Called by rendering sequence before local visualization manager is launched, so the window is updated at rendering rate and not for each recieved packet.
      */
-    void addVisualizationData(float * data_array, int count);
+    void updateVisualizationData(void);
 
     /**
-     * @brief Overloaded function. Function will extract data from array and passes them into 'thisVisualizationData' list. Private visualization manager will then access them as the one in main window.
-     * @param[in] data_array Input array with data to be extracted.
-     * @param[in] count Number of [x,y] points in array.
-     */
-    void addVisualizationData(double * data_array, int count);
-
-    /**
-     * @brief Overloaded function. Function will extract data from input list and passes them into 'thisVisualizationData' list. Private visualization manager will then access them as the one in main window.
-     * @param[in] data_list Input lsit with data to be extracted.
-     */
-    void addVisualizationData(QList<QPointF *> data_list);
-
-    /**
-     * @brief Updates local/private color list, which is prefered rather than periodical loading from main color list because of performance issues. List is updated when there is not enough color for target displaying.
+     * @brief Updates local/private color list, which is prefered rather than periodical loading from main color list because of performance issues. List is copied when window is created, colors are repeated if there are more targets.
      */
     void updateColorList(void);
 
@@ -99,7 +84,7 @@ public:
     void updateRadarMarkers(void);
 
     /**
-     * @brief Ensures correct removal of all points in 'thisVisualizationData' list
+     * @brief Publishes empty frame through 'thisVisualizationData' buffer, so no targets are displayed.
      */
     void clearRadarData(void);
 
@@ -134,14 +119,16 @@ private:
     QMutex * radarListMutex; ///< Mutex protecting the 'radarList' from multithread access
 
     radarUnit * thisRadarUnit; ///< Pointer to the radar unit which values should be displayed in this dialog. Allows direct access to the unit's resources.
+    snapshotSlot * radarSnapshots; ///< Slot with the newest frame of displayed radar unit, referenced by this window
+    quint64 lastSequence; ///< Sequence number of the last snapshot published into 'thisVisualizationData'
 
     animationManager * thisVisualizationManager; ///< This window's own 'animationManager' object.
     radarScene * thisVisualizationScene; ///< This window's own scene.
     radarView * thisVisualizationView; ///< This window's own view.
 
-    QList<QPointF * > * thisVisualizationData; ///< Own visualizationData list. Must be filled by higher classes.
-    QList<QColor * > * thisVisualizationColor; ///< Color list used for data displaying. Is updated only if not enough color are availible.
-    QMutex * thisVisualizationDataMutex; ///< Mutex protecting visualization data from being accessed by few threads at once.
+    frameBuffer * thisVisualizationData; ///< Own visualizationData buffer. Must be filled by higher classes.
+    QList<QColor * > * thisVisualizationColor; ///< Color list used for data displaying. Is copied from main color list when window is created.
+    QMutex * thisVisualizationDataMutex; ///< Mutex protecting color list from being accessed by few threads at once.
 
 signals:
     void radarSubWindowClosed(radarSubWindow *); ///< Signal is emitted on close event and pointer to THIS subwindow is passed.
@@ -20,7 +20,6 @@
 radarUnit::radarUnit(int radarId, double x_pos, double y_pos, double rot_Angle, bool enable)
 {
     radar_id = radarId;
-    max_recursion = 5;
 
     xpos = x_pos;
     ypos = y_pos;
@@ -28,21 +27,30 @@ radarUnit::radarUnit(int radarId, double x_pos, double y_pos, double rot_Angle,
 
     tempX = tempY = 0.0;
 
-    dataList = new QList<rawData * >;
+    history = new radarHistory;
+    snapshots = new snapshotSlot;
 
     enabled = enable;
 
     /* FOR TEST PURPOSES ONLY - TEST OF MTT_PURE LIB */
-    mtt_p = new mtt_pure;
+    // MTT object is created on first use, units without MTT enabled do not need it at all
+    targetCapacity = MAX_N;
+    mttStateModel = MTT_POLAR_STATE;
+    mtt_p = NULL;
+    pendingMTTState = NULL;
+
+    clock = new radarClock;
 }
 
 radarUnit::~radarUnit()
 {
-    while(!dataList->isEmpty())
-    {
-        delete dataList->first();
-        dataList->removeFirst();
-    }
+    delete history;
+    snapshots->release();
+
+    if(mtt_p!=NULL) delete mtt_p;
+    if(pendingMTTState!=NULL) delete pendingMTTState;
+
+    delete clock;
 }
 
 bool radarUnit::processNewData(rawData *data, bool enableMTT)
@@ -58,44 +66,84 @@ bool radarUnit::processNewData(rawData *data, bool enableMTT)
     int min_NT = 10;
     int min_OLGI = 10;
 
-    if(method==SYNTHETIC || method==RS232)
+    if(mttStateModel==MTT_CARTESIAN_STATE)
+    {
+        // the same noise expressed in meters, angle variance corresponds to the lateral error at a few meters distance
+        r[1] = 0.1;
+        q[3] = 0.01;
+        diff_fi = 1.0;
+    }
+
+    if(method==SYNTHETIC || method==RS232 || method==RAW_IR)
     {
         #if defined MTT_ARRAY_FIT && MTT_ARRAY_FIT==1
             zeroEmptyPositions(data);
         #endif
 
+        // radar time removes jitter of arrival times, synthetic data do not carry it
+        if((method==RS232 || method==RAW_IR) && data->getUwbPacketRadarTime()>=0)
+            data->setMeasurementTime(clock->update(data->getUwbPacketRadarTime(), data->getArrivalTime()));
+
+
+        // after MTT positions are ordered by tracker slots, identifiers keep targets apart when tracks are dropped
+        const int * ids = NULL;
+        int tracks = -1;
 
         if(enableMTT)
         {
             qDebug() << "Running MTT for radar: " << radar_id;
 
-            if(data->getRecieverMethod()==RS232)
+            if(mtt_p==NULL)
+            {
+                mtt_p = new mtt_pure(targetCapacity, mttStateModel);
+
+                // continue from the state saved before MTT object was created
+                if(pendingMTTState!=NULL)
+                {
+                    mtt_p->restoreState(pendingMTTState);
+                    delete pendingMTTState;
+                    pendingMTTState = NULL;
+                }
+            }
+
+            int count = (method==RS232 || method==RAW_IR) ? data->getUwbPacketTargetsCount() : data->getSyntheticTargetsCount();
+            if(count>mtt_p->getCapacity())
+                qDebug() << "Radar " << radar_id << " sent " << count << " targets, MTT capacity is only " << mtt_p->getCapacity() << ". Remaining targets are not tracked.";
+
+            if(method==RS232 || method==RAW_IR)
                 mtt_p->MTT(data->getUwbPacketCoordinates(), r, q, diff_d, diff_fi, min_OLGI, min_NT);
             #if defined (__WIN32__)
             else if(data->getRecieverMethod()==SYNTHETIC) mtt_p->MTT(data->getSyntheticCoordinates(), r, q, diff_d, diff_fi, min_OLGI, min_NT);
             #endif
             else qDebug() << "MTT could not run, because of unknown reciever method";
-        }
 
-        if(dataList->count()>=max_recursion)
-        {
-            // remove the oldest record
-            delete dataList->first();
-            dataList->removeFirst();
-            dataList->append(data);
-        }
-        else
-        {
-            // just append the new record
-            dataList->append(data);
+            ids = mtt_p->getTrackIds();
+            tracks = mtt_p->getTracksCount();
         }
 
+        // positions are copied into history, the container returns to reciever
+        if(method==RS232 || method==RAW_IR)
+            history->push(data->getUwbPacketCoordinates(), ids, (tracks<0) ? data->getUwbPacketTargetsCount() : tracks, data->getUwbPacketCoordinatesCapacity(),
+                          data->getMeasurementTime(), data->getArrivalTime(), enableMTT);
+        #if defined (__WIN32__)
+        else if(method==SYNTHETIC)
+            history->push(data->getSyntheticCoordinates(), ids, (tracks<0) ? data->getSyntheticTargetsCount() : tracks, data->getSyntheticCoordinatesCapacity(),
+                          data->getMeasurementTime(), data->getArrivalTime(), enableMTT);
+        #endif
+
+        // one copy for all readers, independent of how many subwindows are opened
+        radar_frame frame;
+        if(history->getFrame(history->getCount()-1, &frame))
+            snapshots->publish(frame.coordinates, frame.ids, frame.count, frame.measurement_time, frame.arrival_time);
+
+        delete data;
         return true;
     }
     else
     {
         // no known method
         qDebug() << "Method was not recognized.";
+        delete data;
         return false;
     }
 
@@ -104,55 +152,66 @@ bool radarUnit::processNewData(rawData *data, bool enableMTT)
 
 int radarUnit::getNumberOfTargetsLast()
 {
-    if(dataList->isEmpty()) return -1; // default return
-
-    reciever_method method = dataList->last()->getRecieverMethod();
-    if(method==RS232) return dataList->last()->getUwbPacketTargetsCount();
-    #if defined (__WIN32__)
-    else if(method==SYNTHETIC) return dataList->last()->getSyntheticTargetsCount();
-    #endif
-    else return 0;
-    return 0;
+    return history->getTargetsCount(history->getCount()-1);
 }
 
 float *radarUnit::getCoordinatesLast()
 {
-    if(dataList->isEmpty()) return NULL; // default return
-
-    reciever_method method = dataList->last()->getRecieverMethod();
-    if(method==RS232) return dataList->last()->getUwbPacketCoordinates();
-    #if defined (__WIN32__)
-    else if(method==SYNTHETIC) return dataList->last()->getSyntheticCoordinates();
-    #endif
-    else return NULL;
-    return NULL;
+    return history->getCoordinates(history->getCount()-1);
 }
 
 int radarUnit::getNumberOfTargetsAt(int index)
 {
-    if(dataList->isEmpty()) return -1; // default return
+    return history->getTargetsCount(index);
+}
 
-    reciever_method method = dataList->at(index)->getRecieverMethod();
+float *radarUnit::getCoordinatesAt(int index)
+{
+    return history->getCoordinates(index);
+}
 
-    if(method==RS232) return dataList->at(index)->getUwbPacketTargetsCount();
-    #if defined (__WIN32__)
-    else if(method==SYNTHETIC) return dataList->at(index)->getSyntheticTargetsCount();
-    #endif
-    else return 0;
-    return 0;
+double radarUnit::getMeasurementTimeLast()
+{
+    return history->getMeasurementTime(history->getCount()-1);
 }
 
-float *radarUnit::getCoordinatesAt(int index)
+int radarUnit::predictCoordinatesLast(double epoch, float *coordinates)
 {
-    if(dataList->isEmpty()) return NULL; // default return
+    int i;
+    radar_frame last, previous;
 
-    reciever_method method = dataList->at(index)->getRecieverMethod();
-    if(method==RS232) return dataList->at(index)->getUwbPacketCoordinates();
-    #if defined (__WIN32__)
-    else if(method==SYNTHETIC) return dataList->at(index)->getSyntheticCoordinates();
-    #endif
-    else return NULL;
-    return NULL;
+    if(!history->getFrame(history->getCount()-1, &last) || last.count<=0) return 0;
+
+    int count = last.count;
+    memcpy(coordinates, last.coordinates, count*2*sizeof(float));
+
+    // the same identifier is the same target only if both data went through MTT
+    if(!history->getFrame(history->getCount()-2, &previous) || !last.tracked || !previous.tracked) return count;
+
+    double interval = last.measurement_time-previous.measurement_time;
+    double horizon = epoch-last.measurement_time;
+
+    if(interval<=0 || interval>RADAR_PREDICTION_MAX_INTERVAL || horizon<=0) return count;
+    if(horizon>RADAR_PREDICTION_MAX_HORIZON) horizon = RADAR_PREDICTION_MAX_HORIZON;
+
+    for(i=0; i<count; i++)
+    {
+        // tracks keep their slot unless some other track was dropped, so the same index is tried first
+        int j = i;
+        if(j>=previous.count || previous.ids[j]!=last.ids[i])
+        {
+            for(j=0; j<previous.count; j++) if(previous.ids[j]==last.ids[i]) break;
+            if(j==previous.count) continue;
+        }
+
+        // zero y means that track did not exist
+        if(last.coordinates[i*2+1]==0.0 || previous.coordinates[j*2+1]==0.0) continue;
+
+        coordinates[i*2] += (float) ((last.coordinates[i*2]-previous.coordinates[j*2])*horizon/interval);
+        coordinates[i*2+1] += (float) ((last.coordinates[i*2+1]-previous.coordinates[j*2+1])*horizon/interval);
+    }
+
+    return count;
 }
 
 void radarUnit::doTransformation(float x, float y)
@@ -208,18 +267,21 @@ void radarUnit::zeroEmptyPositions(rawData * array)
     reciever_method r_method = array->getRecieverMethod();
 
     int count = 0;
+    int allocated = 0;
     float * values = NULL;
 
-    if(r_method==RS232)
+    if(r_method==RS232 || r_method==RAW_IR)
     {
         count = array->getUwbPacketTargetsCount();
         values = array->getUwbPacketCoordinates();
+        allocated = array->getUwbPacketCoordinatesCapacity();
     }
     #if defined (__WIN32__)
     else if(r_method==SYNTHETIC)
     {
         count = array->getSyntheticTargetsCount();
         values = array->getSyntheticCoordinates();
+        allocated = array->getSyntheticCoordinatesCapacity();
     }
     #endif
     else return; // unknown method
@@ -227,42 +289,98 @@ void radarUnit::zeroEmptyPositions(rawData * array)
     // catch the error pointers
     if(values==NULL || values<=0) return;
 
-    if(count<MAX_N)
+    // MTT reads always the whole array for all targets it can handle
+    // MTT object may not exist yet, but its capacity is known in advance
+    int capacity = fitTargetCapacity(targetCapacity);
+
+    if(allocated<capacity)
     {
-        // if less than MAX_N, need to put zeros on unused positions
+        // array is too short for MTT, it is stretched to fit the MTT requirements (without allocation if it fits into data object)
+        if(r_method==RS232 || r_method==RAW_IR) values = array->reserveUwbPacketCoordinates(capacity);
+        #if defined (__WIN32__)
+        else if(r_method==SYNTHETIC) values = array->reserveSyntheticCoordinates(capacity);
+        #endif
+    }
+
+    if(count<capacity)
+    {
+        // if less than capacity, need to put zeros on unused positions
         int i;
-        for(i=count; i<MAX_N; i++) values[i*2] = values[i*2+1] = 0.0;
+        for(i=count; i<capacity; i++) values[i*2] = values[i*2+1] = 0.0;
     }
-    else if(count>MAX_N)
+    // if count is greater than capacity, MTT will simply ignore the rest of targets
+}
+
+void radarUnit::resetMTT()
+{
+    // tracker is reinitialized in place, there is nothing to reset if it was not used yet
+    if(mtt_p!=NULL) mtt_p->reset();
+
+    // state waiting for restore is not valid anymore
+    if(pendingMTTState!=NULL)
     {
-        // NOTE: IN THE LATEST IMPLEMENTATION, MACRO MTT_ARRAY_FIT IS USED TO UNLOCK CODE FOR ALLOCATING MAX_N SIZE OF ARRAY
-        // IN TIME OF DATA RECIEVING. SINCE THIS FUNCTION WILL BE UNLOCKED AT THE SAME CONDITIONS AS THE MENTIONED CODES,
-        // REALLOCATION OF ARRAY IS NOT NEEDED. HOWEVER, STILL MAY BE USEFUL FOR SOME LATER MODIFICATIONS, THEREFORE REALLOCATION
-        // IS JUST COMMENTED.
+        delete pendingMTTState;
+        pendingMTTState = NULL;
+    }
+}
 
-        // if more, need to realloc array to fit the MTT requirements
-        /*
-        float * newArr = new float[MAX_N*2];
+mttSnapshot *radarUnit::saveMTTState()
+{
+    if(mtt_p!=NULL) return mtt_p->saveState();
 
-        memcpy(newArr, values, MAX_N*2*sizeof(float));
+    // MTT was not used since the last restore, so the restored state is still actual
+    if(pendingMTTState!=NULL) return new mttSnapshot(*pendingMTTState);
 
-        delete [] values;
+    return NULL;
+}
 
-        values = newArr;
+void radarUnit::restoreMTTState(const mttSnapshot *snapshot)
+{
+    if(snapshot==NULL) return;
 
-        // save new array pointer
-        if(r_method==SYNTHETIC)
-            array->setSyntheticCoordinatesPointer(values);
-        else if(r_method==RS232)
-            array->setUwbPacketCoordinates(values);
-        else return; // although this will never happen due to above conditions
-        */
+    if(mtt_p!=NULL)
+    {
+        mtt_p->restoreState(snapshot);
+        return;
     }
 
+    if(pendingMTTState!=NULL) delete pendingMTTState;
+    pendingMTTState = new mttSnapshot(*snapshot);
 }
 
-void radarUnit::resetMTT()
+void radarUnit::setMTTStateModel(mtt_state_model model)
+{
+    if(model==mttStateModel) return;
+
+    mttStateModel = model;
+
+    // state vectors of different models are not compatible, tracking starts again
+    if(mtt_p!=NULL)
+    {
+        delete mtt_p;
+        mtt_p = NULL;
+    }
+
+    if(pendingMTTState!=NULL)
+    {
+        delete pendingMTTState;
+        pendingMTTState = NULL;
+    }
+}
+
+void radarUnit::setTargetCapacity(int capacity)
 {
-    delete mtt_p;
-    mtt_p = new mtt_pure;
+    if(capacity==targetCapacity) return;
+
+    targetCapacity = capacity;
+
+    // storage size depends on capacity, so the object must be recreated (on next use), tracks are kept if they fit
+    if(mtt_p!=NULL)
+    {
+        if(pendingMTTState!=NULL) delete pendingMTTState;
+        pendingMTTState = mtt_p->saveState();
+
+        delete mtt_p;
+        mtt_p = NULL;
+    }
 }
@@ -22,6 +22,7 @@
 #include <math.h>
 #include <limits.h>
 #include <float.h>
+#include <string.h>
 #include <vector>
 #include <QDebug>
 #include <QThread>
@@ -31,6 +32,12 @@
 #include "stddefs.h"
 #include "rawdata.h"
 #include "mtt_pure.h"
+#include "radarclock.h"
+#include "radarhistory.h"
+#include "radarsnapshot.h"
+
+#define RADAR_PREDICTION_MAX_INTERVAL   (1000.0)    ///< Velocity is not estimated from data measured more than this number of milliseconds apart
+#define RADAR_PREDICTION_MAX_HORIZON    (250.0)     ///< Positions are not predicted further than this number of milliseconds
 
 using namespace std;
 
@@ -50,7 +57,7 @@ public:
 
     /**
      * @brief This function will read data from the container and apply MTT processing functions.
-     * @param[in] data Container with all data obtained by reciever and retrieved from stack.
+     * @param[in] data Container with all data obtained by reciever and retrieved from stack. Positions are copied into history and the container is deleted.
      * @param[in] enableMTT If is set to true, radar will internally use its own MTT algorithm to process data.
      * @return If the data processing was successful, the return value is true and the data in radarUnit are considered as updated.
      */
@@ -69,19 +76,49 @@ public:
     float * getCoordinatesLast(void);
 
     /**
-     * @brief Provides fast access to pointer of array with coordinates from iteration specified by index.
-     * @param[in] index Is the depth of recursion from which we would like to obtain the number of targets.
+     * @brief Provides identifiers of targets from latest iteration. If MTT is used, identifier of target stays the same while the target is tracked.
+     * @return The return value is pointer to array of 'getNumberOfTargetsLast()' identifiers or NULL if there are no data.
+     */
+    int * getIdsLast(void) { return history->getIds(history->getCount()-1); }
+
+    /**
+     * @brief Provides fast access to the number of targets from iteration specified by index.
+     * @param[in] index Is the index of frame in history (0 is the oldest one) from which we would like to obtain the number of targets.
      * @return The return value is the number of targets from specified iteration.
      */
     int getNumberOfTargetsAt(int index);
 
     /**
      * @brief Provides fast access to pointer of array with coordinates directly from iteration specified by index.
-     * @param[in] index Is the depth of recursion from which we would like to obtain coordinates.
+     * @param[in] index Is the index of frame in history (0 is the oldest one) from which we would like to obtain coordinates.
      * @return The return value is the pointer to array where all coordinates are stored.
      */
     float * getCoordinatesAt(int index);
 
+    /**
+     * @brief Provides access to all frames kept by radar unit, e.g. for queries by time.
+     * @return Pointer to history object owned by radar unit.
+     */
+    radarHistory * getHistory(void) { return history; }
+
+    /**
+     * @brief Changes the number of frames kept by radar unit. The newest frames are kept if history is shortened.
+     * @param[in] depth New number of frames.
+     */
+    void setHistoryDepth(int depth) { history->setDepth(depth); }
+
+    /**
+     * @brief Returns the number of frames kept by radar unit.
+     * @return Depth of history.
+     */
+    int getHistoryDepth(void) { return history->getDepth(); }
+
+    /**
+     * @brief Returns slot with the newest frame of this unit. Readers in other threads (e.g. radar subwindows) take immutable snapshots from it instead of accessing history.
+     * @return Pointer to slot owned by radar unit. Call 'snapshotSlot::ref' to keep it after unit is deleted.
+     */
+    snapshotSlot * getSnapshotSlot(void) { return snapshots; }
+
     /**
      * @brief Returns the currently set x-position of radar unit in relation to operator unit. If is equal to zero (default value), probably was not set.
      * @return The return value is the x-position of radar unit.
@@ -153,26 +190,85 @@ public:
     float getTransformatedY(void) { return tempY; }
 
     /**
-     * @brief Function takes the array and checks for maximum targets allowed. If array is big, length > MAX_N*2 macro are deleted and array is rescaled. If length < MAX_N*2, rest is zeroed.
+     * @brief Function takes the array and prepares it for MTT. If array has less positions than MTT capacity, array is reallocated. Positions after the last target up to capacity are zeroed.
      * @param[in] array Is pointer to object holding the array that is required to process.
      */
     void zeroEmptyPositions(rawData * array);
 
     /**
-     * @brief This function will delete and again create MTT object, so default values are set. This is necessary if starting new reciever or resuming after pause.
+     * @brief Returns the host time the last data were measured at (estimated from radar time, see 'radarClock').
+     * @return Milliseconds since epoch, -1 if there are no data.
+     */
+    double getMeasurementTimeLast(void);
+
+    /**
+     * @brief Predicts positions of the last data to another time, so positions of radars measured at different times can be fused.
+     * @param[in] epoch Host time in milliseconds since epoch.
+     * @param[out] coordinates Array for 'getNumberOfTargetsLast()' [x, y] positions in radar coordinate system.
+     * @return Number of positions written.
+     *
+     * Velocity is estimated from the last two data, so only positions from MTT (with stable indexes of tracks) are predicted,
+     * other positions are copied unchanged. Positions are never predicted backwards nor further than RADAR_PREDICTION_MAX_HORIZON.
+     */
+    int predictCoordinatesLast(double epoch, float * coordinates);
+
+    /**
+     * @brief Sets the maximum number of targets handled by radar unit MTT. If capacity differs from current one, MTT object is released and created again on next use. Tracks not fitting new capacity are lost.
+     * @param[in] capacity New number of targets.
+     */
+    void setTargetCapacity(int capacity);
+
+    /**
+     * @brief Returns the number of targets radar unit MTT was created for.
+     * @return Capacity of MTT object.
+     */
+    int getTargetCapacity(void) { return targetCapacity; }
+
+    /**
+     * @brief Selects the state model of radar unit MTT. If model differs from current one, MTT object is released and created again on next use (tracks are lost).
+     * @param[in] model New state model.
+     */
+    void setMTTStateModel(mtt_state_model model);
+
+    /**
+     * @brief Returns the state model used by radar unit MTT.
+     * @return State model of MTT object.
+     */
+    mtt_state_model getMTTStateModel(void) { return mttStateModel; }
+
+    /**
+     * @brief This function will reinitialize MTT object in place, so default values are set. This is necessary if starting new reciever or resuming after pause.
      */
     void resetMTT(void);
 
+    /**
+     * @brief Creates snapshot of radar unit MTT state.
+     * @return Pointer to newly allocated snapshot (caller is responsible for its deletion) or NULL if MTT object was not used yet and no snapshot is waiting for restore.
+     */
+    mttSnapshot * saveMTTState(void);
+
+    /**
+     * @brief Restores radar unit MTT state from snapshot. If MTT object does not exist yet, copy of snapshot is kept and applied when MTT object is created.
+     * @param[in] snapshot Snapshot of MTT state. The object is not taken over, caller may delete it.
+     */
+    void restoreMTTState(const mttSnapshot * snapshot);
+
 
 private:
     /* FOR TEST PURPOSES - TEST OF MTT_PURE LIBRARY */
-    mtt_pure * mtt_p;
+    mtt_pure * mtt_p; ///< MTT object, created on the first 'processNewData' call with MTT enabled
+    mttSnapshot * pendingMTTState; ///< Snapshot waiting for MTT object creation, NULL if there is nothing to restore
+
+    radarClock * clock; ///< Converts radar time of packets to host time of measurement
+
+    int targetCapacity; ///< Number of targets requested for MTT object (real MTT capacity may be slightly greater, see 'fitTargetCapacity')
+    mtt_state_model mttStateModel; ///< State model of MTT object (polar or cartesian Kalman filters)
 
     int radar_id; ///< Main radar identificator
     bool enabled; ///< Specifies if the radar is enabled/disabled by user. If set to false, this unit should not be considered during data fusion. This value is always set to false if the unit was created by application automatically.
-    unsigned int max_recursion; ///< The maximum data handling at one time dataList
 
-    QList<rawData * > * dataList; ///< Handles all recieved data with MTT applied. Maximum number is specified in max_recursion
+    radarHistory * history; ///< Positions of all recieved data with MTT applied, the oldest frames are overwritten
+    snapshotSlot * snapshots; ///< The newest frame shared with readers in other threads
 
     double xpos; ///< Handles the x position of radar's coordinate system in relation to operator. If no value is specified, default value is 0.
     double ypos; ///< Handles the y position of radar's coordinate system in relation to operator. If no value is specified, default value is 0.
@@ -15,10 +15,31 @@
 
 #include "rawdata.h"
 
+recordPool * rawData::pool = new recordPool(sizeof(rawData));
+
+void * rawData::operator new(size_t size)
+{
+    // objects are never derived, so all of them have the same size
+    Q_UNUSED(size);
+    void * record = pool->acquire();
+    if(record==NULL) throw std::bad_alloc();
+
+    return record;
+}
+
+void rawData::operator delete(void *record)
+{
+    pool->release(record);
+}
+
 rawData::rawData()
 {
     syntheticData = NULL;
     uwbPacketData = NULL;
+
+    // data are created by reciever as soon as they arrive
+    arrivalTime = QDateTime::currentMSecsSinceEpoch();
+    measurementTime = (double) arrivalTime;
 }
 
 rawData::~rawData()
@@ -26,14 +47,12 @@ rawData::~rawData()
     // free all memory
     if(syntheticData!=NULL)
     {
-        if(syntheticData->coordinates != NULL) delete syntheticData->coordinates;
-        if(syntheticData->toas != NULL) delete syntheticData->toas;
-
-        delete syntheticData;
+        freeCoordinates(syntheticData->coordinates);
+        if(syntheticData->toas != NULL) delete [] syntheticData->toas;
     }
     if(uwbPacketData!=NULL)
     {
-        delete uwbPacketData;
+        freeCoordinates(uwbPacketData->coordinates);
     }
 }
 
@@ -74,7 +93,7 @@ void rawData::setSyntheticCoordinates(float *coords)
 {
     if(syntheticData!=NULL)
     {
-        if(syntheticData->coordinates!=NULL) delete syntheticData->coordinates;
+        freeCoordinates(syntheticData->coordinates);
 
         syntheticData->coordinates = coords;
     } else {
@@ -92,7 +111,7 @@ void rawData::setSyntheticToas(float *toas)
 {
     if(syntheticData!=NULL)
     {
-        if(syntheticData->toas!=NULL) delete syntheticData->toas;
+        if(syntheticData->toas!=NULL) delete [] syntheticData->toas;
 
         syntheticData->toas = toas;
     } else {
@@ -101,6 +120,17 @@ void rawData::setSyntheticToas(float *toas)
     }
 }
 
+void rawData::setSyntheticCoordinatesCapacity(int capacity)
+{
+    if(syntheticData!=NULL)
+    {
+        syntheticData->coordinates_capacity = capacity;
+    } else {
+        createSyntheticDataStruct();
+        syntheticData->coordinates_capacity = capacity;
+    }
+}
+
 void rawData::setUwbPacketRadarId(int id)
 {
     if(uwbPacketData!=NULL)
@@ -149,7 +179,7 @@ void rawData::setUwbPacketCoordinates(float *coordinates)
 {
     if(uwbPacketData!=NULL)
     {
-        if(uwbPacketData->coordinates!=NULL) delete uwbPacketData->coordinates;
+        freeCoordinates(uwbPacketData->coordinates);
 
         uwbPacketData->coordinates = coordinates;
     } else {
@@ -158,18 +188,72 @@ void rawData::setUwbPacketCoordinates(float *coordinates)
     }
 }
 
+void rawData::setUwbPacketCoordinatesCapacity(int capacity)
+{
+    if(uwbPacketData!=NULL)
+    {
+        uwbPacketData->coordinates_capacity = capacity;
+    } else {
+        createUwbPcketDataStruct();
+        uwbPacketData->coordinates_capacity = capacity;
+    }
+}
+
+float *rawData::reserveSyntheticCoordinates(int capacity)
+{
+    if(syntheticData==NULL) createSyntheticDataStruct();
+
+    syntheticData->coordinates = growCoordinates(syntheticData->coordinates, syntheticData->coordinates_capacity, capacity);
+    if(capacity>syntheticData->coordinates_capacity) syntheticData->coordinates_capacity = capacity;
+
+    return syntheticData->coordinates;
+}
+
+float *rawData::reserveUwbPacketCoordinates(int capacity)
+{
+    if(uwbPacketData==NULL) createUwbPcketDataStruct();
+
+    uwbPacketData->coordinates = growCoordinates(uwbPacketData->coordinates, uwbPacketData->coordinates_capacity, capacity);
+    if(capacity>uwbPacketData->coordinates_capacity) uwbPacketData->coordinates_capacity = capacity;
+
+    return uwbPacketData->coordinates;
+}
+
+float *rawData::growCoordinates(float *coordinates, int old_capacity, int capacity)
+{
+    if(coordinates!=NULL && old_capacity>=capacity) return coordinates;
+
+    if(coordinates==NULL) old_capacity = 0;
+
+    // inline array is used only if it is not used already (by the other structure or by this one)
+    float * array;
+    if(capacity<=RAWDATA_INLINE_TARGETS && coordinates!=coordinatesStorage &&
+       (syntheticData==NULL || syntheticData->coordinates!=coordinatesStorage) &&
+       (uwbPacketData==NULL || uwbPacketData->coordinates!=coordinatesStorage))
+        array = coordinatesStorage;
+    else
+        array = new float[capacity*2];
+
+    if(old_capacity>0) memcpy(array, coordinates, old_capacity*2*sizeof(float));
+    freeCoordinates(coordinates);
+
+    return array;
+}
+
 void rawData::createSyntheticDataStruct()
 {
-    syntheticData = new synthetic_data;
+    syntheticData = &syntheticStorage;
     syntheticData->coordinates = NULL;
     syntheticData->toas = NULL;
     syntheticData->radar_id = syntheticData->targets_count = syntheticData->time = 0;
+    syntheticData->coordinates_capacity = 0;
 }
 
 void rawData::createUwbPcketDataStruct()
 {
-    uwbPacketData = new uwb_packet;
+    uwbPacketData = &uwbPacketStorage;
     uwbPacketData->coordinates = NULL;
     uwbPacketData->packet_count = uwbPacketData->radar_id = uwbPacketData->radar_time = uwbPacketData->targets_count = 0;
+    uwbPacketData->coordinates_capacity = 0;
 }
 
@@ -11,15 +11,25 @@
  * required by program and have methods for manupulating with those data. As the only
  * class for data concentrating it is very easy to migrate these across the higher classes
  * if needed and represents the only base return value of 'reciever' class.
+ *
+ * Objects are allocated from 'recordPool' instead of heap and packet structures are stored inside
+ * of object together with coordinates of up to RAWDATA_INLINE_TARGETS targets, so receiving packet
+ * and freeing it in another thread does not call malloc/free in steady state.
  */
 
 #ifndef RAWDATA_H
 #define RAWDATA_H
 
 #include <stdlib.h>
+#include <string.h>
+#include <new>
 #include <QDebug>
+#include <QDateTime>
 
 #include "stddefs.h"
+#include "recordpool.h"
+
+#define RAWDATA_INLINE_TARGETS  (32)        ///< Number of [x, y] positions stored inside of object, longer coordinate arrays are allocated from heap
 
 class rawData
 {
@@ -35,6 +45,25 @@ public:
     rawData();  
     ~rawData();
 
+    /**
+     * @brief Allocates object from pool of released objects.
+     * @param[in] size Size of object.
+     * @return Memory for new object. Throws std::bad_alloc if no memory is available.
+     */
+    static void * operator new(size_t size);
+
+    /**
+     * @brief Returns memory of object to pool. Can be called from any thread.
+     * @param[in] record Memory of deleted object.
+     */
+    static void operator delete(void * record);
+
+    /**
+     * @brief Returns the number of objects allocated from heap so far (maximal number of objects in flight).
+     * @return Number of objects.
+     */
+    static int getPoolCreatedCount(void) { return pool->getCreatedCount(); }
+
     /**
      * @brief This function serves higher classes to find out, what method was used for the particular data
      * @return The return value is the 'reciever_method' structure.
@@ -55,6 +84,30 @@ public:
      */
     void setRecieverMethod(reciever_method recieverMethod) { method = recieverMethod; }
 
+    /**
+     * @brief Returns the host time the data were recieved at.
+     * @return Milliseconds since epoch. By default it is the time the object was created by 'reciever'.
+     */
+    qint64 getArrivalTime(void) { return arrivalTime; }
+
+    /**
+     * @brief Sets the host time the data were recieved at (e.g. if data are not recieved live).
+     * @param[in] time Milliseconds since epoch.
+     */
+    void setArrivalTime(qint64 time) { arrivalTime = time; }
+
+    /**
+     * @brief Returns the host time the data were measured at, estimated from radar time by 'radarUnit'.
+     * @return Milliseconds since epoch. Equal to arrival time until data are processed by radar unit.
+     */
+    double getMeasurementTime(void) { return measurementTime; }
+
+    /**
+     * @brief Sets the host time the data were measured at.
+     * @param[in] time Milliseconds since epoch.
+     */
+    void setMeasurementTime(double time) { measurementTime = time; }
+
     /**
      * @brief Returns radar id if the value is availible else -1.
      * @return The return value is the id of radar.
@@ -85,6 +138,12 @@ public:
      */
     float * getSyntheticToas(void) { return (syntheticData!=NULL) ? syntheticData->toas : NULL; }
 
+    /**
+     * @brief Returns the number of [x, y] positions allocated in coordinates array (may be greater than targets count if MTT_ARRAY_FIT is used), else -1.
+     * @return The return value is the number of [x, y] positions in coordinates array.
+     */
+    int getSyntheticCoordinatesCapacity(void) { return (syntheticData!=NULL) ? syntheticData->coordinates_capacity : -1; }
+
     /**
      * @brief Sets new radar ID
      * @param The only parameter is radar ID
@@ -137,6 +196,22 @@ public:
      */
     void setSyntheticToas(float * toas);
 
+    /**
+     * @brief Sets the number of [x, y] positions allocated in coordinates array. Must be called always when new coordinates array is set and is longer than targets count.
+     * @param[in] capacity Number of [x, y] positions in array.
+     */
+    void setSyntheticCoordinatesCapacity(int capacity);
+
+    /**
+     * @brief Makes coordinates array long enough for 'capacity' [x, y] positions and sets the capacity. If structure does not exist yet, it will be created.
+     * @param[in] capacity Required number of [x, y] positions.
+     * @return Pointer to coordinates array. Stored coordinates are kept, new positions are not initialized.
+     *
+     * Up to RAWDATA_INLINE_TARGETS positions are stored inside of object, so no memory is allocated.
+     * Array is never shrunk.
+     */
+    float * reserveSyntheticCoordinates(int capacity);
+
     /**
      * @brief Allows to set new radar ID to appropriate structure. If structure does not exist yet, it will be created.
      * @param[in] id New radar id.
@@ -167,6 +242,22 @@ public:
      */
     void setUwbPacketCoordinates(float * coordinates);
 
+    /**
+     * @brief Sets the number of [x, y] positions allocated in coordinates array. Must be called always when new coordinates array is set and is longer than targets count. If structure does not exist yet, it will be created.
+     * @param[in] capacity Number of [x, y] positions in array.
+     */
+    void setUwbPacketCoordinatesCapacity(int capacity);
+
+    /**
+     * @brief Makes coordinates array long enough for 'capacity' [x, y] positions and sets the capacity. If structure does not exist yet, it will be created.
+     * @param[in] capacity Required number of [x, y] positions.
+     * @return Pointer to coordinates array. Stored coordinates are kept, new positions are not initialized.
+     *
+     * Up to RAWDATA_INLINE_TARGETS positions are stored inside of object, so no memory is allocated.
+     * Array is never shrunk.
+     */
+    float * reserveUwbPacketCoordinates(int capacity);
+
     /**
      * @brief Retrieves the radar id which was the packet send from.
      * @return Radar id as integer number. If uwb packet structure was not created yet, return value is -1.
@@ -197,11 +288,20 @@ public:
      */
     float * getUwbPacketCoordinates(void) { return (uwbPacketData!=NULL) ? uwbPacketData->coordinates : NULL; }
 
+    /**
+     * @brief Retrieves the number of [x, y] positions allocated in coordinates array (may be greater than targets count if MTT_ARRAY_FIT is used).
+     * @return Number of [x, y] positions in array. If uwb packet structure was not created yet, return value is -1.
+     */
+    int getUwbPacketCoordinatesCapacity(void) { return (uwbPacketData!=NULL) ? uwbPacketData->coordinates_capacity : -1; }
+
 
 private:
 
     reciever_method method;
 
+    qint64 arrivalTime; ///< Host time of data arrival in milliseconds since epoch
+    double measurementTime; ///< Host time of measurement in milliseconds since epoch, estimated from radar time
+
     /**
      * @brief Method for allocating memory and initialization of 'syntheticData' structure
      */
@@ -220,6 +320,7 @@ private:
         short targets_count; ///< The number of targets visible by radar with 'radar_id'
         float * coordinates; ///< The array of coordinates [x, y] gradually
         float * toas; ///< The TOA value measured in time or distance depending on generator setup for left and right antenna gradually
+        int coordinates_capacity; ///< The number of [x, y] positions allocated in 'coordinates' array
     };
 
     /**
@@ -245,11 +346,34 @@ private:
         int targets_count; ///< Number of targets (or [x, y] combinations in array)
         int radar_time; ///< Radar time, for synchronization
         int packet_count; ///< Packet count, used for detecting lost packets
+        int coordinates_capacity; ///< The number of [x, y] positions allocated in 'coordinates' array
     };
 
-    synthetic_data * syntheticData; ///< The structure for storing synthetic data
+    synthetic_data * syntheticData; ///< The structure for storing synthetic data, points to 'syntheticStorage' when created
+
+    uwb_packet * uwbPacketData; ///< The structure for storing uwb radar packet data, points to 'uwbPacketStorage' when created
+
+    synthetic_data syntheticStorage; ///< Memory of 'syntheticData' structure
+    uwb_packet uwbPacketStorage; ///< Memory of 'uwbPacketData' structure
+
+    float coordinatesStorage[RAWDATA_INLINE_TARGETS*2]; ///< Coordinates array used if it is short enough (data hold only one of structures at a time)
 
-    uwb_packet * uwbPacketData; ///< The structure for storing uwb radar packet data
+    static recordPool * pool; ///< Pool of released objects, never destroyed so objects can be deleted at any time
+
+    /**
+     * @brief Deletes coordinates array unless it is stored inside of object.
+     * @param[in] coordinates Coordinates array or NULL.
+     */
+    void freeCoordinates(float * coordinates) { if(coordinates!=NULL && coordinates!=coordinatesStorage) delete [] coordinates; }
+
+    /**
+     * @brief Returns coordinates array for at least 'capacity' positions with the same content as old array. Old array is freed if replaced.
+     * @param[in] coordinates Old coordinates array or NULL.
+     * @param[in] old_capacity Number of positions in old array.
+     * @param[in] capacity Required number of positions.
+     * @return Old array if it is long enough, else new array.
+     */
+    float * growCoordinates(float * coordinates, int old_capacity, int capacity);
 };
 
 #endif // RAWDATA_H
@@ -39,12 +39,13 @@ char comports_list[comports_array_count][10]={"\\\\.\\COM1",  "\\\\.\\COM2",  "\
                        "\\\\.\\COM13", "\\\\.\\COM14", "\\\\.\\COM15", "\\\\.\\COM16"};
 #endif
 
-reciever::reciever(reciever_method recieveMethod)
+reciever::reciever(reciever_method recieveMethod, int target_capacity)
     #if defined (__WIN32__)
     : maximum_pipe_size(512)
     #endif
 {
     r_method = UNDEFINED;
+    targetCapacity = target_capacity;
     last_data_pt = NULL;
     statusMsg = NULL;
 
@@ -56,18 +57,36 @@ reciever::reciever(reciever_method recieveMethod)
     comPortCallibration = false;
     packetReciever = NULL;
 
+    rawIRSourceType = RAW_IR_FILE;
+    memset(&rawIRParameters, 0, sizeof(ir_detection_parameters));
+    rawIRFile = NULL;
+    rawIRSocket = NULL;
+    rawIRScan = NULL;
+    rawIRScans = 0;
+    rawIRDetectionTime = 0;
+    rawIRScansPerSecond = 0.0;
+
+    replaySpeed = 1.0;
+    replaySourceHandler = NULL;
+    replayFirstTime = replayStartTime = 0;
+    replayRecords = replayReportTime = 0;
+    replayRecordsPerSecond = 0.0;
+    replayFinished = false;
+    replayCancelled.storeRelease(0);
+
     calibrationStatus = calibrate(recieveMethod);
 
     if(calibrationStatus) set_msg("Calibration successfull.");
     else set_msg("An error occured when trying to set up selected method.");
 }
 
-reciever::reciever(reciever_method recieveMethod, char * comport_name, int baud_rate, char *comport_mode)
+reciever::reciever(reciever_method recieveMethod, char * comport_name, int baud_rate, char *comport_mode, int target_capacity)
     #if defined (__WIN32__)
     : maximum_pipe_size(0)
     #endif
 {
     r_method = UNDEFINED;
+    targetCapacity = target_capacity;
     last_data_pt = NULL;
     statusMsg = NULL;
 
@@ -77,6 +96,105 @@ reciever::reciever(reciever_method recieveMethod, char * comport_name, int baud_
     comPortCallibration = false;
     packetReciever = NULL;
 
+    rawIRSourceType = RAW_IR_FILE;
+    memset(&rawIRParameters, 0, sizeof(ir_detection_parameters));
+    rawIRFile = NULL;
+    rawIRSocket = NULL;
+    rawIRScan = NULL;
+    rawIRScans = 0;
+    rawIRDetectionTime = 0;
+    rawIRScansPerSecond = 0.0;
+
+    replaySpeed = 1.0;
+    replaySourceHandler = NULL;
+    replayFirstTime = replayStartTime = 0;
+    replayRecords = replayReportTime = 0;
+    replayRecordsPerSecond = 0.0;
+    replayFinished = false;
+    replayCancelled.storeRelease(0);
+
+    calibrationStatus = calibrate(recieveMethod);
+
+    if(calibrationStatus) set_msg("Calibration successfull.");
+    else set_msg("An error occured when trying to set up selected method.");
+}
+
+reciever::reciever(reciever_method recieveMethod, raw_ir_source source_type, const QString &source, const ir_detection_parameters &detection_params, int target_capacity)
+    #if defined (__WIN32__)
+    : maximum_pipe_size(0)
+    #endif
+{
+    r_method = UNDEFINED;
+    targetCapacity = target_capacity;
+    last_data_pt = NULL;
+    statusMsg = NULL;
+
+    port_index = -1;
+    comPort = NULL;
+    comPortBaudRate = 9600;
+    comPortMode = NULL;
+    comPortCallibration = false;
+    packetReciever = NULL;
+
+    rawIRSourceType = source_type;
+    rawIRSource = source;
+    rawIRParameters = detection_params;
+    rawIRFile = NULL;
+    rawIRSocket = NULL;
+    rawIRScan = NULL;
+    rawIRScans = 0;
+    rawIRDetectionTime = 0;
+    rawIRScansPerSecond = 0.0;
+
+    replaySpeed = 1.0;
+    replaySourceHandler = NULL;
+    replayFirstTime = replayStartTime = 0;
+    replayRecords = replayReportTime = 0;
+    replayRecordsPerSecond = 0.0;
+    replayFinished = false;
+    replayCancelled.storeRelease(0);
+
+    calibrationStatus = calibrate(recieveMethod);
+
+    if(calibrationStatus) set_msg("Calibration successfull.");
+    else set_msg("An error occured when trying to set up selected method.");
+}
+
+reciever::reciever(reciever_method recieveMethod, const QString &replay_file, double replay_speed, int target_capacity)
+    #if defined (__WIN32__)
+    : maximum_pipe_size(0)
+    #endif
+{
+    r_method = UNDEFINED;
+    targetCapacity = target_capacity;
+    last_data_pt = NULL;
+    statusMsg = NULL;
+
+    port_index = -1;
+    comPort = NULL;
+    comPortBaudRate = 9600;
+    comPortMode = NULL;
+    comPortCallibration = false;
+    packetReciever = NULL;
+
+    rawIRSourceType = RAW_IR_FILE;
+    memset(&rawIRParameters, 0, sizeof(ir_detection_parameters));
+    rawIRFile = NULL;
+    rawIRSocket = NULL;
+    rawIRScan = NULL;
+    rawIRScans = 0;
+    rawIRDetectionTime = 0;
+    rawIRScansPerSecond = 0.0;
+
+    replayFile = replay_file;
+    replaySpeed = replay_speed;
+    replaySourceHandler = NULL;
+    replayFirstTime = replayStartTime = 0;
+    replayRecords = replayReportTime = 0;
+    replayRecordsPerSecond = 0.0;
+    replayFinished = false;
+    replayCancelled.storeRelease(0);
+
     calibrationStatus = calibrate(recieveMethod);
 
     if(calibrationStatus) set_msg("Calibration successfull.");
@@ -170,7 +288,7 @@ rawData * reciever::listen()
         }
 
         // if packet is unreadable, return NULL and save appropriate message
-        if(!packetReciever->readPacket())
+        if(packetReciever->readPacket()<=0)
         {
             // ADD MESSAGES ACCORDING TO CODE HERE!!!
             return NULL;
@@ -180,6 +298,33 @@ rawData * reciever::listen()
         data = extract_RS232_radar_packet();
         last_data_pt = data;
     }
+    else if(r_method==RAW_IR)
+    {
+        // read raw frame and detect targets, result looks like packet with coordinates from radar
+        data = extract_raw_ir_frame();
+
+        if(data==NULL) {
+            set_msg("Could not read complete raw impulse response frame. End of file was reached or server is not sending data.");
+            last_data_pt = NULL;
+            return NULL;
+        }
+
+        last_data_pt = data;
+    }
+    else if(r_method==REPLAY)
+    {
+        // recorded data are fed when they are due on virtual clock
+        data = extract_replay_record();
+
+        if(data==NULL) {
+            if(replayCancelled.loadAcquire()) set_msg("Replay was cancelled.");
+            else set_msg("The end of replayed file was reached.");
+            last_data_pt = NULL;
+            return NULL;
+        }
+
+        last_data_pt = data;
+    }
     else data = last_data_pt = NULL; // when no method was selected
 
     return data;
@@ -233,6 +378,24 @@ bool reciever::set_new_method_code(reciever_method recieveMethod, bool kill)
 
             break;
 
+        case RAW_IR:
+            calibrationStatus = calibrate(recieveMethod);
+            if(!calibrationStatus) set_msg("The source of raw impulse responses could not be opened. Check file path or server address.");
+            else r_method = RAW_IR;
+
+            return calibrationStatus;
+
+            break;
+
+        case REPLAY:
+            calibrationStatus = calibrate(recieveMethod);
+            if(!calibrationStatus) set_msg("The replayed file could not be opened. Check file path.");
+            else r_method = REPLAY;
+
+            return calibrationStatus;
+
+            break;
+
         default:
             set_msg("You are trying to set up unavailible method. The old method is allowed.");
             return false;
@@ -292,12 +455,60 @@ bool reciever::calibrate(reciever_method recieveMethod)
             // comport opened successfuly and is ready for recieving data
             comPortCallibration = true;
             qDebug() << "Comport with index " << port_index << " was initialized correctly.";
-            packetReciever = new uwbPacketRx(port_index);
+            packetReciever = new uwbPacketRx(port_index, targetCapacity);
             r_method = recieveMethod;
             return true;
         }
 
     }
+    else if(recieveMethod==RAW_IR)
+    {
+        if(rawIRSourceType==RAW_IR_FILE)
+        {
+            rawIRFile = fopen(rawIRSource.toLocal8Bit().constData(), "rb");
+            if(rawIRFile==NULL)
+            {
+                qDebug() << "Raw impulse response file " << rawIRSource << " could not be opened.";
+                return false;
+            }
+        }
+        else
+        {
+            // socket belongs to the thread it was created in, so connection is established on the first 'listen' call
+            // from data input thread, only the address is checked here
+            if(!rawIRSource.contains(':') || rawIRSource.section(':', -1).toInt()<=0)
+            {
+                qDebug() << "Invalid address of raw impulse response server " << rawIRSource << ". Use \"host:port\" format.";
+                return false;
+            }
+        }
+
+        rawIRScan = new float[2*SCANLENGHT];
+        rawIRScans = 0;
+        rawIRDetectionTime = 0;
+
+        r_method = recieveMethod;
+        return true;
+    }
+    else if(recieveMethod==REPLAY)
+    {
+        replaySourceHandler = new replaySource(targetCapacity);
+        if(!replaySourceHandler->open(replayFile))
+        {
+            delete replaySourceHandler;
+            replaySourceHandler = NULL;
+            return false;
+        }
+
+        // virtual clock starts with the first record
+        replayRecords = 0;
+        replayReportTime = 0;
+        replayFinished = false;
+        replayCancelled.storeRelease(0);
+
+        r_method = recieveMethod;
+        return true;
+    }
     else return false;
 
     return false;
@@ -332,6 +543,34 @@ bool reciever::cancel_previous_method()
             return true;
         }
     }
+    else if(r_method==RAW_IR)
+    {
+        if(rawIRFile!=NULL) fclose(rawIRFile);
+        rawIRFile = NULL;
+
+        if(rawIRSocket!=NULL)
+        {
+            rawIRSocket->abort();
+            delete rawIRSocket;
+        }
+        rawIRSocket = NULL;
+
+        // detection state is not valid for another source
+        qDeleteAll(rawIRDetectors);
+        rawIRDetectors.clear();
+
+        if(rawIRScan!=NULL) delete [] rawIRScan;
+        rawIRScan = NULL;
+
+        return true;
+    }
+    else if(r_method==REPLAY)
+    {
+        if(replaySourceHandler!=NULL) delete replaySourceHandler;
+        replaySourceHandler = NULL;
+
+        return true;
+    }
 
     return true;
 }
@@ -420,10 +659,11 @@ rawData * reciever::extract_synthetic(char * msg)
     data->setSyntheticTargetsCount((short)(atoi(tokens[i++])));
 
     #if defined MTT_ARRAY_FIT && MTT_ARRAY_FIT==1
-        float * coordinates = new float[MAX_N*2];
-        float * toas = new float[MAX_N*2];
+        int capacity = (data->getSyntheticTargetsCount()>targetCapacity) ? data->getSyntheticTargetsCount() : targetCapacity;
+        float * coordinates = data->reserveSyntheticCoordinates(capacity);
+        float * toas = new float[capacity*2];
     #else
-        float * coordinates = new float[data->getSyntheticTargetsCount()*2];
+        float * coordinates = data->reserveSyntheticCoordinates(data->getSyntheticTargetsCount());
         float * toas = new float[data->getSyntheticTargetsCount()*2];
     #endif
 
@@ -439,7 +679,6 @@ rawData * reciever::extract_synthetic(char * msg)
         }
     }
 
-    data->setSyntheticCoordinates(coordinates);
     data->setSyntheticToas(toas);
     data->setRecieverMethod(SYNTHETIC);
 
@@ -455,11 +694,212 @@ rawData * reciever::extract_RS232_radar_packet()
     data->setUwbPacketRadarTime(packetReciever->getRadarTime());
     data->setUwbPacketPacketNumber(packetReciever->getPacketCount());
     data->setUwbPacketTargetsCount(packetReciever->getDataCount()/2);
-    data->setUwbPacketCoordinates(packetReciever->getData());
+    #if defined MTT_ARRAY_FIT && MTT_ARRAY_FIT==1
+        int capacity = packetReciever->getDataCapacity();
+    #else
+        int capacity = packetReciever->getDataCount()/2;
+    #endif
+    // packet reciever overwrites its array with the next packet, coordinates are copied into data object
+    memcpy(data->reserveUwbPacketCoordinates(capacity), packetReciever->getData(), capacity*2*sizeof(float));
     data->setRecieverMethod(RS232);
     return data;
 }
 
+bool reciever::read_raw_ir_frame(raw_ir_frame_header *header)
+{
+    if(rawIRSourceType==RAW_IR_FILE)
+    {
+        if(fread(header, sizeof(raw_ir_frame_header), 1, rawIRFile)!=1) return false;
+        return fread(rawIRScan, sizeof(float), 2*SCANLENGHT, rawIRFile)==2*SCANLENGHT;
+    }
+
+    if(rawIRSocket==NULL)
+    {
+        rawIRSocket = new QTcpSocket;
+        rawIRSocket->connectToHost(rawIRSource.section(':', 0, -2), rawIRSource.section(':', -1).toUShort());
+
+        if(!rawIRSocket->waitForConnected(RAW_IR_SOCKET_TIMEOUT))
+        {
+            qDebug() << "Could not connect to raw impulse response server " << rawIRSource;
+            delete rawIRSocket;
+            rawIRSocket = NULL;
+            return false;
+        }
+    }
+
+    qint64 headerBytes = read_raw_ir_socket((char *)(header), sizeof(raw_ir_frame_header));
+    if(headerBytes==0) return false; // server is not sending, connection is kept
+
+    if(headerBytes==(qint64)(sizeof(raw_ir_frame_header)) &&
+       read_raw_ir_socket((char *)(rawIRScan), 2*SCANLENGHT*sizeof(float))==(qint64)(2*SCANLENGHT*sizeof(float))) return true;
+
+    // frame was read only partially, the position in stream is lost, new connection starts with new frame
+    qDebug() << "Incomplete raw impulse response frame, reconnecting to " << rawIRSource;
+    rawIRSocket->abort();
+    delete rawIRSocket;
+    rawIRSocket = NULL;
+
+    return false;
+}
+
+qint64 reciever::read_raw_ir_socket(char *buffer, qint64 size)
+{
+    qint64 done = 0;
+    qint64 count;
+
+    while(done<size)
+    {
+        if(rawIRSocket->bytesAvailable()==0 && !rawIRSocket->waitForReadyRead(RAW_IR_SOCKET_TIMEOUT)) break;
+
+        count = rawIRSocket->read(buffer+done, size-done);
+        if(count<0) break;
+
+        done += count;
+    }
+
+    return done;
+}
+
+void reciever::set_raw_ir_averaging(int radar_id, int count, int hop)
+{
+    rawIRAveragingMutex.lock();
+    rawIRAveraging.insert(radar_id, QPair<int, int>(count, hop));
+    rawIRAveragingMutex.unlock();
+}
+
+rawData * reciever::extract_raw_ir_frame()
+{
+    raw_ir_frame_header header;
+    mtt_pure * detector;
+    QPair<int, int> averaging;
+
+    // with software averaging several frames of the same radar are consumed before averaged scan is ready
+    do
+    {
+        if(!read_raw_ir_frame(&header)) return NULL;
+
+        // each radar has own background estimation and traces from previous scans
+        detector = rawIRDetectors.value(header.radar_id, NULL);
+        if(detector==NULL)
+        {
+            detector = new mtt_pure(MAX_N);
+            rawIRDetectors.insert(header.radar_id, detector);
+        }
+
+        rawIRAveragingMutex.lock();
+        averaging = rawIRAveraging.value(header.radar_id, QPair<int, int>(rawIRParameters.sa_count, rawIRParameters.sa_hop));
+        rawIRAveragingMutex.unlock();
+
+        // averaging ring is cleared only if settings really changed
+        detector->setAveraging(averaging.first, averaging.second);
+    }
+    while(!detector->average(rawIRScan));
+
+    // detection chain always fills MAX_N positions
+    int capacity = (targetCapacity>MAX_N) ? targetCapacity : MAX_N;
+
+    // detector writes directly into coordinates of data object
+    rawData * data = new rawData;
+    float * coordinates = data->reserveUwbPacketCoordinates(capacity);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    int count = detector->detect(rawIRScan, &rawIRParameters, coordinates);
+
+    rawIRDetectionTime += timer.nsecsElapsed();
+    rawIRScans++;
+
+    if(rawIRScans>=RAW_IR_REPORT_INTERVAL)
+    {
+        // only time spent in detection is measured, so the value is throughput of one core regardless of input speed
+        rawIRScansPerSecond = (rawIRDetectionTime>0) ? 1.0E9*rawIRScans/rawIRDetectionTime : 0.0;
+        qDebug() << "Raw impulse response detection: " << rawIRScansPerSecond << " scans/s per core, "
+                 << ((rawIRScansPerSecond>0.0) ? 1.0E6/rawIRScansPerSecond : 0.0) << " us per scan";
+
+        rawIRScans = 0;
+        rawIRDetectionTime = 0;
+    }
+
+    for(int i=MAX_N; i<capacity; i++) coordinates[i*2] = coordinates[i*2+1] = 0.0;
+
+    data->setUwbPacketRadarId(header.radar_id);
+    data->setUwbPacketRadarTime(header.radar_time);
+    data->setUwbPacketPacketNumber(header.packet_count);
+    data->setUwbPacketTargetsCount(count);
+    data->setRecieverMethod(RAW_IR);
+    return data;
+}
+
+rawData * reciever::extract_replay_record()
+{
+    rawData * data = replaySourceHandler->next();
+
+    if(data==NULL)
+    {
+        replayFinished = true;
+
+        if(replayRecords>0 && replayTimer.isValid())
+        {
+            // unthrottled replay of the whole file is the measure of end-to-end throughput
+            qint64 elapsed = replayTimer.nsecsElapsed();
+            replayRecordsPerSecond = (elapsed>0) ? 1.0E9*replayRecords/elapsed : 0.0;
+            qDebug() << "Replay finished: " << replayRecords << " records in " << elapsed/1.0E6 << " ms, " << replayRecordsPerSecond << " records/s";
+            replayTimer.invalidate();
+        }
+
+        return NULL;
+    }
+
+    qint64 recorded = data->getArrivalTime();
+
+    if(replayRecords==0)
+    {
+        replayFirstTime = recorded;
+        replayStartTime = QDateTime::currentMSecsSinceEpoch();
+        replayTimer.start();
+    }
+
+    // recorded time elapsed since the first record
+    qint64 offset = recorded-replayFirstTime;
+
+    if(replaySpeed>0.0)
+    {
+        // recorded gap may be hours long, so thread sleeps in slices and checks if it was cancelled
+        qint64 due = (qint64)(offset/replaySpeed);
+        qint64 wait = due-replayTimer.elapsed();
+        while(wait>0)
+        {
+            if(replayCancelled.loadAcquire())
+            {
+                delete data;
+                replayFinished = true;
+                return NULL;
+            }
+
+            QThread::msleep((wait<REPLAY_WAIT_SLICE) ? wait : REPLAY_WAIT_SLICE);
+            wait = due-replayTimer.elapsed();
+        }
+    }
+
+    // radar units estimate measurement time from radar time and arrival time again, data without radar time use arrival time
+    data->setArrivalTime(replayStartTime+offset);
+    data->setMeasurementTime((double)(replayStartTime+offset));
+
+    replayRecords++;
+
+    if(replayRecords%REPLAY_REPORT_INTERVAL==0)
+    {
+        qint64 now = replayTimer.nsecsElapsed();
+        replayRecordsPerSecond = (now>replayReportTime) ? 1.0E9*REPLAY_REPORT_INTERVAL/(now-replayReportTime) : 0.0;
+        replayReportTime = now;
+        qDebug() << "Replay: " << replayRecords << " records, " << replayRecordsPerSecond << " records/s, virtual clock "
+                 << replayStartTime+offset-QDateTime::currentMSecsSinceEpoch() << " ms ahead of real clock";
+    }
+
+    return data;
+}
+
 char * reciever::strsep( char** stringp, const char* delim )
 {
 
@@ -31,10 +31,37 @@
 #include <ctime>
 #include <QDebug>
 
+#include <QString>
+#include <QMap>
+#include <QPair>
+#include <QMutex>
+#include <QTcpSocket>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QThread>
+#include <QAtomicInt>
+
 #include "stddefs.h"
 #include "rawdata.h"
 #include "rs232.h"
 #include "uwbpacketclass.h"
+#include "mtt_pure.h"
+#include "replaysource.h"
+
+#define RAW_IR_REPORT_INTERVAL  (1000)      ///< Number of raw scans after which detection throughput is reported
+#define RAW_IR_SOCKET_TIMEOUT   (500)       ///< Time in miliseconds reciever waits for raw frame from socket
+#define REPLAY_REPORT_INTERVAL  (10000)     ///< Number of replayed records after which replay throughput is reported
+#define REPLAY_WAIT_SLICE       (20)        ///< Longest uninterrupted sleep of paced replay in milliseconds, so long recorded gap does not block stopping
+#define REPLAY_STACK_LIMIT      (1000)      ///< Data input thread waits while stack holds more replayed data, so file is not read faster than it is processed
+
+/**
+ * @brief Header of one raw impulse response frame. It is followed by SCANLENGHT float samples of channel 1 and SCANLENGHT float samples of channel 2. Native byte order is used.
+ */
+struct raw_ir_frame_header {
+    int radar_id; ///< Identifier of radar which measured the impulse responses
+    int radar_time; ///< Radar time, for synchronization
+    int packet_count; ///< Frame number, used for detecting lost frames
+};
 
 class reciever
 {
@@ -48,9 +75,10 @@ public:
      * approaches are used when test environment pipe or shared memory are used, or the real
      * radar network is connected. Of course also different protocols may require different
      * maintainance algorithms. This parameter is saved internally and used for making those
-     * choices but can be changed at any time.
+     * choices but can be changed at any time. Target capacity specifies for how many targets are the
+     * coordinate arrays allocated (see MTT_ARRAY_FIT).
      */
-    reciever(reciever_method recieveMethod);
+    reciever(reciever_method recieveMethod, int target_capacity = MAX_N);
 
     /**
      * @brief                       Specially if serial link communication is selected, also basic COM port configurations must be passed. This is overloaded constructor.
@@ -58,8 +86,28 @@ public:
      * @param[in] comport_ID        New comport index for opening the comport
      * @param[in] baud_rate         New baudrate for serial link communication
      * @param[in] comport_mode      Mode for comport communication (parity, stop bits, one send word length)
+     * @param[in] target_capacity   Number of targets for which the coordinate arrays are allocated (see MTT_ARRAY_FIT)
+     */
+    reciever(reciever_method recieveMethod, char * comport_name, int baud_rate, char * comport_mode, int target_capacity = MAX_N);
+
+    /**
+     * @brief                       Overloaded constructor for RAW_IR method. Raw impulse responses are read from file or socket and detection runs in reciever.
+     * @param[in] recieveMethod     Is used to identify the method by which data should be get
+     * @param[in] source_type       Specifies if 'source' is file path or "host:port" of TCP server
+     * @param[in] source            File path or address of server sending raw frames (see 'raw_ir_frame_header')
+     * @param[in] detection_params  Parameters of detection chain used for all radars
+     * @param[in] target_capacity   Number of targets for which the coordinate arrays are allocated (see MTT_ARRAY_FIT)
+     */
+    reciever(reciever_method recieveMethod, raw_ir_source source_type, const QString & source, const ir_detection_parameters & detection_params, int target_capacity = MAX_N);
+
+    /**
+     * @brief                       Overloaded constructor for REPLAY method. Recorded file is fed as if data were recieved live.
+     * @param[in] recieveMethod     Is used to identify the method by which data should be get
+     * @param[in] replay_file       Measurement capture, binary backup or text backup (see 'replaySource')
+     * @param[in] replay_speed      Multiple of recorded speed (1.0 is real time), zero or less replays as fast as possible
+     * @param[in] target_capacity   Number of targets for which the coordinate arrays of backup frames are allocated (see MTT_ARRAY_FIT)
      */
-    reciever(reciever_method recieveMethod, char * comport_name, int baud_rate, char * comport_mode);
+    reciever(reciever_method recieveMethod, const QString & replay_file, double replay_speed, int target_capacity = MAX_N);
 
     ~reciever();
 
@@ -120,6 +168,41 @@ public:
      */
     const char * check_status_message(void) { return statusMsg; }
 
+    /**
+     * @brief Returns throughput of raw impulse response detection measured over the last RAW_IR_REPORT_INTERVAL scans.
+     * @return Number of scans detection chain is able to process per second on one core, 0 if not measured yet.
+     */
+    double raw_ir_scans_per_second(void) { return rawIRScansPerSecond; }
+
+    /**
+     * @brief Changes software averaging of raw impulse responses of one radar (see 'mtt_pure::setAveraging').
+     * @param[in] radar_id Identifier of radar. Radars without own setting use 'sa_count' and 'sa_hop' of detection parameters.
+     * @param[in] count Number of averaged scans.
+     * @param[in] hop Averaged scan is produced every 'hop' scans.
+     *
+     * May be called from any thread while reciever is running. Change is applied with the next frame of radar, no buffers are reallocated.
+     */
+    void set_raw_ir_averaging(int radar_id, int count, int hop);
+
+    /**
+     * @brief Returns replay throughput measured over the last REPLAY_REPORT_INTERVAL records (or the whole replay when the file was finished).
+     * @return Number of records fed per second of real time, 0 if not measured yet.
+     */
+    double replay_records_per_second(void) { return replayRecordsPerSecond; }
+
+    /**
+     * @brief Tells if 'listen' returned NULL because all records of replayed file were fed. This is not an error, nothing more will come.
+     * @return True if the end of replayed file was reached.
+     */
+    bool replay_finished(void) { return replayFinished; }
+
+    /**
+     * @brief Interrupts paced replay waiting for the next record, 'listen' then returns NULL and replay is finished.
+     *
+     * May be called from any thread, it is used when data input thread is stopped during long recorded gap.
+     */
+    void cancel_replay(void) { replayCancelled.storeRelease(1); }
+
 private:
     bool calibrationStatus; ///< The boolean result of wether the method was set up successfully.
 
@@ -129,6 +212,8 @@ private:
 
     reciever_method r_method; ///< The code of currently used method.
 
+    int targetCapacity; ///< Number of targets for which the coordinate arrays are allocated
+
     char * statusMsg; ///< The pointer to the last message produced by object
 
     /**
@@ -182,6 +267,88 @@ private:
      */
     rawData * extract_RS232_radar_packet(void);
 
+    //------------------------------------------ RAW IMPULSE RESPONSE METHOD ----------------------------------
+
+    raw_ir_source rawIRSourceType; ///< Specifies if raw frames are read from file or socket
+
+    QString rawIRSource; ///< File path or "host:port" of raw frames source
+
+    ir_detection_parameters rawIRParameters; ///< Parameters of detection chain
+
+    FILE * rawIRFile; ///< Opened file with raw frames if RAW_IR_FILE source is used
+
+    QTcpSocket * rawIRSocket; ///< Connection to raw frames server if RAW_IR_SOCKET source is used, created in the thread which calls 'listen'
+
+    float * rawIRScan; ///< Buffer for impulse responses of both channels of one frame
+
+    QMap<int, mtt_pure * > rawIRDetectors; ///< Detection state (background estimation, traces) of each radar, created on the first frame of radar
+
+    QMap<int, QPair<int, int> > rawIRAveraging; ///< Software averaging [count, hop] of radars with own setting
+
+    QMutex rawIRAveragingMutex; ///< Protects 'rawIRAveraging', it can be changed by other threads
+
+    int rawIRScans; ///< Number of scans processed since the last throughput report
+
+    qint64 rawIRDetectionTime; ///< Time in nanoseconds spent in detection since the last throughput report
+
+    double rawIRScansPerSecond; ///< Last measured detection throughput
+
+    /**
+     * @brief Reads one complete frame from file or socket.
+     * @param[out] header Header of frame.
+     * @return True if the whole frame was read into 'header' and 'rawIRScan'.
+     */
+    bool read_raw_ir_frame(raw_ir_frame_header * header);
+
+    /**
+     * @brief Reads required number of bytes from socket, waits at most RAW_IR_SOCKET_TIMEOUT for each part.
+     * @param[out] buffer Target buffer.
+     * @param[in] size Number of bytes to read.
+     * @return Number of bytes really read.
+     */
+    qint64 read_raw_ir_socket(char * buffer, qint64 size);
+
+    /**
+     * @brief Reads raw frame, runs detection chain of appropriate radar and converts result into rawData object.
+     * @return Pointer to the new rawData object with detected coordinates or NULL if no frame could be read.
+     */
+    rawData * extract_raw_ir_frame(void);
+
+    //------------------------------------------ REPLAY METHOD ------------------------------------------------
+
+    QString replayFile; ///< Path of replayed file
+
+    double replaySpeed; ///< Multiple of recorded speed, zero or less for replay as fast as possible
+
+    replaySource * replaySourceHandler; ///< Reader of replayed file
+
+    QElapsedTimer replayTimer; ///< Real time since the first replayed record
+
+    qint64 replayFirstTime; ///< Recorded arrival time of the first record
+
+    qint64 replayStartTime; ///< Virtual time of the first record, the real time when replay started
+
+    qint64 replayRecords; ///< Number of replayed records
+
+    qint64 replayReportTime; ///< Real time of the last throughput report in nanoseconds since the first record
+
+    double replayRecordsPerSecond; ///< Last measured replay throughput
+
+    bool replayFinished; ///< True when the end of replayed file was reached
+
+    QAtomicInt replayCancelled; ///< Set to 1 by 'cancel_replay' from another thread
+
+    /**
+     * @brief Reads the next recorded object, waits until it is due according to replay speed and moves its times to virtual clock.
+     * @return Pointer to the new rawData object or NULL if the end of file was reached or replay was cancelled.
+     *
+     * Virtual time of record is the real time of replay start plus recorded time elapsed since the first record. Virtual
+     * clock so runs 'replaySpeed' times faster than real clock and when replay is unthrottled, it jumps from record to record.
+     * Intervals between data are the recorded ones in all cases, so fusion deadlines, stale radars and tracking behave as if
+     * data were recieved live.
+     */
+    rawData * extract_replay_record(void);
+
     #if defined (__WIN32__)
     //------------------------------------------ PIPE METHOD --------------------------------------------------
 
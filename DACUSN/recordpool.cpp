@@ -0,0 +1,74 @@
+/**
+ * @file recordpool.cpp
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Definitions of recordPool class methods.
+ *
+ * @section DESCRIPTION
+ *
+ * Popping single nodes from lock-free stack is unsafe without tagged pointers (the head can be popped
+ * and pushed again between reading it and swapping it). Swapping the whole stack for NULL does not
+ * depend on the old head, so it is safe and the cache taken this way is private to allocating thread.
+ *
+ */
+
+#include "recordpool.h"
+
+recordPool::recordPool(size_t record_size)
+{
+    recordSize = (record_size>sizeof(record_node)) ? record_size : sizeof(record_node);
+    cache = NULL;
+}
+
+recordPool::~recordPool()
+{
+    freeList(cache);
+    freeList(released.fetchAndStoreAcquire(NULL));
+}
+
+void * recordPool::acquire()
+{
+    if(allocating.testAndSetAcquire(0, 1))
+    {
+        record_node * node = cache;
+        if(node==NULL) node = released.fetchAndStoreAcquire(NULL);
+
+        if(node!=NULL)
+        {
+            cache = node->next;
+            allocating.storeRelease(0);
+            return node;
+        }
+
+        allocating.storeRelease(0);
+    }
+
+    // pool is empty or another thread is allocating right now
+    created.fetchAndAddRelaxed(1);
+    return malloc(recordSize);
+}
+
+void recordPool::release(void *record)
+{
+    if(record==NULL) return;
+
+    record_node * node = (record_node *) record;
+    record_node * head;
+
+    do
+    {
+        head = released.loadAcquire();
+        node->next = head;
+    }
+    while(!released.testAndSetRelease(head, node));
+}
+
+void recordPool::freeList(record_node *list)
+{
+    while(list!=NULL)
+    {
+        record_node * next = list->next;
+        free(list);
+        list = next;
+    }
+}
@@ -0,0 +1,84 @@
+/**
+ * @file recordpool.h
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Lock-free pool of fixed size records.
+ *
+ * @section DESCRIPTION
+ *
+ * Measurement records are created by 'reciever' thread and destroyed by stack thread (or by radar units
+ * running in it). Allocating them from heap means that each packet calls malloc in one thread and free in
+ * another, which is slow and makes both threads contend for allocator locks. The 'recordPool' object keeps
+ * released records and hands them out again, so heap is touched only until the pool holds as many records
+ * as are in flight at once.
+ *
+ * Any thread can release records. They are pushed to lock-free stack, pushing alone is not affected by
+ * ABA problem. The allocating side never pops single records from this stack, it takes the whole stack at
+ * once into its private cache. Only one thread can use the cache at a time, if another thread allocates
+ * concurrently it gets new record from heap instead of waiting, so no thread ever blocks in the pool.
+ *
+ */
+
+#ifndef RECORDPOOL_H
+#define RECORDPOOL_H
+
+#include <stdlib.h>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+
+class recordPool
+{
+public:
+    /**
+     * @brief Creates empty pool. Records are allocated from heap when pool is empty.
+     * @param[in] record_size Size of one record in bytes.
+     */
+    recordPool(size_t record_size);
+
+    /**
+     * @brief Frees records stored in pool. Records still in use are not owned by pool and must not be released after this.
+     */
+    ~recordPool();
+
+    /**
+     * @brief Returns record from pool, or new record from heap if pool is empty. Content of record is undefined.
+     * @return Pointer to memory of record size.
+     */
+    void * acquire(void);
+
+    /**
+     * @brief Returns record to pool. Can be called from any thread.
+     * @param[in] record Record obtained by 'acquire'. NULL is ignored.
+     */
+    void release(void * record);
+
+    /**
+     * @brief Returns the number of records allocated from heap so far, i.e. maximal number of records in flight.
+     * @return Number of records.
+     */
+    int getCreatedCount(void) { return created.load(); }
+
+private:
+    /**
+     * @brief Released record is reused as list node.
+     */
+    struct record_node {
+        record_node * next; ///< Next released record
+    };
+
+    size_t recordSize; ///< Size of one record (at least the size of list node)
+
+    QAtomicPointer<record_node> released; ///< Stack of records released by any thread
+    record_node * cache; ///< Records taken over by allocating thread, accessed only by thread holding 'allocating' flag
+    QAtomicInt allocating; ///< 1 if some thread is using the cache
+
+    QAtomicInt created; ///< Number of records allocated from heap
+
+    /**
+     * @brief Frees all records in list.
+     * @param[in] list The first record of list.
+     */
+    void freeList(record_node * list);
+};
+
+#endif // RECORDPOOL_H
@@ -0,0 +1,238 @@
+/**
+ * @file replaysource.cpp
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Definitions of replaySource class methods.
+ *
+ * @section DESCRIPTION
+ *
+ * Measurement capture is mapped into memory the same way as backups are (see backupReader), so records
+ * are converted without any file reading calls. Text backups are read line by line.
+ *
+ */
+
+#include "replaysource.h"
+
+replaySource::replaySource(int target_capacity)
+{
+    targetCapacity = target_capacity;
+    format = REPLAY_CAPTURE;
+
+    file = NULL;
+    data = NULL;
+    dataSize = 0;
+    position = 0;
+
+    backup = NULL;
+    backupFrame = NULL;
+    framesCount = 0;
+}
+
+replaySource::~replaySource()
+{
+    close();
+}
+
+bool replaySource::open(QString file_path)
+{
+    close();
+
+    file = new QFile(file_path);
+    if(!file->open(QIODevice::ReadOnly) || file->size()<(qint64)(sizeof(quint32)))
+    {
+        qDebug() << "Replayed file " << file_path << " could not be opened or is empty.";
+        close();
+        return false;
+    }
+
+    quint32 magic;
+    file->read((char *)(&magic), sizeof(quint32));
+    file->seek(0);
+
+    if(magic==CAPTURE_FILE_MAGIC)
+    {
+        format = REPLAY_CAPTURE;
+
+        dataSize = file->size();
+        data = file->map(0, dataSize);
+        if(data==NULL || dataSize<(qint64)(sizeof(capture_file_header)) || ((const capture_file_header *)(data))->version!=CAPTURE_FILE_VERSION)
+        {
+            qDebug() << "File " << file_path << " is not measurement capture of known version.";
+            close();
+            return false;
+        }
+
+        position = sizeof(capture_file_header);
+    }
+    else if(magic==BACKUP_FILE_MAGIC)
+    {
+        format = REPLAY_BACKUP;
+
+        // backup reader maps the file by itself
+        file->close();
+        delete file;
+        file = NULL;
+
+        backup = new backupReader;
+        if(!backup->open(file_path))
+        {
+            close();
+            return false;
+        }
+    }
+    else
+    {
+        format = REPLAY_TEXT_BACKUP;
+
+        file->close();
+        if(!file->open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void replaySource::close()
+{
+    if(file!=NULL)
+    {
+        if(data!=NULL) file->unmap((uchar *)(data));
+        file->close();
+        delete file;
+    }
+
+    if(backup!=NULL) delete backup;
+
+    file = NULL;
+    data = NULL;
+    dataSize = 0;
+    position = 0;
+    backup = NULL;
+    backupFrame = NULL;
+    framesCount = 0;
+}
+
+rawData * replaySource::next()
+{
+    if(format==REPLAY_CAPTURE) return (data!=NULL) ? nextCaptureRecord() : NULL;
+    else if(format==REPLAY_BACKUP) return (backup!=NULL) ? nextBackupFrame() : NULL;
+    else return (file!=NULL) ? nextTextFrame() : NULL;
+}
+
+rawData * replaySource::nextCaptureRecord()
+{
+    if(position+(qint64)(sizeof(capture_record_header))>dataSize) return NULL;
+
+    const capture_record_header * record = (const capture_record_header *)(data+position);
+    if(record->sync!=CAPTURE_RECORD_SYNC || record->capacity<0 || record->count<0 || record->count>record->capacity
+            || position+(qint64)(CAPTURE_RECORD_SIZE(record->capacity))>dataSize)
+    {
+        // capture which was not closed properly may end with incomplete record
+        qDebug() << "Invalid measurement record at position " << position << ", replay is finished.";
+        return NULL;
+    }
+
+    position += CAPTURE_RECORD_SIZE(record->capacity);
+
+    const float * recorded = (const float *)(record+1);
+    rawData * result = new rawData;
+    float * coordinates;
+
+    if(record->method==SYNTHETIC)
+    {
+        coordinates = result->reserveSyntheticCoordinates(record->capacity);
+        result->setSyntheticRadarId(record->radar_id);
+        result->setSyntheticTime(record->radar_time);
+        result->setSyntheticTargetsCount(record->count);
+    }
+    else
+    {
+        coordinates = result->reserveUwbPacketCoordinates(record->capacity);
+        result->setUwbPacketRadarId(record->radar_id);
+        result->setUwbPacketRadarTime((int)(record->radar_time));
+        result->setUwbPacketPacketNumber(record->packet_count);
+        result->setUwbPacketTargetsCount(record->count);
+    }
+
+    if(record->capacity>0) memcpy(coordinates, recorded, record->capacity*2*sizeof(float));
+
+    result->setRecieverMethod((reciever_method)(record->method));
+    result->setArrivalTime(record->arrival_time);
+
+    return result;
+}
+
+rawData * replaySource::nextBackupFrame()
+{
+    backupFrame = (backupFrame==NULL) ? backup->first() : backup->next(backupFrame);
+    if(backupFrame==NULL) return NULL;
+
+    const backup_track_record * tracks = backupReader::getRecords(backupFrame);
+    float * coordinates;
+    rawData * result = createFrameData(backupFrame->timestamp, backupFrame->count, &coordinates);
+
+    for(int i=0; i<backupFrame->count; i++)
+    {
+        coordinates[i*2] = tracks[i].x;
+        coordinates[i*2+1] = tracks[i].y;
+    }
+
+    return result;
+}
+
+rawData * replaySource::nextTextFrame()
+{
+    QStringList values;
+
+    // empty lines are skipped, line must contain at least time and count
+    while(values.count()<2)
+    {
+        if(file->atEnd()) return NULL;
+        values = QString(file->readLine()).trimmed().split('%', QString::SkipEmptyParts);
+    }
+
+    bool timestampValid, countValid;
+    qint64 timestamp = values.at(0).toLongLong(&timestampValid);
+    int count = values.at(1).toInt(&countValid);
+
+    // count is checked against the number of values before it is multiplied, so it cannot overflow
+    if(!timestampValid || !countValid || count<0 || count>(values.count()-2)/3)
+    {
+        qDebug() << "Invalid line of text backup, replay is finished.";
+        return NULL;
+    }
+
+    float * coordinates;
+    rawData * result = createFrameData(timestamp, count, &coordinates);
+
+    // identifiers are not used, tracks get new ones from MTT
+    for(int i=0; i<count; i++)
+    {
+        coordinates[i*2] = values.at(2+i*3+1).toFloat();
+        coordinates[i*2+1] = values.at(2+i*3+2).toFloat();
+    }
+
+    return result;
+}
+
+rawData * replaySource::createFrameData(qint64 timestamp, int count, float **coordinates)
+{
+    int capacity = (count>targetCapacity) ? count : targetCapacity;
+
+    rawData * result = new rawData;
+    *coordinates = result->reserveUwbPacketCoordinates(capacity);
+    memset(*coordinates, 0, capacity*2*sizeof(float));
+
+    // fused frames do not carry radar time, arrival time is used as measurement time
+    result->setUwbPacketRadarId(REPLAY_BACKUP_RADAR_ID);
+    result->setUwbPacketRadarTime(-1);
+    result->setUwbPacketPacketNumber((int)(framesCount++));
+    result->setUwbPacketTargetsCount(count);
+    result->setRecieverMethod(RS232);
+    result->setArrivalTime(timestamp);
+
+    return result;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file replaysource.h
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Reader of recorded files for REPLAY reciever method.
+ *
+ * @section DESCRIPTION
+ *
+ * Recorded data are converted back into 'rawData' objects in the order they were recorded. Format of file
+ * is recognized from its first bytes:
+ *
+ * - measurement capture (see measurementcapture.h) - each record becomes exactly the same object as was recieved,
+ *   including reciever method, radar and packet information and all coordinates,
+ * - binary backup (see backupwriter.h), compressed or not, and legacy text backup 'time%count%id%x%y...%' - each
+ *   frame of fused positions becomes one packet of radar REPLAY_BACKUP_RADAR_ID, so fused output can be tracked
+ *   and rendered again.
+ *
+ * Arrival time of objects is the recorded one, reciever maps it to virtual clock of replay.
+ *
+ */
+
+#ifndef REPLAYSOURCE_H
+#define REPLAYSOURCE_H
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QDebug>
+
+#include "stddefs.h"
+#include "rawdata.h"
+#include "measurementcapture.h"
+#include "backupreader.h"
+
+#define REPLAY_BACKUP_RADAR_ID  (1)     ///< Radar identifier under which frames of backup files are replayed (0 is reserved for operator)
+
+/**
+ * @brief The replay_format enum identifies the kind of replayed file.
+ */
+enum replay_format
+{
+    REPLAY_CAPTURE = 0, ///< Binary log of recieved measurements
+    REPLAY_BACKUP = 1, ///< Binary backup of fused frames
+    REPLAY_TEXT_BACKUP = 2 ///< Legacy text backup of fused frames
+};
+
+class replaySource
+{
+public:
+    /**
+     * @brief Prepares reader. File is not opened until 'open' is called.
+     * @param[in] target_capacity Minimum number of [x, y] positions allocated for frames of backup files (see MTT_ARRAY_FIT).
+     */
+    replaySource(int target_capacity = MAX_N);
+    ~replaySource();
+
+    /**
+     * @brief Opens recorded file and recognizes its format. Previously opened file is closed.
+     * @param[in] file_path Path of measurement capture, binary backup or text backup.
+     * @return False if file could not be opened or is empty.
+     */
+    bool open(QString file_path);
+
+    /**
+     * @brief Closes the file.
+     */
+    void close(void);
+
+    /**
+     * @brief Returns the format of opened file.
+     * @return Format recognized by 'open'.
+     */
+    replay_format getFormat(void) { return format; }
+
+    /**
+     * @brief Converts the next record of file into new data object. Ownership goes to caller.
+     * @return New object with recorded arrival time or NULL if the end of file or invalid record was reached.
+     */
+    rawData * next(void);
+
+private:
+    int targetCapacity; ///< Minimum capacity of coordinates of backup frames
+    replay_format format; ///< Format of opened file
+
+    QFile * file; ///< Opened file, NULL if nothing is opened
+    const uchar * data; ///< Mapping of measurement capture
+    qint64 dataSize; ///< Size of mapping
+    qint64 position; ///< Position of the next record in mapping
+
+    backupReader * backup; ///< Reader of binary backup
+    const backup_frame_header * backupFrame; ///< The last replayed frame of binary backup, NULL before the first one
+
+    qint64 framesCount; ///< Number of frames of backup already replayed, used as packet number
+
+    /**
+     * @brief Converts the next record of measurement capture.
+     * @return New object or NULL.
+     */
+    rawData * nextCaptureRecord(void);
+
+    /**
+     * @brief Converts the next frame of binary backup.
+     * @return New object or NULL.
+     */
+    rawData * nextBackupFrame(void);
+
+    /**
+     * @brief Converts the next line of text backup.
+     * @return New object or NULL.
+     */
+    rawData * nextTextFrame(void);
+
+    /**
+     * @brief Creates packet of radar REPLAY_BACKUP_RADAR_ID for one fused frame, positions are zeroed.
+     * @param[in] timestamp Time of frame in milliseconds since epoch.
+     * @param[in] count Number of positions in frame.
+     * @param[out] coordinates Array the caller fills with 'count' [x, y] positions.
+     * @return New object.
+     */
+    rawData * createFrameData(qint64 timestamp, int count, float ** coordinates);
+};
+
+#endif // REPLAYSOURCE_H
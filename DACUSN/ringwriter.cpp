@@ -0,0 +1,172 @@
+/**
+ * @file ringwriter.cpp
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Definitions of ringWriter class methods.
+ *
+ * @section DESCRIPTION
+ *
+ * Counters wrap around at 2^32, ring size is power of two, so differences of counters are always valid.
+ * Only complete records are ever between 'tail' and 'head', so writer can walk record headers in the ring
+ * without any help from producer.
+ *
+ */
+
+#include "ringwriter.h"
+
+ringWriter::ringWriter(QString file_path, int queue_size)
+{
+    filePath = file_path;
+    file = NULL;
+    fileOffset = 0;
+
+    ringSize = 1024;
+    while(ringSize<(quint32)(queue_size) && ringSize<(1u<<30)) ringSize <<= 1;
+    ring = new char[ringSize];
+
+    head.storeRelease(0);
+    tail.storeRelease(0);
+    stopped.storeRelease(0);
+    dropped.storeRelease(0);
+}
+
+ringWriter::~ringWriter()
+{
+    if(file!=NULL)
+    {
+        file->close();
+        delete file;
+    }
+
+    delete [] ring;
+}
+
+bool ringWriter::open()
+{
+    file = new QFile(filePath);
+    if(!file->open(QIODevice::WriteOnly))
+    {
+        qDebug() << "File " << filePath << " could not be opened.";
+        delete file;
+        file = NULL;
+        return false;
+    }
+
+    fileOffset = 0;
+
+    return true;
+}
+
+void ringWriter::runWorker()
+{
+    QElapsedTimer flushTimer;
+    flushTimer.start();
+
+    forever {
+        bool stop = stopped.loadAcquire();
+
+        // everything accumulated since the last pass is written by one or two calls
+        if(writePending()==0) QThread::msleep(RING_WRITER_IDLE_TIME);
+
+        if(file!=NULL && flushTimer.elapsed()>=RING_WRITER_FLUSH_INTERVAL)
+        {
+            flushPending();
+            file->flush();
+            flushTimer.restart();
+        }
+
+        // flag is read before the last pass, so records pushed before stop are always written
+        if(stop) break;
+    }
+
+    if(file!=NULL) finish();
+
+    if(dropped.loadAcquire()>0) qDebug() << "Writer of " << filePath << " could not keep up, " << dropped.loadAcquire() << " records were dropped.";
+
+    emit finished();
+}
+
+bool ringWriter::reserve(quint32 size, quint32 *position)
+{
+    quint32 h = (quint32)(head.loadAcquire());
+    quint32 t = (quint32)(tail.loadAcquire());
+
+    if(size>ringSize-(h-t))
+    {
+        dropped.fetchAndAddRelaxed(1);
+        return false;
+    }
+
+    *position = h;
+    return true;
+}
+
+void ringWriter::put(quint32 position, const void *data, int size)
+{
+    quint32 offset = position & (ringSize-1);
+    quint32 first = ringSize-offset;
+
+    if((quint32)(size)<=first) memcpy(&ring[offset], data, size);
+    else
+    {
+        memcpy(&ring[offset], data, first);
+        memcpy(ring, (const char *)(data)+first, size-first);
+    }
+}
+
+void ringWriter::get(quint32 position, void *data, int size)
+{
+    quint32 offset = position & (ringSize-1);
+    quint32 first = ringSize-offset;
+
+    if((quint32)(size)<=first) memcpy(data, &ring[offset], size);
+    else
+    {
+        memcpy(data, &ring[offset], first);
+        memcpy((char *)(data)+first, ring, size-first);
+    }
+}
+
+void ringWriter::writeRing(quint32 begin, quint32 end)
+{
+    quint32 size = end-begin;
+
+    if(file!=NULL && size>0)
+    {
+        quint32 offset = begin & (ringSize-1);
+        quint32 first = ringSize-offset;
+
+        if(size<=first) file->write(&ring[offset], size);
+        else
+        {
+            file->write(&ring[offset], first);
+            file->write(ring, size-first);
+        }
+    }
+
+    fileOffset += size;
+}
+
+int ringWriter::writePending()
+{
+    quint32 h = pendingEnd();
+    quint32 t = pendingBegin();
+
+    if(h==t) return 0;
+
+    writeRing(t, h);
+
+    // space is returned to producer after data were copied into file buffers
+    releaseRing(h);
+
+    return h-t;
+}
+
+void ringWriter::finish()
+{
+    writePending();
+
+    file->close();
+    delete file;
+    file = NULL;
+}
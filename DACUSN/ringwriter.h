@@ -0,0 +1,168 @@
+/**
+ * @file ringwriter.h
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Base class of binary logs written to disk by dedicated thread.
+ *
+ * @section DESCRIPTION
+ *
+ * Producing thread (stack manager, data input thread) only serializes records into lock-free ring buffer
+ * and never waits for disk. Object of derived class running in its own thread takes everything accumulated
+ * in the ring and writes it into file at once, so many records are written by one call. If disk can not
+ * keep up and ring becomes full, new records are dropped and counted instead of blocking the producer.
+ *
+ * Producer and writer share only two byte counters. Producer reserves space, copies the whole record behind
+ * 'head' and then moves 'head' by release store, writer moves 'tail' after the bytes are handed to file.
+ * Only one thread at a time may produce records.
+ *
+ * Derived classes define record format, write file header in 'open' and may process records in 'writePending'
+ * before they are written (see backupWriter).
+ *
+ */
+
+#ifndef RINGWRITER_H
+#define RINGWRITER_H
+
+#include <string.h>
+#include <QObject>
+#include <QFile>
+#include <QString>
+#include <QThread>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QDebug>
+
+#define RING_WRITER_QUEUE_SIZE      (1<<20)     ///< Default size of ring buffer in bytes (must be power of two)
+#define RING_WRITER_IDLE_TIME       (20)        ///< Sleep time of writer in milliseconds when ring is empty
+#define RING_WRITER_FLUSH_INTERVAL  (1000)      ///< Maximum time in milliseconds data stay in file buffers before they are flushed to disk
+
+class ringWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Prepares writer. File is not opened until 'open' is called.
+     * @param[in] file_path Path of file, existing file is overwritten.
+     * @param[in] queue_size Size of ring buffer in bytes, rounded up to power of two.
+     */
+    ringWriter(QString file_path, int queue_size = RING_WRITER_QUEUE_SIZE);
+
+    /**
+     * @brief Deletes ring. Derived class must call 'finish' in its destructor if file is still open, so its pending data are processed.
+     */
+    virtual ~ringWriter();
+
+    /**
+     * @brief Creates file. Must be called before writer thread is started. Derived classes write file header here.
+     * @return False if file could not be opened.
+     */
+    virtual bool open(void);
+
+    /**
+     * @brief The main function of writer thread, running until 'stopWorker' is called. All records pushed before stop are written, then file is finished and closed.
+     */
+    Q_INVOKABLE void runWorker(void);
+
+    /**
+     * @brief Asks writer thread to write remaining records and finish. Can be called from any thread.
+     */
+    void stopWorker(void) { stopped.storeRelease(1); }
+
+    /**
+     * @brief Returns the number of records dropped because writer could not keep up.
+     * @return Number of dropped records.
+     */
+    int getDroppedFrames(void) { return dropped.loadAcquire(); }
+
+protected:
+    QFile * file; ///< Written file, NULL until 'open' is called and after file is closed
+    qint64 fileOffset; ///< Position in file where the next byte is written
+
+    /**
+     * @brief Reserves space for one record in ring. If ring is full, record is counted as dropped. Producer thread only.
+     * @param[in] size Size of record in bytes.
+     * @param[out] position Byte position where record starts.
+     * @return False if there is not enough space.
+     */
+    bool reserve(quint32 size, quint32 * position);
+
+    /**
+     * @brief Copies data into ring at given position, handles wrapping of ring. Producer thread only.
+     * @param[in] position Byte position (not masked).
+     * @param[in] data Data to copy.
+     * @param[in] size Number of bytes.
+     */
+    void put(quint32 position, const void * data, int size);
+
+    /**
+     * @brief Makes all bytes before given position visible to writer thread. Producer thread only.
+     * @param[in] position Byte position after the last complete record.
+     */
+    void commit(quint32 position) { head.storeRelease((int)(position)); }
+
+    /**
+     * @brief Copies data from ring at given position, handles wrapping of ring. Writer thread only.
+     * @param[in] position Byte position (not masked).
+     * @param[out] data Target buffer.
+     * @param[in] size Number of bytes.
+     */
+    void get(quint32 position, void * data, int size);
+
+    /**
+     * @brief Returns the position of the first byte not yet written. Writer thread only.
+     * @return Byte position.
+     */
+    quint32 pendingBegin(void) { return (quint32)(tail.loadAcquire()); }
+
+    /**
+     * @brief Returns the position after the last committed record. Writer thread only.
+     * @return Byte position.
+     */
+    quint32 pendingEnd(void) { return (quint32)(head.loadAcquire()); }
+
+    /**
+     * @brief Writes bytes of ring between two positions into file and moves 'fileOffset'. Writer thread only.
+     * @param[in] begin The first byte.
+     * @param[in] end Position after the last byte.
+     */
+    void writeRing(quint32 begin, quint32 end);
+
+    /**
+     * @brief Returns space before given position to producer. Writer thread only.
+     * @param[in] position Byte position, all bytes before it were processed.
+     */
+    void releaseRing(quint32 position) { tail.storeRelease((int)(position)); }
+
+    /**
+     * @brief Writes all records pushed so far into file. Writer thread only.
+     * @return Number of processed bytes of ring.
+     */
+    virtual int writePending(void);
+
+    /**
+     * @brief Called before file is flushed, derived class writes data it holds back (unfinished blocks).
+     */
+    virtual void flushPending(void) {}
+
+    /**
+     * @brief Writes remaining records and closes the file. Derived class appends its trailer here.
+     */
+    virtual void finish(void);
+
+private:
+    QString filePath; ///< Path of file
+
+    char * ring; ///< Ring buffer with serialized records
+    quint32 ringSize; ///< Size of ring in bytes, power of two
+    QAtomicInt head; ///< Number of bytes pushed since start (wraps around), written by producer only
+    QAtomicInt tail; ///< Number of bytes processed by writer since start (wraps around), written by writer thread only
+
+    QAtomicInt stopped; ///< Set to 1 when writer should finish
+    QAtomicInt dropped; ///< Number of dropped records
+
+signals:
+    void finished(void); ///< Emitted when writer thread leaves its cycle and file is closed
+};
+
+#endif // RINGWRITER_H
@@ -0,0 +1,273 @@
+/**
+ * @file spatialfusion.cpp
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Definitions of spatialFusion class methods.
+ *
+ * @section DESCRIPTION
+ *
+ * Positions are sorted into g0 x g1 grid by counting sort. The number of cells is limited by the number of
+ * positions (about one position per cell) and the size of cell is never smaller than merge radius, so positions
+ * closer than merge radius always lie in the same or in neighbouring cells. Each cell is compared with itself and
+ * with four of its neighbours only, the remaining four neighbours compare themselves with it. Connected positions
+ * are joined in union-find forest and each tree is one fused target.
+ *
+ */
+
+#include "spatialfusion.h"
+
+spatialFusion::spatialFusion(float merge_radius, int initial_capacity)
+{
+    radius = (merge_radius>0) ? merge_radius : (float) SPATIAL_FUSION_RADIUS;
+    estimator = FUSION_MEAN;
+    trimFraction = SPATIAL_FUSION_TRIM;
+
+    count = 0;
+    capacity = 0;
+
+    x = y = clusterX = clusterY = NULL;
+    radar = parent = cell = order = cluster = NULL;
+
+    cellStart = NULL;
+    cellCapacity = 0;
+
+    reserve((initial_capacity>0) ? initial_capacity : SPATIAL_FUSION_CAPACITY);
+}
+
+spatialFusion::~spatialFusion()
+{
+    delete [] x;
+    delete [] y;
+    delete [] radar;
+    delete [] parent;
+    delete [] cell;
+    delete [] order;
+    delete [] cluster;
+    delete [] clusterX;
+    delete [] clusterY;
+    delete [] cellStart;
+}
+
+void spatialFusion::addPosition(int radar_id, float pos_x, float pos_y)
+{
+    if(count>=capacity) reserve(2*capacity);
+
+    x[count] = pos_x;
+    y[count] = pos_y;
+    radar[count] = radar_id;
+    count++;
+}
+
+int spatialFusion::fuse(float *positions, int *sizes)
+{
+    int i, j, k, c, cx, cy, g0, g1, cells, root, found;
+    float min0, max0, min1, max1, size0, size1;
+
+    if(count==0) return 0;
+
+    min0 = max0 = x[0];
+    min1 = max1 = y[0];
+    for(i=1; i<count; i++)
+    {
+        if(x[i]<min0) min0 = x[i];
+        if(x[i]>max0) max0 = x[i];
+        if(y[i]<min1) min1 = y[i];
+        if(y[i]>max1) max1 = y[i];
+    }
+
+    // about one position per cell, but cells must not be smaller than merge radius
+    g0 = g1 = (int) ceil(sqrt((float) count));
+    if((max0-min0)/radius<g0) g0 = (int) ((max0-min0)/radius);
+    if((max1-min1)/radius<g1) g1 = (int) ((max1-min1)/radius);
+    if(g0<1) g0 = 1;
+    if(g1<1) g1 = 1;
+    size0 = (max0>min0) ? (max0-min0)/g0 : 1.0f;
+    size1 = (max1>min1) ? (max1-min1)/g1 : 1.0f;
+    cells = g0*g1;
+
+    if(cells+1>cellCapacity)
+    {
+        delete [] cellStart;
+        cellCapacity = cells+1;
+        cellStart = new int[cellCapacity];
+    }
+
+    // counting sort of positions by cell index, cellStart[cell] is the first position of cell in order
+    memset(cellStart, 0, (cells+1)*sizeof(int));
+    for(i=0; i<count; i++)
+    {
+        cell[i] = gridCell(y[i], min1, size1, g1)*g0 + gridCell(x[i], min0, size0, g0);
+        cellStart[cell[i]]++;
+        parent[i] = i;
+    }
+    for(c=1; c<cells; c++) cellStart[c] += cellStart[c-1];
+    cellStart[cells] = count;
+    for(i=count-1; i>=0; i--) order[--cellStart[cell[i]]] = i;
+
+    for(c=0; c<cells; c++)
+    {
+        cx = c % g0;
+        cy = c / g0;
+
+        for(k=cellStart[c]; k<cellStart[c+1]; k++)
+        {
+            i = order[k];
+
+            // the rest of the same cell
+            for(j=k+1; j<cellStart[c+1]; j++) connect(i, order[j]);
+
+            // right column (three cells) and the cell above
+            if(cx+1<g0)
+            {
+                for(int r=((cy>0) ? cy-1 : cy); r<=cy+1 && r<g1; r++)
+                    for(j=cellStart[r*g0+cx+1]; j<cellStart[r*g0+cx+2]; j++) connect(i, order[j]);
+            }
+            if(cy+1<g1)
+            {
+                for(j=cellStart[c+g0]; j<cellStart[c+g0+1]; j++) connect(i, order[j]);
+            }
+        }
+    }
+
+    // trees are numbered in order of their first position, grid is not needed anymore so 'cell' holds cluster of each position
+    found = 0;
+    for(i=0; i<count; i++) cluster[i] = -1;
+    for(i=0; i<count; i++)
+    {
+        root = find(i);
+        if(cluster[root]<0) cluster[root] = found++;
+        cell[i] = cluster[root];
+    }
+
+    // counting sort of coordinates by cluster, 'order' holds the first position of each cluster and 'parent' is used as cursor
+    for(c=0; c<=found; c++) order[c] = 0;
+    for(i=0; i<count; i++) order[cell[i]+1]++;
+    for(c=1; c<=found; c++) order[c] += order[c-1];
+    for(c=0; c<found; c++) parent[c] = order[c];
+    for(i=0; i<count; i++)
+    {
+        k = parent[cell[i]]++;
+        clusterX[k] = x[i];
+        clusterY[k] = y[i];
+    }
+
+    for(c=0; c<found; c++)
+    {
+        positions[c*2] = estimate(&clusterX[order[c]], order[c+1]-order[c]);
+        positions[c*2+1] = estimate(&clusterY[order[c]], order[c+1]-order[c]);
+        if(sizes!=NULL) sizes[c] = order[c+1]-order[c];
+    }
+
+    return found;
+}
+
+void spatialFusion::reserve(int required)
+{
+    if(required<=capacity) return;
+
+    float ** float_arrays[] = { &x, &y, &clusterX, &clusterY };
+    int ** int_arrays[] = { &radar, &parent, &cell, &order, &cluster };
+    unsigned int i;
+
+    for(i=0; i<sizeof(float_arrays)/sizeof(float_arrays[0]); i++)
+    {
+        float * array = new float[required];
+        if(*float_arrays[i]!=NULL)
+        {
+            memcpy(array, *float_arrays[i], count*sizeof(float));
+            delete [] *float_arrays[i];
+        }
+        *float_arrays[i] = array;
+    }
+
+    // one more item for the end of the last cluster in 'order'
+    for(i=0; i<sizeof(int_arrays)/sizeof(int_arrays[0]); i++)
+    {
+        int * array = new int[required+1];
+        if(*int_arrays[i]!=NULL)
+        {
+            memcpy(array, *int_arrays[i], count*sizeof(int));
+            delete [] *int_arrays[i];
+        }
+        *int_arrays[i] = array;
+    }
+
+    capacity = required;
+}
+
+int spatialFusion::find(int i)
+{
+    while(parent[i]!=i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+
+    return i;
+}
+
+void spatialFusion::connect(int i, int j)
+{
+    if(radar[i]==radar[j]) return;
+
+    float dx = x[i]-x[j];
+    float dy = y[i]-y[j];
+    if(dx*dx+dy*dy>radius*radius) return;
+
+    i = find(i);
+    j = find(j);
+    // the smaller index is root, so clusters keep order of their first position
+    if(i<j) parent[j] = i;
+    else if(j<i) parent[i] = j;
+}
+
+void spatialFusion::setEstimator(fusion_estimator mode, float trim)
+{
+    estimator = mode;
+    trimFraction = (trim<0) ? 0 : ((trim>0.5f) ? 0.5f : trim);
+}
+
+float spatialFusion::estimate(float *values, int n)
+{
+    int i, k;
+    float sum;
+
+    if(n==1) return values[0];
+
+    if(estimator==FUSION_TRIMMED_MEAN)
+    {
+        k = (int) (trimFraction*n);
+        if(n-2*k>=1)
+        {
+            // two selections put the lowest k values before and the highest k values after the middle part
+            std::nth_element(values, values+k, values+n);
+            std::nth_element(values+k, values+n-k-1, values+n);
+
+            sum = 0;
+            for(i=k; i<n-k; i++) sum += values[i];
+            return sum/(float) (n-2*k);
+        }
+    }
+
+    if(estimator==FUSION_MEDIAN || estimator==FUSION_TRIMMED_MEAN)
+    {
+        std::nth_element(values, values+n/2, values+n);
+        if(n%2) return values[n/2];
+
+        // lower middle value is the greatest one before upper middle value
+        return (*std::max_element(values, values+n/2)+values[n/2])/2.0f;
+    }
+
+    sum = 0;
+    for(i=0; i<n; i++) sum += values[i];
+    return sum/(float) n;
+}
+
+int spatialFusion::gridCell(float value, float min, float size, int g)
+{
+    float c = (value-min)/size;
+
+    if(c<=0) return 0;
+    if(c>=g) return g-1;
+    return (int) c;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file spatialfusion.h
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Fusion of target positions from many radars by spatial clustering.
+ *
+ * @section DESCRIPTION
+ *
+ * Radar units number their targets independently, so the target with index j in one radar is not necessarily
+ * the target j of another radar. The 'spatialFusion' object therefore does not pair positions by index. All
+ * positions (already transformed into operator coordinate system) are collected, positions closer than merge
+ * radius are connected into clusters and one fused position (centroid) is produced for each cluster. Pairs of
+ * close positions are searched in uniform grid with cells not smaller than merge radius, so only positions from
+ * neighbouring cells are compared and the cost grows approximately linearly with the number of positions.
+ * Two positions of the same radar are never connected directly, because the radar has already resolved them
+ * as different targets. The fused position is either the centroid of cluster or robust estimate (median or
+ * trimmed mean of each coordinate) which is not affected by a single radar with wrong calibration or multipath.
+ *
+ */
+
+#ifndef SPATIALFUSION_H
+#define SPATIALFUSION_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include "stddefs.h"
+
+#define SPATIAL_FUSION_RADIUS       (0.3)       ///< Default merge radius in meters
+#define SPATIAL_FUSION_CAPACITY     (64)        ///< Initial number of positions, storage grows automatically
+#define SPATIAL_FUSION_TRIM         (0.25)      ///< Default fraction of positions dropped on each side by trimmed mean
+
+class spatialFusion
+{
+public:
+    /**
+     * @brief Creates empty fusion object.
+     * @param[in] merge_radius Positions closer than this distance (in meters) belong to the same target.
+     * @param[in] initial_capacity Number of positions storage is prepared for. More positions can be added, storage grows if needed.
+     */
+    spatialFusion(float merge_radius = SPATIAL_FUSION_RADIUS, int initial_capacity = SPATIAL_FUSION_CAPACITY);
+    ~spatialFusion();
+
+    /**
+     * @brief Changes merge radius. Non-positive values are ignored.
+     * @param[in] merge_radius New merge radius in meters.
+     */
+    void setMergeRadius(float merge_radius) { if(merge_radius>0) radius = merge_radius; }
+
+    /**
+     * @brief Returns current merge radius.
+     * @return Merge radius in meters.
+     */
+    float getMergeRadius(void) { return radius; }
+
+    /**
+     * @brief Selects how positions of one cluster are combined.
+     * @param[in] mode Estimator of fused position.
+     * @param[in] trim Fraction of positions dropped on each side by FUSION_TRIMMED_MEAN (0 up to 0.5). If nothing remains, median is used.
+     */
+    void setEstimator(fusion_estimator mode, float trim = SPATIAL_FUSION_TRIM);
+
+    /**
+     * @brief Returns estimator of fused position.
+     * @return Estimator mode.
+     */
+    fusion_estimator getEstimator(void) { return estimator; }
+
+    /**
+     * @brief Removes all positions. Memory is kept for the next frame.
+     */
+    void clear(void) { count = 0; }
+
+    /**
+     * @brief Returns the number of positions currently waiting for fusion.
+     * @return Number of positions.
+     */
+    int getCount(void) { return count; }
+
+    /**
+     * @brief Appends position of one target seen by one radar.
+     * @param[in] radar_id Identificator of radar which detected the target.
+     * @param[in] x X coordinate in operator coordinate system.
+     * @param[in] y Y coordinate in operator coordinate system.
+     */
+    void addPosition(int radar_id, float x, float y);
+
+    /**
+     * @brief Clusters all positions and computes one fused position for each cluster. Positions are not cleared.
+     * @param[out] positions Array of [x, y] fused positions. Must be able to hold 'getCount()*2' values.
+     * @param[out] sizes Number of positions merged into each fused position, may be NULL. Must be able to hold 'getCount()' values.
+     * @return Number of fused positions. Fused positions are ordered by the first added position of their cluster.
+     */
+    int fuse(float * positions, int * sizes);
+
+private:
+    float radius; ///< Merge radius
+    fusion_estimator estimator; ///< Estimator of fused position
+    float trimFraction; ///< Fraction of positions dropped on each side by trimmed mean
+
+    int count; ///< Number of positions
+    int capacity; ///< Number of positions storage can hold
+
+    float * x; ///< X coordinates of positions
+    float * y; ///< Y coordinates of positions
+    int * radar; ///< Radar identificators of positions
+
+    /* work space of 'fuse' */
+    int * parent; ///< Union-find forest, each cluster is one tree
+    int * cell; ///< Grid cell of each position
+    int * order; ///< Positions sorted by grid cell
+    int * cellStart; ///< Index of the first position of each cell in 'order' (cellStart[cells] = count)
+    int cellCapacity; ///< Length of 'cellStart' array
+    int * cluster; ///< Index of output cluster of each tree root, -1 if not assigned yet
+    float * clusterX; ///< X coordinates sorted by cluster
+    float * clusterY; ///< Y coordinates sorted by cluster
+
+    /**
+     * @brief Reallocates storage so it can hold at least 'required' positions. Stored positions are kept.
+     * @param[in] required Required number of positions.
+     */
+    void reserve(int required);
+
+    /**
+     * @brief Finds root of tree containing position. Path is halved on the way so trees stay flat.
+     * @param[in] i Index of position.
+     * @return Index of root position.
+     */
+    int find(int i);
+
+    /**
+     * @brief Connects clusters of two positions if they are closer than merge radius and come from different radars.
+     * @param[in] i Index of the first position.
+     * @param[in] j Index of the second position.
+     */
+    void connect(int i, int j);
+
+    /**
+     * @brief Combines coordinates of one cluster by selected estimator. Values are reordered.
+     * @param[in,out] values Coordinates of cluster.
+     * @param[in] n Number of coordinates.
+     * @return Fused coordinate.
+     */
+    float estimate(float * values, int n);
+
+    /**
+     * @brief Returns index of grid column (row) containing value, clamped to grid.
+     * @param[in] value Coordinate.
+     * @param[in] min Minimal coordinate of all positions.
+     * @param[in] size Size of cell.
+     * @param[in] g Number of columns (rows).
+     * @return Index of column (row).
+     */
+    int gridCell(float value, float min, float size, int g);
+};
+
+#endif // SPATIALFUSION_H
@@ -22,18 +22,18 @@
 #include "stackmanager.h"
 
 stackManager::stackManager(QVector<rawData *> *raw_data_stack, QMutex *raw_data_stack_mutex, QVector<radar_handler * > * radar_list, QMutex * radar_list_mutex,
-                           QList<QPointF * > * visualization_data, QList<QColor * > * visualization_color, QList<radarSubWindow * >  * radar_Sub_Window_List, QMutex * radar_Sub_Window_List_Mutex, QMutex * visualization_data_mutex,
-                           uwbSettings *setts, QMutex *settings_mutex)
+                           frameBuffer * visualization_data, QList<QColor * > * visualization_color, QMutex * visualization_data_mutex,
+                           uwbSettings *setts, QMutex *settings_mutex, QMap<unsigned int, mttSnapshot * > * mtt_snapshots, QMutex * mtt_snapshots_mutex)
 {
     rawDataStack = raw_data_stack;
     rawDataStackMutex = raw_data_stack_mutex;
     settings = setts;
     settingsMutex = settings_mutex;
     visualizationData = visualization_data;
-    radarSubWindowList = radar_Sub_Window_List;
-    radarSubWindowListMutex = radar_Sub_Window_List_Mutex;
     visualizationColor = visualization_color;
     visualizationDataMutex = visualization_data_mutex;
+    mttSnapshots = mtt_snapshots;
+    mttSnapshotsMutex = mtt_snapshots_mutex;
 
     idleTime = 200;
     stackControlPeriodicity = 50;
@@ -60,8 +60,32 @@ stackManager::stackManager(QVector<rawData *> *raw_data_stack, QMutex *raw_data_
     active_radar_ID = 0;
     active_radar_ID_index = -1;
 
-    // create mtt object for global MTT application
-    mtt_p_g = new mtt_pure();
+    settingsMutex->lock();
+    targetCapacity = settings->getTargetCapacity();
+    mttWarmStart = settings->getMTTWarmStart();
+    globalMTTModel = settings->getGlobalRadarMTTModel();
+    settingsMutex->unlock();
+
+    // mtt object for global MTT application is created only when global MTT is really used
+    mtt_p_g = NULL;
+
+    // frames are assembled by deadline and quorum, values are refreshed from settings with each new data
+    fusionTime = 0;
+    frameStart = -1;
+    fusionDeadline = 100;
+    fusionQuorum = 0;
+    fusionStaleTime = 1000;
+
+    // spatial fusion is created on the first fused frame
+    fusion = NULL;
+
+    // array passed to global MTT grows only when tracker capacity grows
+    globalMTTArray = NULL;
+    globalMTTArrayCapacity = 0;
+
+    // fusion output grows only when more positions than ever before are fused
+    fusedPositions = NULL;
+    fusedPositionsCapacity = 0;
 }
 
 stackManager::~stackManager()
@@ -71,6 +95,11 @@ stackManager::~stackManager()
 
     delete stoppedMutex;
     delete stoppedCheckMutex;
+
+    if(mtt_p_g!=NULL) delete mtt_p_g;
+    if(fusion!=NULL) delete fusion;
+    delete [] globalMTTArray;
+    delete [] fusedPositions;
 }
 
 void stackManager::runWorker()
@@ -79,6 +108,9 @@ void stackManager::runWorker()
 
     unsigned int stackControlCounter = 0;
 
+    // continue tracking from the state before the last stop
+    if(mttWarmStart) restoreMTTStates();
+
     forever {
         rawDataStackMutex->lock();
 
@@ -133,6 +165,9 @@ void stackManager::runWorker()
 
     qDebug() << "Leaving stack manager worker cycle.";
 
+    // all remaining data are processed, MTT states are final now
+    if(mttWarmStart) saveMTTStates();
+
     // inform higher classes that the loop is finished
     stoppedCheckMutex->lock();
     stoppedCheck = true;
@@ -311,7 +346,7 @@ void stackManager::dataProcessing(rawData *data)
     reciever_method method = data->getRecieverMethod();
     int radar_id = 0; // NEVER USE ID 0 SINCE IT IS RESERVED FOR OPERATOR
     // obtain radar id
-    if(method==RS232) radar_id = data->getUwbPacketRadarId();
+    if(method==RS232 || method==RAW_IR) radar_id = data->getUwbPacketRadarId();
     #if defined (__WIN32__)
     else if(method==SYNTHETIC) radar_id = data->getSyntheticRadarId();
     #endif
@@ -345,29 +380,56 @@ void stackManager::dataProcessing(rawData *data)
         radar_handler * rd = new radar_handler;
         rd->id = radar_id;
         rd->updated = false;
+        rd->lastUpdate = -1;
+        rd->stale = true;
         rd->radar = new radarUnit(radar_id);
         radarList->append(rd);
         i = radarList->count()-1;
+
+        // the unit may have been tracked before, e.g. if states were loaded from disk
+        if(mttWarmStart) restoreMTTStateOf(rd);
     }
 
+    // fusion follows time of data, not time of processing (see 'fusionTime')
+    if(data->getArrivalTime()>fusionTime) fusionTime = data->getArrivalTime();
+
     // in 'i' the correct index should be stored now, we can run
     bool localMTTEnabled = false;
+    mtt_state_model localMTTModel;
+    int historyDepth;
     settingsMutex->lock();
     localMTTEnabled = settings->getSingleRadarMTT();
+    localMTTModel = settings->getSingleRadarMTTModel();
+    targetCapacity = settings->getTargetCapacity();
+    fusionDeadline = settings->getFusionDeadline();
+    fusionQuorum = settings->getFusionQuorum();
+    fusionStaleTime = settings->getFusionStaleTime();
+    historyDepth = settings->getRadarHistoryDepth();
     settingsMutex->unlock();
-    if(radarList->at(i)->radar->processNewData(data, localMTTEnabled)) radarList->at(i)->updated = true;
+
+    // radar unit recreates its MTT only if capacity or model was changed, history is reallocated only if depth was changed
+    radarList->at(i)->radar->setMTTStateModel(localMTTModel);
+    radarList->at(i)->radar->setTargetCapacity(targetCapacity);
+    radarList->at(i)->radar->setHistoryDepth(historyDepth);
+    if(radarList->at(i)->radar->processNewData(data, localMTTEnabled))
+    {
+        // newer data of the same radar in one frame simply replace older ones
+        radarList->at(i)->updated = true;
+        radarList->at(i)->lastUpdate = fusionTime;
+        if(frameStart<0) frameStart = radarList->at(i)->lastUpdate;
+    }
     else radarList->at(i)->updated = false;
 
     // Here another data processing should take place if needed
     // It is supposed that some data fusion from all radarUnits will be placed here
 
-    // Update subWindow vectors if user wants to see specific radar view
-    updateRadarSubWindowList();
+    // radar subwindows take the newest frame from radar unit snapshot slot at their rendering rate
 
     if(checkRadarDataUpdateStatus())
     {
-        // if all radars are updated its time for fusion and visualization list update
+        // if all active radars are updated (or quorum/deadline is met) its time for fusion and visualization list update
         applyFusion();
+        frameStart = -1;
     }
 
     // update time information
@@ -377,27 +439,121 @@ void stackManager::dataProcessing(rawData *data)
     radarListMutex->unlock();
 }
 
+void stackManager::restoreMTTStates()
+{
+    radarListMutex->lock();
+    for(int i=0; i<radarList->count(); i++) restoreMTTStateOf(radarList->at(i));
+    radarListMutex->unlock();
+
+    // global MTT state is stored under operator id
+    mttSnapshotsMutex->lock();
+    mttSnapshot * snapshot = mttSnapshots->value(0, NULL);
+    if(snapshot!=NULL)
+    {
+        prepareGlobalMTT(0);
+        mtt_p_g->restoreState(snapshot);
+    }
+    mttSnapshotsMutex->unlock();
+}
+
+void stackManager::restoreMTTStateOf(radar_handler *handler)
+{
+    if(handler==NULL) return;
+
+    mttSnapshotsMutex->lock();
+    mttSnapshot * snapshot = mttSnapshots->value(handler->id, NULL);
+    // radar unit makes its own copy
+    if(snapshot!=NULL) handler->radar->restoreMTTState(snapshot);
+    mttSnapshotsMutex->unlock();
+}
+
+void stackManager::saveMTTStates()
+{
+    radarListMutex->lock();
+    mttSnapshotsMutex->lock();
+
+    for(int i=0; i<radarList->count(); i++)
+    {
+        mttSnapshot * snapshot = radarList->at(i)->radar->saveMTTState();
+        if(snapshot==NULL) continue; // MTT was not used on this unit
+
+        if(mttSnapshots->contains(radarList->at(i)->id)) delete mttSnapshots->value(radarList->at(i)->id);
+        mttSnapshots->insert(radarList->at(i)->id, snapshot);
+    }
+
+    if(mtt_p_g!=NULL)
+    {
+        if(mttSnapshots->contains(0)) delete mttSnapshots->value(0);
+        mttSnapshots->insert(0, mtt_p_g->saveState());
+    }
+
+    mttSnapshotsMutex->unlock();
+    radarListMutex->unlock();
+}
+
 bool stackManager::checkRadarDataUpdateStatus()
 {
    // no need to lock mutex because this function is already called when the mutex is locked
    int i;
+   int active = 0; // enabled radars which are not stale
+   int updated = 0; // active radars with new data
+   qint64 now = fusionTime;
+
+   for(i=0; i<radarList->count(); i++)
+   {
+       radar_handler * handler = radarList->at(i);
+
+       bool stale = (handler->lastUpdate<0 || now-handler->lastUpdate>(qint64)(fusionStaleTime));
+       if(stale!=handler->stale)
+       {
+           handler->stale = stale;
+           qDebug() << "Radar " << handler->id << (stale ? " is stale, fusion does not wait for it." : " is active.");
+       }
+
+       if(stale || !handler->radar->isEnabled()) continue;
+
+       active++;
+       if(handler->updated) updated++;
+   }
+
+   if(updated==0) return false;
+
+   // all active radars or quorum are updated
+   if(updated>=active || (fusionQuorum>0 && updated>=(int)(fusionQuorum))) return true;
+
+   // slower radars are not waited for longer than deadline, their last positions are used
+   return (frameStart>=0 && now-frameStart>=(qint64)(fusionDeadline));
+}
+
+void stackManager::prepareGlobalMTT(int observations)
+{
+    int required = (observations>targetCapacity) ? observations : targetCapacity;
+    if(required>MAX_TARGET_CAPACITY) required = MAX_TARGET_CAPACITY;
 
-   for(i=0; i<radarList->count(); i++) if(!radarList->at(i)->updated) return false;
+    if(mtt_p_g==NULL) mtt_p_g = new mtt_pure(required, globalMTTModel);
+    else if(mtt_p_g->getCapacity()<required)
+    {
+        // more targets than tracker can handle, tracker is recreated with greater capacity and continues with existing tracks
+        mttSnapshot * snapshot = mtt_p_g->saveState();
+        delete mtt_p_g;
+        mtt_p_g = new mtt_pure(required, globalMTTModel);
+        mtt_p_g->restoreState(snapshot);
+        delete snapshot;
+    }
 
-   // now all radars are updated
-   return true;
+    if(globalMTTArrayCapacity<mtt_p_g->getCapacity())
+    {
+        delete [] globalMTTArray;
+        globalMTTArrayCapacity = mtt_p_g->getCapacity();
+        globalMTTArray = new float[globalMTTArrayCapacity*2];
+    }
 }
 
 void stackManager::applyFusion()
 {
-    // apply the fusion algorithm (so far simple averaging the values or global MTT)
+    // apply the fusion algorithm (spatial clustering of positions from all radars or global MTT)
     int i, j;
 
-    // specifies the maximum target count from all radar units
-    int maximum_targets_visible = 0;
-    // if global MTT is used, we need to calculate array global array size (all coordinates in one array)
-    int global_mtt_array_size = 0;
-
     // temporary pointer handlers
     QVector<float * > arrays;
     QVector<int> targets_count;
@@ -407,437 +563,188 @@ void stackManager::applyFusion()
     enableGlobalMTT = settings->getGlobalRadarMTT();
     settingsMutex->unlock();
 
-    // for simplicity we suppose that all targets have same indexing in all radarUnits and coordinates are non-zero
+    // radar units index their targets independently, so positions are paired only by their distance in operator coordinate system
     for(i=0; i<radarList->count(); i++)
     {
         arrays.append(radarList->at(i)->radar->getCoordinatesLast());
         targets_count.append(radarList->at(i)->radar->getNumberOfTargetsLast());
 
-        // if global MTT is enabled and radar unit is enabled as well, we can add to array size the number of coordinates.
-        // In result, global_mtt_array_size will contain the size of array only for coordinates of active radar units.
-        if(enableGlobalMTT && radarList->at(i)->radar->isEnabled()) global_mtt_array_size+=(radarList->at(i)->radar->getNumberOfTargetsLast()*2);
-
-        // update maximum targets visible, this is usable only if averaging is selected instead of global MTT. If global MTT is set, no need of storing this information.
-        if(targets_count.last()>maximum_targets_visible && !enableGlobalMTT) maximum_targets_visible = targets_count.last();
-
-        // restore updated status back to false so fusion can run again only after all radars has updated data
+        // restore updated status back to false, the next frame starts with the next new data
         radarList->at(i)->updated = false;
     }
 
-    clearVisualizationData();
+    // new frame is filled in place, rendering sees it only after it is published
+    visualization_frame * frame = visualizationData->beginFrame();
 
     // if specific radar is used to be displayed in main/central view, we will push only its values into visualizationData
 
     if(active_radar_ID_index>=0 && active_radar_ID>0)
     {
         float * radar_coords = radarList->at(active_radar_ID_index)->radar->getCoordinatesLast();
+        int * radar_ids = radarList->at(active_radar_ID_index)->radar->getIdsLast();
         int targets = radarList->at(active_radar_ID_index)->radar->getNumberOfTargetsLast();
-        visualizationDataMutex->lock();
-        for(int i=0; i<targets; i++)
-        {
-            QPointF * temp_point = new QPointF(radar_coords[i*2], radar_coords[i*2+1]);
-
-            visualizationData->append(temp_point);
-        }
-        visualizationDataMutex->unlock();
+        for(int i=0; i<targets; i++) visualizationData->append(radar_coords[i*2], radar_coords[i*2+1], radar_ids[i]);
     }
 
-    float x_average; // the averaged value from all radars
-    float y_average; // the averaged value from all radars
-    int counter; // used for averaging;
-    if(!arrays.isEmpty() && !targets_count.isEmpty())
+    // positions from all radars are clustered and one fused position is produced for each cluster,
+    // global MTT then tracks fused positions, because it expects at most one observation of each target
+    float * fused_positions = NULL;
+    int fused_count = 0;
+    if(!arrays.isEmpty())
     {
+        if(fusion==NULL) fusion = new spatialFusion;
 
-        // if data backup is enabled we need to start new record
+        bool timeAlignment = false;
         settingsMutex->lock();
-            if(settings->getDiskBackupEnabled())
-            {
-                makeDataBackup(QDateTime::currentMSecsSinceEpoch(), true, true);
-                makeDataBackup((float)(maximum_targets_visible));
-            }
+        fusion->setMergeRadius(settings->getFusionMergeRadius());
+        fusion->setEstimator(settings->getFusionEstimator(), settings->getFusionTrimFraction());
+        timeAlignment = settings->getFusionTimeAlignment();
         settingsMutex->unlock();
 
-
-        if(enableGlobalMTT)
+        // tracked positions of all radars are predicted to the newest measurement, so order of packet arrival does not matter
+        double epoch = -1;
+        if(timeAlignment)
         {
-            // If global MTT is enabled, create one array of all coordinates from all radars and pass newly created array to MTT
-            #if defined MTT_ARRAY_FIT && MTT_ARRAY_FIT==1
-                float * global_mtt_array = new float[MAX_N*2];
-                for(int i=0; i<(MAX_N*2); i++) global_mtt_array[i] = 0.0; // zero all positions since not all can be used for data
-            #else
-                float * global_mtt_array = new float[global_mtt_array_size];
-            #endif
-            int global_mtt_array_pointer = 0; // still points to new empty array space
-
-            //qDebug() << "STARTING FILLING ARRAY " << global_mtt_array_size;
-
-            // fill array with coordinates
-            //qDebug() << "Total radars : " << arrays.count();
-
-            // create MTT constants
-            float r[] = {0.1, 0.01};
-            float q[] = {0.0, 0.01, 0.0, 0.0001};
-            float diff_d = 1.0;
-            float diff_fi = 0.6;
-            int min_NT = 10;
-            int min_OLGI = 10;
-
-            for(j=0; j<arrays.count(); j++)
+            for(i=0; i<arrays.count(); i++)
             {
-                //global_mtt_array_pointer = 0;
-
-                if(!radarList->at(j)->radar->isEnabled()) continue; // do not copy coordinates from radar unit that is not allowed by user
-
-                //qDebug() << "Running new filling of radar id : " << j << " while targets count is " << targets_count.at(j);
-
-                for(i=0; i<targets_count.at(j); i++)
-                {
-                    //qDebug() << "FILLING RADAR " << j << " ITERATION " << i;
-                    // apply transformation to operator coordinate system
-
-                    radarList->at(j)->radar->doTransformation(arrays.at(j)[i*2], arrays.at(j)[i*2+1]);
-
-                    // Usually if MTT produces invalid value, the "nan" or "inf/-inf" states were catched. Therefore it is much better to not consider such values
-                    float x = radarList->at(j)->radar->getTransformatedX();
-                    float y = radarList->at(j)->radar->getTransformatedY();
-
-                    qDebug() << "X: " << x << " Y: " << y;
-
-                    global_mtt_array[global_mtt_array_pointer++] = x;
-                    global_mtt_array[global_mtt_array_pointer++] = y;
-                }
-
-                /*qDebug() << "Running into zeroing cycle ( " << global_mtt_array_pointer << " )";
-
-                while(global_mtt_array_pointer<MAX_N*2)
-                    global_mtt_array[global_mtt_array_pointer++] = 0.0;
-
-                // kontrola pred pouzitim MTT
-                for(i=0; i<10; i++) qDebug() << "X: " << global_mtt_array[i*2] << " Y: " << global_mtt_array[i*2+1];
-
-                qDebug() << "Applying MTT";
-
-                global_mtt_array = this->MTT(global_mtt_array, r, q, diff_d, diff_fi, min_OLGI, min_NT);
-
-                // kontrola po pouziti MTT
-                for(i=0; i<10; i++) qDebug() << "X: " << global_mtt_array[i*2] << " Y: " << global_mtt_array[i*2+1];*/
+                if(!radarList->at(i)->radar->isEnabled() || radarList->at(i)->stale) continue;
+                if(radarList->at(i)->radar->getMeasurementTimeLast()>epoch) epoch = radarList->at(i)->radar->getMeasurementTimeLast();
             }
+        }
+        QVarLengthArray<float, 2*MAX_N> predicted;
 
+        fusion->clear();
+        for(i=0; i<arrays.count(); i++)
+        {
+            // if radar was disabled by user or does not send data anymore, do not use it in fusion algorithm
+            if(!radarList->at(i)->radar->isEnabled() || radarList->at(i)->stale) continue;
 
-            while(global_mtt_array_pointer<MAX_N*2)
-                global_mtt_array[global_mtt_array_pointer++] = 0.0;
-
-            //qDebug() << "FILLING FINISHED";
-
-            /* THE FOLLOWING CODE IS ONLY FOR TEST PURPOSES */
-            /* -------------------------------------------- */
-            /* -------------------------------------------- */
-
-            /*for(int i=0; i<MAX_N; i++)
+            float * coordinates = arrays.at(i);
+            if(epoch>=0 && targets_count.at(i)>0)
             {
-                // copy array
-                float * temp_array = new float[MAX_N*2];
-                // zero all values except the considered one
-                for(int a=0; a<MAX_N; a++)
-                {
-                    temp_array[a*2] = temp_array[a*2+1] = 0.0;
-
-                    if(a==i)
-                    {
-                        //temp_array[a*2] = global_mtt_array[a*2];
-                        //temp_array[a*2+1] = global_mtt_array[a*2+1];
-                        temp_array[0] = global_mtt_array[a*2];
-                        temp_array[1] = global_mtt_array[a*2+1];
-                    }
-                    //else temp_array[a*2] = temp_array[a*2+1] = 0.0;
-                }
-
-                qDebug() << "ARRAY BEFORE MTT: ";
-
-                for(int j = 0; j<MAX_N; j++) qDebug() << "X: " << temp_array[j*2] << " Y: " << temp_array[j*2+1];
-
-                qDebug() << "ARRAY BEFORE MTT END";
+                predicted.resize(targets_count.at(i)*2);
+                radarList->at(i)->radar->predictCoordinatesLast(epoch, predicted.data());
+                coordinates = predicted.data();
+            }
 
+            for(j=0; j<targets_count.at(i); j++)
+            {
+                // apply transformation to operator coordinate system
+                radarList->at(i)->radar->doTransformation(coordinates[j*2], coordinates[j*2+1]);
 
-                this->MTT(temp_array, r, q, diff_d, diff_fi, min_OLGI, min_NT);
+                // Usually if MTT produces invalid value, the "nan" or "inf/-inf" states were catched. Therefore it is much better to not consider such values
+                float x = radarList->at(i)->radar->getTransformatedX();
+                float y = radarList->at(i)->radar->getTransformatedY();
 
-                qDebug() << "ARRAY AFTER MTT: ";
+                if(!coordinatesAreValid(x, y)) continue;
 
-                // find not zeroes and fill global_mtt_array
-                for(int k =0; k<MAX_N; k++)
-                {
-                    qDebug() << "X: " << temp_array[k*2] << " Y: " << temp_array[k*2+1];
+                fusion->addPosition(radarList->at(i)->id, x, y);
+            }
+        }
 
-                    if(coordinatesAreValid(temp_array[k*2], temp_array[k*2+1]))
-                    {
-                        global_mtt_array[i*2] = temp_array[k*2];
-                        global_mtt_array[i*2+1] = temp_array[k*2+1];
-                    }
-                }
+        // each position can form its own cluster at most
+        if(fusedPositionsCapacity<fusion->getCount()+1)
+        {
+            delete [] fusedPositions;
+            fusedPositionsCapacity = 2*(fusion->getCount()+1);
+            fusedPositions = new float[fusedPositionsCapacity*2];
+        }
 
-                qDebug() << "ARRAY AFTER MTT END";
+        fused_positions = fusedPositions;
+        fused_count = fusion->fuse(fused_positions, NULL);
+    }
 
-                delete [] temp_array;
-            }*/
+    if(!arrays.isEmpty() && !targets_count.isEmpty())
+    {
 
-            /* THE UPPER     CODE IS ONLY FOR TEST PURPOSES */
-            /* -------------------------------------------- */
-            /* -------------------------------------------- */
+        // backup frame is collected here and handed to backup writer at once
+        QVarLengthArray<backup_track_record, MAX_N> backupTracks;
+        backup_track_record backupTrack;
 
 
-            float * global_mtt_array_result = global_mtt_array; // Result array of target coordinates from global MTT algorithm.
+        if(enableGlobalMTT)
+        {
+            // one central tracker follows fused positions, tracker array is reused and zeroed after the last position
+            prepareGlobalMTT(fused_count);
+            int capacity = mtt_p_g->getCapacity();
 
-            int global_mtt_array_result_pointer = global_mtt_array_pointer; // Holds the information about, how many numbers there are in array.
+            if(fused_count>capacity)
+                qDebug() << "Global MTT recieved " << fused_count << " fused positions, capacity is only " << capacity << ". Remaining positions are not tracked.";
 
-            // Backup data on disk, if backup is enabled
-            bool backupEnabled = false;
-            settingsMutex->lock();
-                backupEnabled = settings->getDiskBackupEnabled();
-            settingsMutex->unlock();
-            if(backupEnabled)
+            for(j=0; j<fused_count && j<capacity; j++)
             {
-                for(j=0; j<(global_mtt_array_result_pointer/2); j++)
-                {
-                    // check if values are not NaN or -+ infinite. Also if y-coordinate is zero, coordinates are not valid
-                    // Therefore also filtration of positions zeroed by MTT is done.
-                    if(coordinatesAreValid(global_mtt_array_result[j*2], global_mtt_array_result[j*2+1]))
-                    {
-                        makeDataBackup(global_mtt_array_result[j*2]);
-                        makeDataBackup(global_mtt_array_result[j*2+1]);
-                    }
-                }
+                globalMTTArray[j*2] = fused_positions[j*2];
+                globalMTTArray[j*2+1] = fused_positions[j*2+1];
             }
+            for(j*=2; j<capacity*2; j++) globalMTTArray[j] = 0.0;
 
-            // Append data to visualizationData list.
-            // if active_radar_ID is not less or equal to zero, another data, from another radar are desired to be seen
-            if(active_radar_ID_index<0 || active_radar_ID<=0)
+            // create MTT constants
+            float r[] = {0.1, 0.01};
+            float q[] = {0.0, 0.01, 0.0, 0.0001};
+            float diff_d = 1.0;
+            float diff_fi = 0.6;
+            int min_NT = 10;
+            int min_OLGI = 10;
+
+            if(globalMTTModel==MTT_CARTESIAN_STATE)
             {
-                for(j=0; j<(global_mtt_array_result_pointer/2); j++)
-                {
-
-                    // check if values are not NaN or -+ infinite. Also if y-coordinate is zero, coordinates are not valid
-                    // Therefore also filtration of positions zeroed by MTT is done.
-                    if(coordinatesAreValid(global_mtt_array_result[j*2], global_mtt_array_result[j*2+1]))
-                    {
-                        QPointF * temp_point = new QPointF(global_mtt_array_result[j*2], global_mtt_array_result[j*2+1]);
-
-                        visualizationDataMutex->lock();
-                        visualizationData->append(temp_point);
-                        visualizationDataMutex->unlock();
-                    }
-                }
+                // the same noise expressed in meters (see radarUnit::processNewData)
+                r[1] = 0.1;
+                q[3] = 0.01;
+                diff_fi = 1.0;
             }
 
+            mtt_p_g->MTT(globalMTTArray, r, q, diff_d, diff_fi, min_OLGI, min_NT);
 
-            // Do not forget to delete common array
-            delete[] global_mtt_array;
-
-            qDebug() << "SEQUENCE FINISHED";
-        }
-        else
-        {
-
-            // The following cycle will do averaging of coordinates: no fusion algorithm availible
-            // it is also supposed that indexes of coordinates are the same for specific target
+            // tracks occupy the first slots, their identifiers do not change when other tracks are dropped
+            int tracks = mtt_p_g->getTracksCount();
+            const int * ids = mtt_p_g->getTrackIds();
 
-            for(j=0; j<maximum_targets_visible; j++)
+            for(j=0; j<tracks; j++)
             {
-                x_average = 0.0;
-                y_average = 0.0;
-                counter = 0;
-
-                // iterating through all possible targets
-                for(i=0; i<arrays.count(); i++)
-                {
-                    // if radar was disabled by user, do not use it in fusion algorithm
-                    if(!radarList->at(i)->radar->isEnabled()) continue;
-
-                    // if is less the radar unit surely has information about target's coordinates
-                    if(j<targets_count.at(i))
-                    {
-                        // apply transformation to operator coordinate system
-
-                        radarList->at(i)->radar->doTransformation(arrays.at(i)[j*2], arrays.at(i)[j*2+1]);
-
-                        // Usually if MTT produces invalid value, the "nan" or "inf/-inf" states were catched. Therefore it is much better to not consider such values
-                        float x = radarList->at(i)->radar->getTransformatedX();
-                        float y = radarList->at(i)->radar->getTransformatedY();
-
-                        if(!coordinatesAreValid(x, y)) continue;
+                // check if values are not NaN or -+ infinite. Also if y-coordinate is zero, coordinates are not valid
+                // Therefore also filtration of positions zeroed by MTT is done.
+                if(!coordinatesAreValid(globalMTTArray[j*2], globalMTTArray[j*2+1])) continue;
 
-                        x_average += x;
-                        y_average += y;
+                backupTrack.id = ids[j];
+                backupTrack.x = globalMTTArray[j*2];
+                backupTrack.y = globalMTTArray[j*2+1];
+                backupTracks.append(backupTrack);
 
-                        ++counter;
-                    }
-                }
-
-                // calculate average value
-                x_average /= (float)(counter);
-                y_average /= (float)(counter);
-
-                settingsMutex->lock();
-                    if(settings->getDiskBackupEnabled())
-                    {
-                        makeDataBackup(x_average);
-                        makeDataBackup(y_average);
-                    }
-                settingsMutex->unlock();
-
-                // append to visualization vector if counter is more than one (at least one radar had value)
                 // if active_radar_ID is not less or equal to zero, another data, from another radar are desired to be seen
-                if(active_radar_ID_index<0 || active_radar_ID<=0) if(counter>=1)
-                {
-                    QPointF * temp_point = new QPointF(x_average, y_average);
-
-                    visualizationDataMutex->lock();
-                    visualizationData->append(temp_point);
-                    visualizationDataMutex->unlock();
-                }
+                // track identifier is used, so color of target does not depend on other targets
+                if(active_radar_ID_index<0 || active_radar_ID<=0) visualizationData->append(globalMTTArray[j*2], globalMTTArray[j*2+1], ids[j]);
             }
         }
-
-        // if data backup is enabled we need end record by adding end-of-line sign
-        settingsMutex->lock();
-            if(settings->getDiskBackupEnabled()) makeDataBackup((float)(0.0), false, false, true);
-        settingsMutex->unlock();
-    }
-
-    visualizationDataMutex->lock();
-    qDebug() << "DATA COUNT " << visualizationData->count();
-    visualizationDataMutex->unlock();
-}
-
-void stackManager::clearVisualizationData()
-{
-    visualizationDataMutex->lock();
-    while(!visualizationData->isEmpty())
-    {
-        delete[] visualizationData->first();
-        visualizationData->removeFirst();
-    }
-    visualizationDataMutex->unlock();
-}
-
-void stackManager::updateRadarSubWindowList()
-{
-    // NOTE THAT WE DO NOT NEED TO LOCK RADARLIST MUTEX SINCE THIS FUNCTION IS CALLED IN FUSION FUNCTION OR IN AREA ALREADY PROTECTED BY RADARLIST MUTEXES
-
-    // iterate over all subwindows
-    int id, targets_number;
-    float * coordinates;
-    radarSubWindowListMutex->lock();
-
-    if(radarSubWindowList->isEmpty()) { radarSubWindowListMutex->unlock(); return; }
-
-    for(int a = 0; a<radarSubWindowList->count(); a++)
-    {
-        id = radarSubWindowList->at(a)->getRadarId();
-        // find radar unit
-        for(int b = 0; b<radarList->count(); b++)
+        else
         {
 
-            if(id==radarList->at(b)->id)
+            // fused positions were already computed by spatial clustering and are not tracked, index is their identifier
+            for(j=0; j<fused_count; j++)
             {
-                // update points vector with new values
-                coordinates = radarList->at(b)->radar->getCoordinatesLast();
-                targets_number = radarList->at(b)->radar->getNumberOfTargetsLast();
-
-                // if corrupted, or unavailible data
-                if(targets_number<0 || coordinates==NULL) break;
+                backupTrack.id = j;
+                backupTrack.x = fused_positions[j*2];
+                backupTrack.y = fused_positions[j*2+1];
+                backupTracks.append(backupTrack);
+            }
 
-                radarSubWindowList->at(a)->addVisualizationData(coordinates, targets_number);
+            // if active_radar_ID is not less or equal to zero, another data, from another radar are desired to be seen
+            if(active_radar_ID_index<0 || active_radar_ID<=0)
+            {
+                for(j=0; j<fused_count; j++) visualizationData->append(fused_positions[j*2], fused_positions[j*2+1], j);
             }
         }
-    }
-    radarSubWindowListMutex->unlock();
-}
 
-void stackManager::makeDataBackup(float val, bool write_val, bool newline, bool endline)
-{
-    // MUTEX IS NOT CALLED HERE SINCE IT IS SUPPOSED THAT MUTEX WAS ALREADY CALLED IN PARENT FUNCTION
-    // if data backup is enabled we need to write all recieved coordinates
-
-    if(!newline) (*settings->getBackupFileHandler()) << "%";
-
-    if(write_val) (*settings->getBackupFileHandler()) << val;
-
-    if(endline) (*settings->getBackupFileHandler()) << "\n";
-}
-
-void stackManager::makeDataBackup(QString val, bool write_val, bool newline, bool endline)
-{
-    // MUTEX IS NOT CALLED HERE SINCE IT IS SUPPOSED THAT MUTEX WAS ALREADY CALLED IN PARENT FUNCTION
-    // if data backup is enabled we need to write all recieved coordinates
-
-    if(!newline) (*settings->getBackupFileHandler()) << "%";
-
-    if(write_val) (*settings->getBackupFileHandler()) << val;
-
-    if(endline) (*settings->getBackupFileHandler()) << "\n";
-}
-
-void stackManager::makeDataBackup(qint64 val, bool write_val, bool newline, bool endline)
-{
-    // MUTEX IS NOT CALLED HERE SINCE IT IS SUPPOSED THAT MUTEX WAS ALREADY CALLED IN PARENT FUNCTION
-    // if data backup is enabled we need to write all recieved coordinates
-
-    if(!newline) (*settings->getBackupFileHandler()) << "%";
-
-    if(write_val) (*settings->getBackupFileHandler()) << val;
-
-    if(endline) (*settings->getBackupFileHandler()) << "\n";
-}
-
-void stackManager::swap(float * array, int l, int r)
-{
-    // exchange two values in array
-    float temp = array[l];
-    array[l] = array[r];
-    array[r] = temp;
-}
-
-void stackManager::quicksort(float * array, int l, int r)
-{
-    if(l>=r) return;
-
-    int bound = l;
-    for(int i = l+1; i<r; i++)
-    {
-        if(array[i]>array[l])
-        {
-            swap(array, i, ++bound);
-        }
+        // if data backup is enabled, frame is only copied into writer's ring, disk is accessed by writer thread
+        // writer can not be deleted while settings mutex is held (see MainWindow::deleteDiskBackupDependencies)
+        settingsMutex->lock();
+            if(settings->getDiskBackupEnabled() && settings->getBackupWriter()!=NULL)
+                settings->getBackupWriter()->push(fusionTime, backupTracks.constData(), backupTracks.count());
+        settingsMutex->unlock();
     }
 
-    swap(array, l, bound);
-
-    // apply recursive quicksort to left and right subarrays
-    quicksort(array, l, bound);
-    quicksort(array, bound+1, r);
-}
-
-float stackManager::median(float *array, int size)
-{
-    // create temp array so quicksort can manipulate and replace values with no effect on original array
-    float * temp_array = new float[size];
-
-    // copy array
-    for(int i = 0; i<size; i++)
-        temp_array[i] = array[i];
-
-    // sort values in array
-    quicksort(temp_array, 0, size-1);
-
-    // get median from sorted array
-    float median = 0.0;
-    int middle = size%2;
-    if(middle)
-        median = temp_array[(int)(size/2)+1];
-    else
-        median = (temp_array[size/2]+temp_array[(size/2)+1])/2.0;
-
-    delete [] temp_array;
+    qDebug() << "DATA COUNT " << frame->count;
 
-    return median;
+    // single atomic swap, rendering thread is never blocked by fusion
+    visualizationData->publish(fusionTime);
 }
@@ -30,6 +30,10 @@
 #include <QThread>
 #include <QWaitCondition>
 #include <QElapsedTimer>
+#include <QMap>
+#include <QColor>
+#include <QDateTime>
+#include <QVarLengthArray>
 #include <limits>
 
 #include <QDebug>
@@ -38,8 +42,11 @@
 #include "stddefs.h"
 #include "uwbsettings.h"
 #include "radar_handler.h"
-#include "radarsubwindow.h"
 #include "mtt_pure.h"
+#include "mttsnapshot.h"
+#include "spatialfusion.h"
+#include "framebuffer.h"
+#include "backupwriter.h"
 
 class stackManager : public QObject
 {
@@ -54,14 +61,16 @@ public:
      * @param[in] settings_mutex The mutex locking the settings object during reading some settings value.
      * @param[in] radar_list Is the list with all radar handler structures that are currently registered by application.
      * @param[in] radar_list_mutex The mutex locking the radar_list object during reading/writing values or doing some processing on recieved data.
+     * @param[in] mtt_snapshots Saved MTT states indexed by radar id (id 0 is global MTT). States are restored on start and saved on stop if warm start is enabled.
+     * @param[in] mtt_snapshots_mutex The mutex locking the mtt_snapshots object.
      *
      * This constructor will obtain all pointers and mutex pointers when creating the object from the main
      * application thread. These pointers are saved and a few important values are initialized to their
      * default values (later they are rewritten by settings values if they are specified).
      */
     stackManager(QVector<rawData * > * raw_data_stack, QMutex * raw_data_stack_mutex, QVector<radar_handler * > * radar_list, QMutex * radar_list_mutex,
-                 QList<QPointF * > * visualization_data, QList<QColor * > * visualization_color, QList<radarSubWindow * >  * radar_Sub_Window_List, QMutex * radar_Sub_Window_List_Mutex, QMutex * visualization_data_mutex,
-                 uwbSettings * setts, QMutex * settings_mutex);
+                 frameBuffer * visualization_data, QList<QColor * > * visualization_color, QMutex * visualization_data_mutex,
+                 uwbSettings * setts, QMutex * settings_mutex, QMap<unsigned int, mttSnapshot * > * mtt_snapshots, QMutex * mtt_snapshots_mutex);
     ~stackManager();
 
     /**
@@ -102,43 +111,17 @@ public:
      */
     qint64 getCurrentProcessingSpeed(void);
 
-    /**
-     * @brief Function takes array and indexes of values which are to be exchanged on their positions.
-     * @param[in] array Array of values to be swapped.
-     * @param[in] l The first value for exchange.
-     * @param[in] r The second value for exchange.
-     */
-    void swap(float * array, int l, int r);
-
-    /**
-     * @brief Sorts the values of array from the largest to smallest by using 'QuickSort' algorithm.
-     * @param[in] array Input array of values to be sort.
-     * @param[in] l The starting index of array (usually 0).
-     * @param[in] r The ending index of array.
-     */
-    void quicksort(float * array, int l, int r);
-
-    /**
-     * @brief Median takes the array of values and the size of this array while it returns a median from it.
-     * @param[in] array Input array of values.
-     * @param[in] size The size of array (number of values in array).
-     * @return The return value is calculated median of values in array.
-     */
-    float median(float * array, int size);
-
 private:
-    int active_radar_ID; ///< This variable holds information about, what radar data should be pumped into visualizationData list.
+    int active_radar_ID; ///< This variable holds information about, what radar data should be published through visualizationData buffer.
     int active_radar_ID_index; ///< This variable stores index of active radar specified by active_radar_ID in radarList.
 
     QVector<rawData * > * rawDataStack; ///< Pointer to the stack
     QMutex * rawDataStackMutex; ///< Pointer to the mutex locking the stack
     uwbSettings * settings; ///< Pointer to the basic application settings object
     QMutex * settingsMutex; ///< Pointer to the mutex locking the settings object
-    QList<QPointF * > * visualizationData; ///< The final positions of targets
-    QList<radarSubWindow * >  * radarSubWindowList; ///< If some subwindows for displaying specific radar data are created, we need to push relevant values into their prive vectors.
+    frameBuffer * visualizationData; ///< The final positions of targets, one frame is published after each fusion
     QList<QColor * > * visualizationColor; ///< The colors assigned to all targets
-    QMutex * visualizationDataMutex; ///< Mutex protecting visualization data from being accessed by multiple threads at the same time
-    QMutex * radarSubWindowListMutex; ///< Mutex protecting radar sub windows vectors from being accessed by multiple threads at the same time
+    QMutex * visualizationDataMutex; ///< Mutex protecting color list, positions are passed through 'visualizationData' without locking
 
     unsigned int idleTime; ///< The idle time, during the thread is sleeping after it find out that the stack is empty
     unsigned int stackControlPeriodicity; ///< Number of cycles that must pass until the 'stackControl' function is run
@@ -165,7 +148,44 @@ private:
     qint64 currentProcessingSpeed; ///< Holds the last processing time in nanoseconds.
     qint64 processingIterator; ///< Counts how many processing iterations there were so far.
 
-    mtt_pure * mtt_p_g; ///< MTT object with all MTT functionality amied to process data globally.
+    mtt_pure * mtt_p_g; ///< MTT object with all MTT functionality amied to process data globally. Created on first use of global MTT.
+
+    spatialFusion * fusion; ///< Clusters positions of all radars into fused targets. Created on first use.
+
+    float * globalMTTArray; ///< Fused positions passed to global MTT, length is twice the capacity of global MTT.
+    int globalMTTArrayCapacity; ///< Number of positions globalMTTArray can hold.
+
+    float * fusedPositions; ///< Output of spatial fusion [x, y] of each cluster, reused by all fusion cycles.
+    int fusedPositionsCapacity; ///< Number of positions fusedPositions can hold.
+
+    int targetCapacity; ///< Maximum number of targets for one radar unit, loaded from settings when new data are processed.
+
+    QMap<unsigned int, mttSnapshot * > * mttSnapshots; ///< Saved MTT states indexed by radar id, global MTT state is stored under id 0 (operator).
+    QMutex * mttSnapshotsMutex; ///< The mutex locking the mttSnapshots object.
+    mtt_state_model globalMTTModel; ///< State model of global MTT, loaded from settings when worker is created.
+    bool mttWarmStart; ///< If true, MTT states are restored when worker starts and saved when it stops. Loaded from settings when worker starts.
+
+    qint64 fusionTime; ///< Arrival time of the newest processed data in milliseconds since epoch. Time base of radar updates, fusion deadline and fused frames, so replayed data are fused the same way as live ones.
+    qint64 frameStart; ///< Time of the first new data since the last fusion, -1 if no radar was updated yet.
+    unsigned int fusionDeadline; ///< Maximum time in miliseconds fusion waits for radars, loaded from settings when new data are processed.
+    unsigned int fusionQuorum; ///< Number of updated radars fusion runs immediately for (0 means all active radars), loaded from settings when new data are processed.
+    unsigned int fusionStaleTime; ///< Radars without data for this time (miliseconds) are not fused, loaded from settings when new data are processed.
+
+    /**
+     * @brief Restores MTT states of all known radar units and global MTT from saved snapshots.
+     */
+    void restoreMTTStates(void);
+
+    /**
+     * @brief Restores MTT state of single radar unit if snapshot for its id exists. The 'radarList' must be locked by caller.
+     * @param[in] handler Radar handler of unit to restore.
+     */
+    void restoreMTTStateOf(radar_handler * handler);
+
+    /**
+     * @brief Saves MTT states of all radar units and global MTT into snapshots list.
+     */
+    void saveMTTStates(void);
 
     /**
      * @brief Function is used to check values that come from MTT. Sometimes they can be NaN or +-infinite. These values should not be considered
@@ -188,53 +208,24 @@ private:
     void dataProcessing(rawData * data);
 
     /**
-     * @brief Checks for all known 'radarUnit' objects if they were updated with new data.
-     * @return The return value is true if all 'radarUnit' objects are updated with new data.
+     * @brief Checks if the frame of new data is complete enough for fusion and updates staleness of all radars.
+     * @return The return value is true if all active radars (enabled and not stale) were updated, if quorum of radars was updated or if fusion deadline passed.
      */
     bool checkRadarDataUpdateStatus(void);
 
     /**
-     * @brief This function is applying the fusion algorithm and updating visualization list.
-     */
-    void applyFusion(void);
-
-    /**
-     * @brief Clears all vector with positions of targets in the scene and prepares the vector for new data.
-     */
-    void clearVisualizationData(void);
-
-    /**
-     * @brief While updating data, we must add specific radar data to the privet vectors contained in radar subwindows.
+     * @brief Creates global MTT or increases its capacity (tracks are kept) and prepares array for its observations.
+     * @param[in] observations Number of observations passed to global MTT in this cycle. Capacity is never lower than target capacity from settings nor higher than MAX_TARGET_CAPACITY.
      */
-    void updateRadarSubWindowList(void);
+    void prepareGlobalMTT(int observations);
 
     /**
-     * @brief Function will make backup (write to file) in file specified in settings object from value passed as parameter.
-     * @param[in] val Value to be written.
-     * @param[in] write_val If is set to true, value will be written.
-     * @param[in] newline If new line is true, no separator will be prepended.
-     * @param[in] endline If end line is true, '\n' will be appended.
-     */
-    void makeDataBackup(float val, bool write_val=true, bool newline=false, bool endline=false);
-
-    /**
-     * @brief This is overloaded function. Allows writing strings into file instead the float numbers. Used primarily for proving time information.
-     * @param[in] val String value to be written.
-     * @param[in] write_val If is set to true, value will be written.
-     * @param[in] newline If new line is true, no separator will be prepended.
-     * @param[in] endline If end line is true, '\n' will be appended.
-     */
-    void makeDataBackup(QString val, bool write_val=true, bool newline=false, bool endline=false);
-
-    /**
-     * @brief This is overloaded function. Allows writing epochal time in qint64 format into file.
-     * @param[in] val qint64 value to be written.
-     * @param[in] write_val If is set to true, value will be written.
-     * @param[in] newline If new line is true, no separator will be prepended.
-     * @param[in] endline If end line is true, '\n' will be appended.
+     * @brief This function is applying the fusion algorithm and updating visualization list.
+     *
+     * Each target is published with identifier (track identifier of global MTT, index of fused position otherwise). If disk backup
+     * is enabled, valid targets of frame are pushed as one binary frame to 'backupWriter' (see backupwriter.h).
      */
-    void makeDataBackup(qint64 val, bool write_val=true, bool newline=false, bool endline=false);
-
+    void applyFusion(void);
 
 
 public slots:
@@ -244,8 +235,8 @@ public slots:
     void rescue(void);
 
     /**
-     * @brief Changes active radar ID so data from specified radar will be pumped into visualizationData list
-     * @param[in] id New radar to be considered when filling visualizationData list with new values.
+     * @brief Changes active radar ID so data from specified radar will be published through visualizationData buffer
+     * @param[in] id New radar to be considered when filling visualizationData buffer with new values.
      */
     void changeActiveRadarId(int id);
 
@@ -32,6 +32,10 @@ stackManagerDialog::stackManagerDialog(uwbSettings * setts, QMutex * settings_Mu
     ui->maximumWarningCountSpinBox->setValue(settings->getMaxStackWarningCount());
     ui->idleTimeSpinBox->setValue(settings->getStackIdleTime());
 
+    ui->fusionDeadlineSpinBox->setValue(settings->getFusionDeadline());
+    ui->fusionQuorumSpinBox->setValue(settings->getFusionQuorum());
+    ui->fusionStaleTimeSpinBox->setValue(settings->getFusionStaleTime());
+
     settingsMutex->unlock();
 
     connect(this, SIGNAL(accepted()), this, SLOT(accepted()));
@@ -52,5 +56,10 @@ void stackManagerDialog::accepted()
 
     settings->setStackRescueState(ui->stackRescueCheckBox->isChecked());
 
+    // stack manager reads fusion options with each processed data
+    settings->setFusionDeadline(ui->fusionDeadlineSpinBox->value());
+    settings->setFusionQuorum(ui->fusionQuorumSpinBox->value());
+    settings->setFusionStaleTime(ui->fusionStaleTimeSpinBox->value());
+
     settingsMutex->unlock();
 }
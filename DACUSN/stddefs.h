@@ -1,9 +1,10 @@
 #ifndef STDDEFS
 #define STDDEFS
 
-#define MTT_ARRAY_FIT       (1)         ///< If this macro is set to 1, compiler will unlock code for array stretching to MAX_N macro, if one target is visible, still 20 float positions are allocated
-#define MAX_N               (10)        ///< max dimension of cost matrix in Munkres algorithm
-                                        ///< (max number of targets)
+#define MTT_ARRAY_FIT       (1)         ///< If this macro is set to 1, compiler will unlock code for array stretching to target capacity, if one target is visible, still capacity*2 float positions are allocated
+#define MAX_N               (10)        ///< default dimension of cost matrix in Munkres algorithm
+                                        ///< (default number of targets, see 'uwbSettings::getTargetCapacity')
+#define MAX_TARGET_CAPACITY (1024)      ///< Upper limit of target capacity which can be set by user
 extern double METER_TO_PIXEL_RATIO;     ///< Sets the ratio between meters and pixels. Pixels are then calculated as x*METER_TO_PIXEL_RATIO
 
 /**
@@ -13,7 +14,36 @@ enum reciever_method
 {
     UNDEFINED = 0, ///< May be used for situations when no method is needed at all (idle method)
     SYNTHETIC = 1, ///< Is used when the data are read by server application from file and sent throught windows pipe
-    RS232 = 2 ///< This enum state is used when user wants to recieve data via serial connection
+    RS232 = 2, ///< This enum state is used when user wants to recieve data via serial connection
+    RAW_IR = 3, ///< Raw impulse responses of both channels are read from file or TCP socket and targets are detected by central unit
+    REPLAY = 4 ///< Recorded measurements or backup frames are read from file and fed with virtual time (see 'replaySource'), data keep the method they were recorded with
+};
+
+/**
+ * @brief The raw_ir_source enum specifies where raw impulse responses are read from if RAW_IR method is used.
+ */
+enum raw_ir_source
+{
+    RAW_IR_FILE = 0, ///< Frames are read from file (recorded data, throughput measurement)
+    RAW_IR_SOCKET = 1 ///< Frames are read from TCP connection, source is given as "host:port"
+};
+
+/**
+ * @brief Parameters of detection chain which converts raw impulse responses into target coordinates (see 'mtt_pure::detect').
+ */
+struct ir_detection_parameters
+{
+    float exp_factor; ///< Forgetting factor of exponential background subtraction
+    float beta_fast; ///< Weight of fast CFAR filter (target signal estimation)
+    float beta_slow; ///< Weight of slow CFAR filters (noise mean and energy estimation)
+    float alpha_det; ///< CFAR threshold in multiples of noise standard deviation
+    int t_size; ///< Length of window integrating detector output along impulse response
+    int min_int; ///< Minimal number of detections in window considered as target
+    int m; ///< Number of samples first reflections are widened by, so reflections of one target from both channels overlap
+    float x1; ///< Position of receiving antenna of channel 1 on x axis (transmitting antenna is in origin)
+    float x2; ///< Position of receiving antenna of channel 2 on x axis
+    int sa_count; ///< Number of scans averaged by software averaging ahead of detection chain (1 = off, see 'mtt_pure::setAveraging')
+    int sa_hop; ///< Averaged scan is produced every 'sa_hop' scans
 };
 
 enum visualization_schema
@@ -54,6 +84,25 @@ enum rendering_engine_buffer_type
     DOUBLE_BUFFERING = 1
 };
 
+/**
+ * @brief The mtt_state_model enum selects the state vector used by MTT Kalman filters.
+ */
+enum mtt_state_model
+{
+    MTT_POLAR_STATE = 0, ///< Original tracker with state (r, dr/dt, fi, dfi/dt). Observations are converted to polar and estimations back to cartesian coordinates.
+    MTT_CARTESIAN_STATE = 1 ///< Constant velocity tracker with state (x, dx/dt, y, dy/dt). Observations and estimations are used directly, no trigonometry is needed.
+};
+
+/**
+ * @brief The fusion_estimator enum selects how positions of one cluster are combined into fused position (see 'spatialFusion').
+ */
+enum fusion_estimator
+{
+    FUSION_MEAN = 0, ///< Average of all positions in cluster.
+    FUSION_MEDIAN = 1, ///< Median of x and y coordinates separately. One bad radar can not move the fused position far away.
+    FUSION_TRIMMED_MEAN = 2 ///< Average of positions after the lowest and highest coordinates (given fraction on each side) are dropped.
+};
+
 
 #endif // STDDEFS
 
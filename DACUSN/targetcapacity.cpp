@@ -0,0 +1,87 @@
+/**
+ * @file targetcapacity.cpp
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Definitions of targetArena class methods and capacity helper functions.
+ *
+ * @section DESCRIPTION
+ *
+ * Originally every array related to targets (MTT matrices, packet coordinates, fusion buffers) was
+ * allocated for exactly MAX_N targets. Larger halls can contain more people than that, so the capacity
+ * is now configurable. Small capacities are served by fixed size storage templates (see 'mttStorage'
+ * in mttstorage.h), larger ones by dynamically sized storage carved out of 'targetArena'.
+ *
+ */
+
+#include "targetcapacity.h"
+
+targetArena::targetArena(size_t block_size)
+{
+    head = NULL;
+    blockSize = block_size;
+    reservedBytes = 0;
+}
+
+targetArena::~targetArena()
+{
+    reset();
+}
+
+void * targetArena::allocate(size_t bytes)
+{
+    // keep all allocations aligned to 16 bytes so vectorized code may use them
+    bytes = (bytes + 15) & ~((size_t)(15));
+
+    if(head==NULL || (head->size - head->used)<bytes)
+    {
+        // not enough space in current block, new block is required
+        size_t size = (bytes>blockSize) ? bytes : blockSize;
+        size_t header = (sizeof(arena_block) + 15) & ~((size_t)(15));
+
+        arena_block * block = (arena_block *)(malloc(header + size));
+        if(block==NULL) return NULL;
+
+        block->next = head;
+        block->size = size;
+        block->used = 0;
+        head = block;
+
+        reservedBytes += size;
+    }
+
+    size_t header = (sizeof(arena_block) + 15) & ~((size_t)(15));
+    unsigned char * ptr = ((unsigned char *)(head)) + header + head->used;
+    head->used += bytes;
+
+    memset(ptr, 0, bytes);
+
+    return ptr;
+}
+
+void targetArena::reset()
+{
+    while(head!=NULL)
+    {
+        arena_block * next = head->next;
+        free(head);
+        head = next;
+    }
+
+    reservedBytes = 0;
+}
+
+int fitTargetCapacity(int requested)
+{
+    if(requested<1) requested = 1;
+    else if(requested>MAX_TARGET_CAPACITY) requested = MAX_TARGET_CAPACITY;
+
+    // the same steps as fixed 'mttStorage' specializations, see mtt_pure::createStorage
+    if(requested<=4) return 4;
+    else if(requested<=MAX_N) return MAX_N;
+    else if(requested<=16) return 16;
+    else if(requested<=32) return 32;
+    else if(requested<=64) return 64;
+
+    // dynamic storage is allocated exactly for required number of targets
+    return requested;
+}
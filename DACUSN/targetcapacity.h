@@ -0,0 +1,127 @@
+/**
+ * @file targetcapacity.h
+ * @author  Peter Mikula <mikula.ptr@gmail.com>
+ * @version 1.0
+ * @brief Helpers for storing per-target data when the number of targets is not fixed to MAX_N.
+ *
+ * @section DESCRIPTION
+ *
+ * Originally every array related to targets (MTT matrices, packet coordinates, fusion buffers) was
+ * allocated for exactly MAX_N targets. Larger halls can contain more people than that, so the capacity
+ * is now configurable. Small capacities are served by fixed size storage templates (see 'mttStorage'
+ * in mttstorage.h), larger ones by dynamically sized storage carved out of 'targetArena'. Matrices whose
+ * row length depends on the capacity are accessed through 'capacityMatrix' so the same [row][col] syntax
+ * can be used for fixed as well as for dynamic storage.
+ *
+ */
+
+#ifndef TARGETCAPACITY_H
+#define TARGETCAPACITY_H
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "stddefs.h"
+
+#define DYNAMIC_CAPACITY    (0)         ///< Template argument selecting the dynamically sized (arena backed) storage
+#define ARENA_BLOCK_SIZE    (65536)     ///< Default size of one arena block in bytes
+
+/**
+ * @brief The 'capacityMatrix' is a lightweight view of row-major matrix with row length known only at runtime.
+ *
+ * View does not own the memory. Indexing 'matrix[row][col]' works the same way as for common two dimensional
+ * arrays, therefore algorithms originally written for 'TYPE in[][MAX_N]' arrays may be kept unchanged.
+ */
+template <typename TYPE>
+class capacityMatrix
+{
+public:
+    capacityMatrix() : data(NULL), stride(0) {}
+    capacityMatrix(TYPE * matrix_data, int row_length) : data(matrix_data), stride(row_length) {}
+
+    /**
+     * @brief Returns pointer to the first element of row.
+     * @param[in] row Index of row.
+     * @return The return value is pointer to the row data, so second index can be applied.
+     */
+    TYPE * operator[](int row) const { return data + row*stride; }
+
+    /**
+     * @brief Returns the row length of matrix (number of columns).
+     * @return Number of columns.
+     */
+    int getStride(void) const { return stride; }
+
+    /**
+     * @brief Returns the pointer to underlying memory block.
+     * @return Pointer to the first element.
+     */
+    TYPE * getData(void) const { return data; }
+
+private:
+    TYPE * data; ///< Pointer to the first element of matrix
+    int stride; ///< Row length
+};
+
+/**
+ * @brief The 'targetArena' is a simple block (bump) allocator used by dynamically sized target storages.
+ *
+ * All memory is released at once when the arena is destroyed or reset. Individual deallocations are not
+ * supported which is fine for storages living as long as their owner (tracker, fusion buffers).
+ */
+class targetArena
+{
+public:
+    /**
+     * @brief Creates empty arena. First block is allocated when the first allocation is required.
+     * @param[in] block_size Minimal size of one block in bytes.
+     */
+    targetArena(size_t block_size = ARENA_BLOCK_SIZE);
+    ~targetArena();
+
+    /**
+     * @brief Allocates zeroed memory from the arena.
+     * @param[in] bytes Number of bytes required.
+     * @return Pointer to memory aligned to 16 bytes.
+     */
+    void * allocate(size_t bytes);
+
+    /**
+     * @brief Typed version of 'allocate' function.
+     * @param[in] count Number of elements required.
+     * @return Pointer to zeroed array of 'count' elements.
+     */
+    template <typename TYPE>
+    TYPE * allocateArray(size_t count) { return (TYPE *)(allocate(count*sizeof(TYPE))); }
+
+    /**
+     * @brief Frees all blocks. All pointers obtained from arena become invalid.
+     */
+    void reset(void);
+
+    /**
+     * @brief Returns the number of bytes allocated from operating system.
+     * @return Total size of all blocks in bytes.
+     */
+    size_t getReservedBytes(void) { return reservedBytes; }
+
+private:
+    struct arena_block {
+        arena_block * next; ///< Previously allocated block
+        size_t size; ///< Usable size of the block
+        size_t used; ///< Number of already used bytes
+    };
+
+    arena_block * head; ///< The block used for allocations, older blocks are linked through 'next'
+    size_t blockSize; ///< Minimal size of new block
+    size_t reservedBytes; ///< Sum of all block sizes
+};
+
+/**
+ * @brief Returns the real capacity that will be used for requested number of targets.
+ * @param[in] requested Required number of targets.
+ * @return Capacity of the smallest fixed storage able to hold 'requested' targets, or 'requested' itself if dynamic storage is needed.
+ */
+int fitTargetCapacity(int requested);
+
+#endif // TARGETCAPACITY_H
@@ -214,11 +214,15 @@ void uwbPacketTx::decrementPacketCount()
 /**********************************************************************************************************************/
 
 
-uwbPacketRx::uwbPacketRx(int port) : endingChar('$'), rounder(100.0), buffer_size(128), c_buffer_size(128)
+uwbPacketRx::uwbPacketRx(int port, int target_capacity) : buffer_size(128), c_buffer_size((2*(10+6*target_capacity)>128) ? 2*(10+6*target_capacity) : 128),
+    endingChar('$'), rounder(100.0)
 {
+    // cyclic buffer must hold at least two complete packets with all targets (10 overhead chars, 6 chars per target)
     comPort = port;
+    targetCapacity = target_capacity;
     radarID = radarTime = packetCount = dataCount = 0;
     data = NULL;
+    dataAllocated = 0;
     packet = NULL;
 
     crc_tab16_init = FALSE;
@@ -229,6 +233,15 @@ uwbPacketRx::uwbPacketRx(int port) : endingChar('$'), rounder(100.0), buffer_siz
     c_buffer = new unsigned char[c_buffer_size];
 }
 
+uwbPacketRx::~uwbPacketRx()
+{
+    deleteLastPacket();
+    if(data!=NULL) delete [] data;
+
+    delete [] buffer;
+    delete [] c_buffer;
+}
+
 int uwbPacketRx::readPacket()
 {
     // check basic bytes count to detect some simple errors
@@ -304,14 +317,27 @@ int uwbPacketRx::readPacket()
     // create data array as long as needed
     dataCount = packetLength-10; // packet length contains CRC, radarID, radarTime, packetCount bytes
 
-    // if MTT_ARRAY_FIT macro is 1 then we want to allocate array for maximum allowable coordinates possible, not exactly for recieved coordinates
+    dataCount /= 3; // since real data are represented by 3 chars, real data count is 3 times smaller as character count
+
+    // if MTT_ARRAY_FIT macro is 1 then we want to allocate array for maximum allowable coordinates possible, not exactly for recieved coordinates.
+    // If radar sends more targets than capacity, array is as long as needed so no target is dropped here.
     #if defined MTT_ARRAY_FIT && MTT_ARRAY_FIT==1
-        data = new float[MAX_N*2];
+        int required = getDataCapacity()*2;
     #else
-        data = new float[dataCount];
+        int required = dataCount;
     #endif
 
-    dataCount /= 3; // since real data are represented by 3 chars, real data count is 3 times smaller as character count
+    // the same array is used for all packets, receiver copies the values out before reading the next packet
+    if(required>dataAllocated)
+    {
+        if(data!=NULL) delete [] data;
+        data = new float[required];
+        dataAllocated = required;
+    }
+
+    #if defined MTT_ARRAY_FIT && MTT_ARRAY_FIT==1
+        for(int i=dataCount; i<required; i++) data[i] = 0.0;
+    #endif
 
     while(stack_pointer<(packetLength-4)) // last four bytes are not values, but CRC. StackPointer holds index position!
     {
@@ -333,6 +359,8 @@ int uwbPacketRx::readPacket()
             val_temp &= 0; // reset temporary bit stream
         }
     }
+
+    return 1;
 }
 
 void uwbPacketRx::deleteLastPacket()
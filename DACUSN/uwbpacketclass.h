@@ -107,13 +107,16 @@ private:
 
     unsigned char * packet; ///< Packet string that was recieved
     int packetLength; ///< When packet is read completely, this value stores the lastly recieved packet length even when buffer packet is zeroed (what in fact is needed due to implementation)
-    float * data; ///< Pointer to lastly recieved and parsed data (coordinates [x, y])
+    float * data; ///< Pointer to lastly recieved and parsed data (coordinates [x, y]), reused for the next packet
+    int dataAllocated; ///< Number of float values allocated in data array, array is reallocated only if next packet needs more
     int dataCount; ///< Specifies how many coordinates are in the data array
+    int targetCapacity; ///< Number of targets the data array is allocated for if MTT_ARRAY_FIT is used (more targets are never dropped, array is then as long as needed)
 
 public:
-    uwbPacketRx(int port); ///< Constructor
+    uwbPacketRx(int port, int target_capacity = MAX_N); ///< Constructor. Cyclic buffer is sized so packet with 'target_capacity' targets fits into it
+    ~uwbPacketRx(); ///< Destructor. Frees buffers, last packet and data array reused between packets
 
-    int readPacket(void); ///< Reads the 'packet' array acoording to packet length and reads all information from it
+    int readPacket(void); ///< Reads the 'packet' array acoording to packet length and reads all information from it. Returns 1 if success, 0 if CRC does not match, -1 or -2 if packet length is wrong
     bool recievePacket(void); ///< Takes 'packet' string and sends it via serial link. Returns true if success, false otherwise
 
     // functions for simple obtaining and changing common values
@@ -122,10 +125,12 @@ public:
     int getRadarId(void) { return radarID; }
     int getPacketCount(void) { return packetCount; }
     int getRadarTime(void) { return radarTime; }
-    float * getData(void) { return data; }
+    float * getData(void) { return data; } ///< Array is owned by this object and overwritten by the next packet
     unsigned char * getPacket(void) { return packet; }
     int getPacketLength(void) { return packetLength; }
     int getDataCount(void) { return dataCount; }
+    int getTargetCapacity(void) { return targetCapacity; }
+    int getDataCapacity(void) { return ((dataCount/2)>targetCapacity) ? (dataCount/2) : targetCapacity; } ///< Number of [x, y] positions allocated in data array
 };
 
 #endif // UWBPACKETCLASS_H
@@ -94,10 +94,12 @@ uwbSettings::uwbSettings()
     periodicalImgBackupInterval = 5000;
 
     diskBackupEnabled = false;
+    diskBackupCompressed = false;
+    diskBackupQuantum = 100; // 0.1 mm
+    measurementCaptureEnabled = false;
     diskBackupFilePath.setPath(QDir::currentPath());
     backupFileName.append(QString("radar_backup_%1").arg(QString(QDateTime::currentDateTime().toString()).replace(QRegExp(" |:"), "_")));
-    backupMainFileHandler = NULL;
-    backupFileHandler = NULL;
+    backupWriterHandler = NULL;
 
     comPort = -1;
     comPortName = NULL;
@@ -107,8 +109,43 @@ uwbSettings::uwbSettings()
     comPortMode[2] = '1';
     comPortMode[3] = '\0';
 
+    rawIRSourceType = RAW_IR_FILE;
+    rawIRSource = QString("");
+    irDetectionParameters.exp_factor = 0.97f;
+    irDetectionParameters.beta_fast = 0.4f;
+    irDetectionParameters.beta_slow = 0.005f;
+    irDetectionParameters.alpha_det = 2.0f;
+    irDetectionParameters.t_size = 10;
+    irDetectionParameters.min_int = 5;
+    irDetectionParameters.m = 15;
+    irDetectionParameters.x1 = -0.5f;
+    irDetectionParameters.x2 = 0.5f;
+    irDetectionParameters.sa_count = 1;
+    irDetectionParameters.sa_hop = 1;
+
+    replayFile = QString("");
+    replaySpeed = 1.0;
+
     enableSingleRadarMTT = false;
     enableGlobalRadarMTT = false;
+
+    targetCapacity = MAX_N;
+
+    fusionMergeRadius = SPATIAL_FUSION_RADIUS;
+    fusionEstimator = FUSION_MEAN;
+    fusionTrimFraction = SPATIAL_FUSION_TRIM;
+    fusionDeadline = 100;
+    fusionQuorum = 0;
+    fusionStaleTime = 1000;
+    fusionTimeAlignment = true;
+    radarHistoryDepth = RADAR_HISTORY_DEPTH;
+
+    singleRadarMTTModel = MTT_POLAR_STATE;
+    globalRadarMTTModel = MTT_POLAR_STATE;
+
+    mttWarmStart = false;
+    mttStatePersistent = false;
+    mttStateFilePath = QDir::currentPath() + QString("/mtt_state.bin");
 }
 
 uwbSettings::uwbSettings(char *config)
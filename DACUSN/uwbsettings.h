@@ -24,6 +24,10 @@
 #include <QFile>
 
 #include "stddefs.h"
+#include "spatialfusion.h"
+#include "radarhistory.h"
+
+class backupWriter;
 
 class uwbSettings
 {
@@ -110,6 +114,66 @@ public:
      */
     char * getComPortMode(void) { return strdup(comPortMode); }
 
+    /**
+     * @brief Sets the kind of source raw impulse responses are read from if RAW_IR reciever method is used.
+     * @param[in] type File or TCP socket.
+     */
+    void setRawIRSourceType(raw_ir_source type) { rawIRSourceType = type; }
+
+    /**
+     * @brief Retrieves the kind of source raw impulse responses are read from.
+     * @return File or TCP socket. Default is RAW_IR_FILE.
+     */
+    raw_ir_source getRawIRSourceType(void) { return rawIRSourceType; }
+
+    /**
+     * @brief Sets the source of raw impulse responses.
+     * @param[in] source File path or "host:port" of server, depending on source type.
+     */
+    void setRawIRSource(QString source) { rawIRSource = source; }
+
+    /**
+     * @brief Retrieves the source of raw impulse responses.
+     * @return File path or "host:port" of server.
+     */
+    QString getRawIRSource(void) { return rawIRSource; }
+
+    /**
+     * @brief Sets the parameters of detection chain applied on raw impulse responses.
+     * @param[in] params New parameters.
+     */
+    void setIRDetectionParameters(const ir_detection_parameters & params) { irDetectionParameters = params; }
+
+    /**
+     * @brief Retrieves the parameters of detection chain applied on raw impulse responses.
+     * @return Copy of parameters.
+     */
+    ir_detection_parameters getIRDetectionParameters(void) { return irDetectionParameters; }
+
+    /**
+     * @brief Sets the file fed by REPLAY reciever method.
+     * @param[in] file Path of measurement capture, binary backup or text backup.
+     */
+    void setReplayFile(QString file) { replayFile = file; }
+
+    /**
+     * @brief Retrieves the file fed by REPLAY reciever method.
+     * @return Path of replayed file.
+     */
+    QString getReplayFile(void) { return replayFile; }
+
+    /**
+     * @brief Sets the speed of replay.
+     * @param[in] speed Multiple of recorded speed, zero replays as fast as possible.
+     */
+    void setReplaySpeed(double speed) { replaySpeed = speed; }
+
+    /**
+     * @brief Retrieves the speed of replay.
+     * @return Multiple of recorded speed, zero if replay is unthrottled. Default is 1.0 (real time).
+     */
+    double getReplaySpeed(void) { return replaySpeed; }
+
     /**
      * @brief Is method used by higher classes to find out, what upper limit for maximum tolerable error count for reciever is used.
      * @return Returns the maximum tolerable error count value.
@@ -457,28 +521,52 @@ public:
     void setDiskBackupEnabled(bool enabled) { diskBackupEnabled = enabled; }
 
     /**
-     * @brief Returns the file object that was opened for the backup sequence.
-     * @return Pointer to the opened file object.
+     * @brief Returns true if backup frames are compressed (see backupcodec.h).
+     * @return Boolean value representing the backup compression enabled/disabled status.
      */
-    QFile * getBackupMainFileHandler(void) { return backupMainFileHandler; }
+    bool getDiskBackupCompressed(void) { return diskBackupCompressed; }
 
     /**
-     * @brief Sets the new file handler. This file handler/object must be opened in text mode and has the write in privileges.
-     * @param[in] New 'QFile handler' opened in text mode and set up for writing.
+     * @brief Enables or disables compression of backup frames. Applied when the next backup file is created.
+     * @param[in] compressed Boolean status. If true, frames are compressed.
      */
-    void setBackupMainFileHandler(QFile * file) { backupMainFileHandler = file; }
+    void setDiskBackupCompressed(bool compressed) { diskBackupCompressed = compressed; }
 
     /**
-     * @brief Returns the pointer to the 'QTextStream' object currently used for data writing.
-     * @return The return value QTextStream pointer.
+     * @brief Returns resolution of coordinates in compressed backup (see backupcodec.h).
+     * @return Resolution in micrometers, zero if coordinates are stored losslessly.
      */
-    QTextStream * getBackupFileHandler(void) { return backupFileHandler; }
+    unsigned int getDiskBackupQuantum(void) { return diskBackupQuantum; }
 
     /**
-     * @brief Sets the new stream object pointer for data backup use.
-     * @param[in] handler Is the pointer to the newly created stream used for data backup.
+     * @brief Sets resolution of coordinates in compressed backup. Applied when the next backup file is created.
+     * @param[in] quantum Resolution in micrometers. If zero, coordinates are stored losslessly.
      */
-    void setBackupFileHandler(QTextStream * handler) { backupFileHandler = handler; }
+    void setDiskBackupQuantum(unsigned int quantum) { diskBackupQuantum = quantum; }
+
+    /**
+     * @brief Returns true if all recieved measurements are captured into file (see measurementcapture.h).
+     * @return Boolean value representing the capture enabled/disabled status.
+     */
+    bool getMeasurementCaptureEnabled(void) { return measurementCaptureEnabled; }
+
+    /**
+     * @brief Enables or disables capture of recieved measurements. Applied when data recieving is started next time.
+     * @param[in] enabled Boolean status. If true, measurements are captured into file next to disk backup.
+     */
+    void setMeasurementCaptureEnabled(bool enabled) { measurementCaptureEnabled = enabled; }
+
+    /**
+     * @brief Returns the writer of running backup sequence. Records may be pushed into it only while settings mutex is locked, so it cannot be stopped meanwhile.
+     * @return Pointer to the writer or NULL if backup is not running.
+     */
+    backupWriter * getBackupWriter(void) { return backupWriterHandler; }
+
+    /**
+     * @brief Sets the writer used for data backup.
+     * @param[in] writer Writer with opened file and running thread, NULL when backup is stopped.
+     */
+    void setBackupWriter(backupWriter * writer) { backupWriterHandler = writer; }
 
     /** THE FOLLOWING FUNCTIONS ARE ABLE TO RETRIEVE BASIC OPENGL SETTINGS **/
 
@@ -540,6 +628,174 @@ public:
      */
     bool getGlobalRadarMTT(void) { return enableGlobalRadarMTT; }
 
+    /**
+     * @brief Sets the maximum number of targets handled by packet decoder, MTT algorithms and fusion. Value is limited to the range 1 to MAX_TARGET_CAPACITY. Radar units (their MTT and history) take the new value with the next recieved data, reciever and packet decoder buffers only when the data input is restarted.
+     * @param[in] capacity New number of targets.
+     */
+    void setTargetCapacity(int capacity) { targetCapacity = (capacity<1) ? 1 : ((capacity>MAX_TARGET_CAPACITY) ? MAX_TARGET_CAPACITY : capacity); }
+
+    /**
+     * @brief Retrieves the maximum number of targets handled by packet decoder, MTT algorithms and fusion.
+     * @return Number of targets. Default value is MAX_N.
+     */
+    int getTargetCapacity(void) { return targetCapacity; }
+
+    /**
+     * @brief Sets the merge radius of spatial fusion. Positions of different radars closer than radius are fused into one target, fused positions are displayed directly or tracked by global MTT. Non-positive values are ignored.
+     * @param[in] radius New merge radius in meters.
+     */
+    void setFusionMergeRadius(float radius) { if(radius>0) fusionMergeRadius = radius; }
+
+    /**
+     * @brief Retrieves the merge radius of spatial fusion (used with and without global MTT).
+     * @return Merge radius in meters. Default value is SPATIAL_FUSION_RADIUS.
+     */
+    float getFusionMergeRadius(void) { return fusionMergeRadius; }
+
+    /**
+     * @brief Selects how positions of different radars belonging to one target are combined into fused position (displayed directly or tracked by global MTT).
+     * @param[in] estimator Mean, median or trimmed mean of positions.
+     */
+    void setFusionEstimator(fusion_estimator estimator) { fusionEstimator = estimator; }
+
+    /**
+     * @brief Retrieves how positions of different radars belonging to one target are combined.
+     * @return Estimator of fused position. Default is FUSION_MEAN.
+     */
+    fusion_estimator getFusionEstimator(void) { return fusionEstimator; }
+
+    /**
+     * @brief Sets the fraction of positions dropped on each side by trimmed mean fusion. Value is limited to the range 0 to 0.5.
+     * @param[in] trim New fraction.
+     */
+    void setFusionTrimFraction(float trim) { fusionTrimFraction = (trim<0) ? 0 : ((trim>0.5f) ? 0.5f : trim); }
+
+    /**
+     * @brief Retrieves the fraction of positions dropped on each side by trimmed mean fusion.
+     * @return Fraction of positions. Default value is SPATIAL_FUSION_TRIM.
+     */
+    float getFusionTrimFraction(void) { return fusionTrimFraction; }
+
+    /**
+     * @brief Sets the fusion deadline. Fusion runs when this time passed since the first new data of frame, even if some radars did not send their data yet.
+     * @param[in] deadline Deadline in miliseconds.
+     */
+    void setFusionDeadline(unsigned int deadline) { fusionDeadline = deadline; }
+
+    /**
+     * @brief Retrieves the fusion deadline.
+     * @return Deadline in miliseconds. Default value is 100.
+     */
+    unsigned int getFusionDeadline(void) { return fusionDeadline; }
+
+    /**
+     * @brief Sets the fusion quorum. Fusion runs immediately when this number of radars sent new data. Value 0 means that all active radars are waited for.
+     * @param[in] quorum Number of radars.
+     */
+    void setFusionQuorum(unsigned int quorum) { fusionQuorum = quorum; }
+
+    /**
+     * @brief Retrieves the fusion quorum.
+     * @return Number of radars, 0 if all active radars are required. Default value is 0.
+     */
+    unsigned int getFusionQuorum(void) { return fusionQuorum; }
+
+    /**
+     * @brief Sets the stale time. Radar which did not send data for longer time is excluded from fusion until it sends data again.
+     * @param[in] stale_time Stale time in miliseconds.
+     */
+    void setFusionStaleTime(unsigned int stale_time) { fusionStaleTime = stale_time; }
+
+    /**
+     * @brief Retrieves the stale time.
+     * @return Stale time in miliseconds. Default value is 1000.
+     */
+    unsigned int getFusionStaleTime(void) { return fusionStaleTime; }
+
+    /**
+     * @brief Enables/disables time alignment. If enabled, tracked positions of all radars are predicted to the time of the newest measurement before fusion.
+     * @param[in] enable New state.
+     */
+    void setFusionTimeAlignment(bool enable) { fusionTimeAlignment = enable; }
+
+    /**
+     * @brief Retrieves time alignment state.
+     * @return True if positions are predicted to common time before fusion. Default is true.
+     */
+    bool getFusionTimeAlignment(void) { return fusionTimeAlignment; }
+
+    /**
+     * @brief Sets the number of frames each radar unit keeps in its history.
+     * @param[in] depth Number of frames (1 up to RADAR_HISTORY_MAX_DEPTH).
+     */
+    void setRadarHistoryDepth(int depth) { radarHistoryDepth = (depth<1) ? 1 : ((depth>RADAR_HISTORY_MAX_DEPTH) ? RADAR_HISTORY_MAX_DEPTH : depth); }
+
+    /**
+     * @brief Retrieves the number of frames each radar unit keeps in its history.
+     * @return Number of frames. Default value is RADAR_HISTORY_DEPTH.
+     */
+    int getRadarHistoryDepth(void) { return radarHistoryDepth; }
+
+    /**
+     * @brief Selects the state model of MTT applied on single radar units.
+     * @param[in] model New state model.
+     */
+    void setSingleRadarMTTModel(mtt_state_model model) { singleRadarMTTModel = model; }
+
+    /**
+     * @brief Retrieves the state model of MTT applied on single radar units.
+     * @return State model. Default is MTT_POLAR_STATE.
+     */
+    mtt_state_model getSingleRadarMTTModel(void) { return singleRadarMTTModel; }
+
+    /**
+     * @brief Selects the state model of global MTT.
+     * @param[in] model New state model.
+     */
+    void setGlobalRadarMTTModel(mtt_state_model model) { globalRadarMTTModel = model; }
+
+    /**
+     * @brief Retrieves the state model of global MTT.
+     * @return State model. Default is MTT_POLAR_STATE.
+     */
+    mtt_state_model getGlobalRadarMTTModel(void) { return globalRadarMTTModel; }
+
+    /**
+     * @brief Enables/disables MTT warm start. If enabled, states of all MTT objects are saved when data input is stopped and restored when it is started again.
+     * @param[in] enable New warm start state.
+     */
+    void setMTTWarmStart(bool enable) { mttWarmStart = enable; }
+
+    /**
+     * @brief Retrieves MTT warm start state.
+     * @return If true, MTT states are kept between data input stop and start. Otherwise all MTTs are reset on start.
+     */
+    bool getMTTWarmStart(void) { return mttWarmStart; }
+
+    /**
+     * @brief Enables/disables saving of MTT states to disk when application is closed. Saved states are loaded when data input is started for the first time and warm start is enabled.
+     * @param[in] enable New state.
+     */
+    void setMTTStatePersistent(bool enable) { mttStatePersistent = enable; }
+
+    /**
+     * @brief Retrieves the information if MTT states are saved to disk.
+     * @return True if MTT states are saved on exit.
+     */
+    bool getMTTStatePersistent(void) { return mttStatePersistent; }
+
+    /**
+     * @brief Sets the file where MTT states are saved.
+     * @param[in] path Path to the file.
+     */
+    void setMTTStateFilePath(QString path) { mttStateFilePath = path; }
+
+    /**
+     * @brief Retrieves the file where MTT states are saved.
+     * @return Path to the file. Default file is 'mtt_state.bin' in the current directory.
+     */
+    QString getMTTStateFilePath(void) { return mttStateFilePath; }
+
 private:
 
     reciever_method recieverMethod; ///< Method used for obtaining data from UWB network
@@ -554,6 +810,13 @@ private:
     int comPortBaudRate; ///< Holds the information about speed used for serial link commuication
     char comPortMode[4]; ///< Used for serial link communication initialization with some options. See this site for more information: http://www.teuniz.net/RS-232/
 
+    raw_ir_source rawIRSourceType; ///< Specifies if raw impulse responses are read from file or socket
+    QString rawIRSource; ///< File path or "host:port" of raw impulse responses source
+    ir_detection_parameters irDetectionParameters; ///< Parameters of detection chain for raw impulse responses
+
+    QString replayFile; ///< File fed by REPLAY method
+    double replaySpeed; ///< Multiple of recorded speed for REPLAY method, zero for unthrottled replay
+
     unsigned int visualizationInterval; ///< Sets how often should be the scene updated.
     visualization_schema visualizationSchema; ///< Holds the user choice of visual effects in scene.
 
@@ -607,11 +870,27 @@ private:
     QDir diskBackupFilePath; ///< When saving data to disk is enabled, here the path to the file is stored.
     QString backupFileName; ///< Backup file name used.
     bool diskBackupEnabled; ///< Specifies if save to disk or not.
-    QFile * backupMainFileHandler; ///< FILE object of opened backup file.
-    QTextStream * backupFileHandler; ///< Stores the 'handler' where can new data be written and redirected to file.
+    bool diskBackupCompressed; ///< Specifies if backup frames are compressed.
+    unsigned int diskBackupQuantum; ///< Resolution of coordinates in compressed backup in micrometers, zero for lossless.
+    bool measurementCaptureEnabled; ///< Specifies if recieved measurements are captured.
+    backupWriter * backupWriterHandler; ///< Writer of binary backup file running in its own thread, NULL if backup is not running.
 
     bool enableSingleRadarMTT; ///< Switches on/off single radar MTT. If turned on, every radar will apply MTT on newly recieved data.
     bool enableGlobalRadarMTT; ///< Switches on/off global MTT algorithm. If turned on, averaging data will be replaced with MTT algorithm.
+    int targetCapacity; ///< Maximum number of targets for one radar unit as well as for global MTT.
+    float fusionMergeRadius; ///< Positions of different radars closer than this radius are fused into one target (fused positions also feed global MTT).
+    fusion_estimator fusionEstimator; ///< Combination of positions belonging to one target (mean, median, trimmed mean).
+    float fusionTrimFraction; ///< Fraction of positions dropped on each side by trimmed mean fusion.
+    unsigned int fusionDeadline; ///< Maximum time in miliseconds fusion waits for radars since the first new data of frame.
+    unsigned int fusionQuorum; ///< Number of radars with new data fusion runs immediately for, 0 means all active radars.
+    unsigned int fusionStaleTime; ///< Radars without data for this time (miliseconds) are excluded from fusion.
+    bool fusionTimeAlignment; ///< If true, tracked positions are predicted to common time before fusion.
+    int radarHistoryDepth; ///< Number of frames kept by each radar unit.
+    mtt_state_model singleRadarMTTModel; ///< State model of Kalman filters used by MTT of single radar units.
+    mtt_state_model globalRadarMTTModel; ///< State model of Kalman filters used by global MTT.
+    bool mttWarmStart; ///< If true, MTT states are saved on data input stop and restored on start instead of resetting all MTTs.
+    bool mttStatePersistent; ///< If true, MTT states are saved to disk when application closes.
+    QString mttStateFilePath; ///< File used for MTT states persistence.
 };
 
 #endif // UWBSETTINGS_H
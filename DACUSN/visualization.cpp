@@ -39,26 +39,26 @@ void MainWindow::visualizationSlot()
             vis_schema = settings->getVisualizationSchema();
         settingsMutex->unlock();
 
+        // the latest complete frame is taken once, all parts of this iteration render the same frame
+        // even if fusion publishes new one meanwhile
+        const visualization_frame * frame = visualizationManager->latestFrame();
+
         // if recording history is required, we need to save cross items first but if PATH_HISTORY is set as well we do not record it here, because
         // launchPath() method will create its own objects itself and saves them into list. Therefore "background" recording is not needed.
         if(history_enabled && vis_schema!=PATH_HISTORY)
         {
-            visualizationDataMutex->lock();
-
                 float meter_to_pixel_ratio = METER_TO_PIXEL_RATIO;
-                for(int j = 0; j<visualizationData->count(); j++)
+                for(int j = 0; j<frame->count; j++)
                 {
-                    float x = visualizationData->at(j)->x()*meter_to_pixel_ratio;
-                    float y = visualizationData->at(j)->y()*meter_to_pixel_ratio;
+                    float x = frame->positions[j*2]*meter_to_pixel_ratio;
+                    float y = frame->positions[j*2+1]*meter_to_pixel_ratio;
 
                     // register new point/object
-                    crossItem * item = new crossItem(x, y, visualizationColor->at(j), visualizationScene);
+                    crossItem * item = new crossItem(x, y, visualizationManager->targetColor(frame->ids[j]), visualizationScene);
 
                     // record new position
                     visualizationManager->appendPathItem(item);
                 }
-
-            visualizationDataMutex->unlock();
         }
 
         // If visualization is turned off, we must return before the rendering sequence starts. This is good for situations
@@ -80,11 +80,17 @@ void MainWindow::visualizationSlot()
             //settingsMutex->unlock();
 
 
-            visualizationManager->launchCommonFlow();
+            visualizationManager->launchCommonFlow(frame);
             radarSubWindowListMutex->lock();
             if(!radarSubWindowList->isEmpty())
             {
-                for(int i = 0; i<radarSubWindowList->count(); i++) radarSubWindowList->at(i)->getVisualizationManager()->launchCommonFlow();
+                // each subwindow takes the newest snapshot of its radar unit now, stack manager does not push data into them
+                for(int i = 0; i<radarSubWindowList->count(); i++)
+                {
+                    radarSubWindowList->at(i)->updateVisualizationData();
+                    animationManager * subWindowManager = radarSubWindowList->at(i)->getVisualizationManager();
+                    subWindowManager->launchCommonFlow(subWindowManager->latestFrame());
+                }
             }
             radarSubWindowListMutex->unlock();
         }
@@ -109,11 +115,16 @@ void MainWindow::visualizationSlot()
             /* -------- MUT. UNLOCK -------- */
             //settingsMutex->unlock();
 
-            visualizationManager->launchCometItems();
+            visualizationManager->launchCometItems(frame);
             radarSubWindowListMutex->lock();
             if(!radarSubWindowList->isEmpty())
             {
-                for(int i = 0; i<radarSubWindowList->count(); i++) radarSubWindowList->at(i)->getVisualizationManager()->launchCometItems();
+                for(int i = 0; i<radarSubWindowList->count(); i++)
+                {
+                    radarSubWindowList->at(i)->updateVisualizationData();
+                    animationManager * subWindowManager = radarSubWindowList->at(i)->getVisualizationManager();
+                    subWindowManager->launchCometItems(subWindowManager->latestFrame());
+                }
             }
             radarSubWindowListMutex->unlock();
 
@@ -135,7 +146,7 @@ void MainWindow::visualizationSlot()
             /* -------- MUT. UNLOCK -------- */
             //settingsMutex->unlock();
 
-            visualizationManager->launchPathDrawing();
+            visualizationManager->launchPathDrawing(frame);
         }
         else
         {
@@ -156,7 +167,7 @@ void MainWindow::visualizationSlot()
 
 }
 
-animationManager::animationManager(QGraphicsScene * visualization_Scene, QGraphicsView * visualization_View, QList<QPointF * > * visualization_Data, QList<QColor * > * visualization_Color, QMutex * visualization_Data_Mutex, uwbSettings * setts, QMutex * settings_mutex)
+animationManager::animationManager(QGraphicsScene * visualization_Scene, QGraphicsView * visualization_View, frameBuffer * visualization_Data, QList<QColor * > * visualization_Color, uwbSettings * setts, QMutex * settings_mutex)
 {
     visualizationScene = visualization_Scene;
     visualizationView = visualization_View;
@@ -171,7 +182,6 @@ animationManager::animationManager(QGraphicsScene * visualization_Scene, QGraphi
 
     visualizationData = visualization_Data;
     visualizationColor = visualization_Color;
-    visualizationDataMutex = visualization_Data_Mutex;
 
     meter_to_pixel_ratio = METER_TO_PIXEL_RATIO;
     x_pixel = y_pixel = 0;
@@ -673,22 +683,20 @@ void radarScene::drawBackground(QPainter *painter, const QRectF &rect)
 /*************************************************************************************************************/
 
 
-void animationManager::launchCometItems()
+void animationManager::launchCometItems(const visualization_frame *frame)
 {
     cometItem * item;
     int i;
 
     QList<QSequentialAnimationGroup * > animationGroupList;
 
-    visualizationDataMutex->lock();
-
     // prepare animations
-    for(i=0; i<visualizationData->count(); i++)
+    for(i=0; i<frame->count; i++)
     {
-        x_pixel = meter_to_pixel_ratio*visualizationData->at(i)->x();
-        y_pixel = meter_to_pixel_ratio*visualizationData->at(i)->y();
+        x_pixel = meter_to_pixel_ratio*frame->positions[i*2];
+        y_pixel = meter_to_pixel_ratio*frame->positions[i*2+1];
 
-        item = new cometItem(QPointF(x_pixel, y_pixel), 0.0, *visualizationColor->at(i));
+        item = new cometItem(QPointF(x_pixel, y_pixel), 0.0, *targetColor(frame->ids[i]));
 
 
         QSequentialAnimationGroup * animationGroup = new QSequentialAnimationGroup(item);
@@ -714,9 +722,6 @@ void animationManager::launchCometItems()
         animationGroupList.append(animationGroup);
     }
 
-
-    visualizationDataMutex->unlock();
-
     // now start all animations
 
     for(i=0; i<animationGroupList.count(); i++) animationGroupList.at(i)->start(QAbstractAnimation::DeleteWhenStopped);
@@ -725,27 +730,25 @@ void animationManager::launchCometItems()
     visualizationScene->update();
 }
 
-void animationManager::launchCommonFlow()
+void animationManager::launchCommonFlow(const visualization_frame *frame)
 {
     int i;
 
-    visualizationDataMutex->lock();
-
     // if there are more targets to display then we have item in the scene
-    while(ellipseList->count()<visualizationData->count())
+    while(ellipseList->count()<frame->count)
     {
         ellipseList->append(new QGraphicsEllipseItem(0.0, 0.0, x_width, y_width));
         ellipseList->last()->setVisible(false);
         visualizationScene->addItem(ellipseList->last());
     }
 
-    for(i=0; i<visualizationData->count(); i++)
+    for(i=0; i<frame->count; i++)
     {
-        x_pixel = meter_to_pixel_ratio*visualizationData->at(i)->x();
-        y_pixel = meter_to_pixel_ratio*visualizationData->at(i)->y();
+        x_pixel = meter_to_pixel_ratio*frame->positions[i*2];
+        y_pixel = meter_to_pixel_ratio*frame->positions[i*2+1];
 
         ellipseList->at(i)->setPos(x_pixel, y_pixel);
-        ellipseList->at(i)->setBrush(QBrush(*visualizationColor->at(i)));
+        ellipseList->at(i)->setBrush(QBrush(*targetColor(frame->ids[i])));
 
         if(!ellipseList->at(i)->isVisible())
         {
@@ -756,12 +759,10 @@ void animationManager::launchCommonFlow()
 
     // if unused items, hide them
 
-    for(i=visualizationData->count(); i<ellipseList->count(); i++)
+    for(i=frame->count; i<ellipseList->count(); i++)
     {
         if(ellipseList->at(i)->isVisible()) ellipseList->at(i)->setVisible(false);
     }
-
-    visualizationDataMutex->unlock();
 }
 
 void animationManager::hideAllCommonFlowSchemaObjects(bool delete_items)
@@ -784,7 +785,8 @@ void animationManager::revealAllCommonFlowSchemaObjects()
     // NOTE THIS FUNCTION HAS BEEN MODIFIED!!! SINCE PATH PAINTING MODE WILL ALSO DELETE OBJECTS FROM SCENE THIS FUNCTION MUST ADD THEM BACK AGAIN
     // YOU CAN ALSO USE SET VISIBLE TO TRUE, BUT LAUNCHING FUNCTION WILL DO THAT AS WELL SO PRACTICALLY THIS STEP HAS NO POINT.
 
-    launchCommonFlow();
+    // items are revealed at positions rendered last time, newer frame is left for the next rendering iteration
+    launchCommonFlow(visualizationData->current());
 
     //for(int i = 0; i<ellipseList->count(); i++)
     //{
@@ -794,18 +796,16 @@ void animationManager::revealAllCommonFlowSchemaObjects()
     ellipseListInvisible = false;
 }
 
-void animationManager::launchPathDrawing()
+void animationManager::launchPathDrawing(const visualization_frame *frame)
 {
-    visualizationDataMutex->lock();
-
         float meter_to_pixel_ratio = METER_TO_PIXEL_RATIO;
-        for(int j = 0; j<visualizationData->count(); j++)
+        for(int j = 0; j<frame->count; j++)
         {
-            float x = visualizationData->at(j)->x()*meter_to_pixel_ratio;
-            float y = visualizationData->at(j)->y()*meter_to_pixel_ratio;
+            float x = frame->positions[j*2]*meter_to_pixel_ratio;
+            float y = frame->positions[j*2+1]*meter_to_pixel_ratio;
 
             // register new point/object
-            crossItem * item = new crossItem(x, y, visualizationColor->at(j), visualizationScene);
+            crossItem * item = new crossItem(x, y, targetColor(frame->ids[j]), visualizationScene);
 
             visualizationScene->addItem(item);
             // record new position
@@ -819,8 +819,6 @@ void animationManager::launchPathDrawing()
 
             visualizationView->viewport()->update(QRect(itemRectViewTopLeft, itemRectViewBottomRight));
         }
-
-        visualizationDataMutex->unlock();
 }
 
 void animationManager::updateRadarMarkerList(QVector<radar_handler *> *radarList, QMutex *radarListMutex, int id)
@@ -39,6 +39,7 @@
 
 #include "uwbsettings.h"
 #include "radar_handler.h"
+#include "framebuffer.h"
 
 /******************************************* CUSTOM GRAPHICS ITEMS *******************************************/
 
@@ -185,23 +186,43 @@ public:
 
     /**
      * @brief Constructs the animationManager object.
-     * @param[in] visualizationData The final positions of targets
-     * @param[in] visualizationColor The colors assigned to all targets
-     * @param[in] visualizationDataMutex Mutex protecting visualization data from being accessed by multiple threads at the same time
+     * @param[in] visualizationData Buffer the latest frame with final positions of targets is read from. Manager must be the only reader of buffer.
+     * @param[in] visualizationColor The colors assigned to targets by their identifiers. List must not be changed while manager exists.
      * @param[in] setts Pointer to the basic application settings object.
      * @param[in] settings_mutex Pointer to the mutex locking the settings object.
      */
-    animationManager(QGraphicsScene * visualization_Scene, QGraphicsView * visualization_View, QList<QPointF * > * visualization_Data, QList<QColor * > * visualization_Color, QMutex * visualization_Data_Mutex, uwbSettings * setts, QMutex * settings_mutex);
+    animationManager(QGraphicsScene * visualization_Scene, QGraphicsView * visualization_View, frameBuffer * visualization_Data, QList<QColor * > * visualization_Color, uwbSettings * setts, QMutex * settings_mutex);
+
+    /**
+     * @brief Returns the latest frame published into visualization buffer. Should be called once per rendering iteration.
+     * @return Frame which stays unchanged until the next call.
+     */
+    const visualization_frame * latestFrame(void) { return visualizationData->latest(); }
+
+    /**
+     * @brief Returns the frame taken by the last call of 'latestFrame', newer frames are not taken.
+     * @return Frame which was rendered last time.
+     */
+    const visualization_frame * renderedFrame(void) { return visualizationData->current(); }
+
+    /**
+     * @brief Returns color of target.
+     * @param[in] id Identifier of target from frame.
+     * @return Pointer to color from color list, colors are repeated if there are more targets than colors.
+     */
+    QColor * targetColor(int id) { return visualizationColor->at(((id<0) ? -id : id) % visualizationColor->count()); }
 
     /**
      * @brief Creates and sets the animation controls to make the comet effect.
+     * @param[in] frame Frame to be rendered, obtained by 'latestFrame'.
      */
-    void launchCometItems(void);
+    void launchCometItems(const visualization_frame * frame);
 
     /**
      * @brief Starts the most common visualization sequence where only one circle represents the targets in front of operator.
+     * @param[in] frame Frame to be rendered, obtained by 'latestFrame'.
      */
-    void launchCommonFlow(void);
+    void launchCommonFlow(const visualization_frame * frame);
 
     /**
      * @brief This function will set the new meter_to_pixel_ratio for child methods when displaying targets.
@@ -234,8 +255,9 @@ public:
 
     /**
      * @brief If user selects drawing history paths of movements, this function is called to update polygons and draws them.
+     * @param[in] frame Frame to be rendered, obtained by 'latestFrame'.
      */
-    void launchPathDrawing(void);
+    void launchPathDrawing(const visualization_frame * frame);
 
     /**
      * @brief This function will register new 'crossItem' in path handler.
@@ -285,9 +307,8 @@ private:
     QMutex * settingsMutex; ///< Pointer to the mutex locking the settings object.
 
     QList<radarMarker * > * radarMarkerList; ///< Holds all objects visualizating radar unit's positions and orientation
-    QList<QPointF * > * visualizationData; ///< The final positions of targets
+    frameBuffer * visualizationData; ///< Buffer with the final positions of targets, read without locking
     QList<QColor * > * visualizationColor; ///< The colors assigned to all targets
-    QMutex * visualizationDataMutex; ///< Mutex protecting visualization data from being accessed by multiple threads at the same time
 
     QGraphicsScene * visualizationScene; ///< Is the scene where all items/objects are rendered on.
     QGraphicsView * visualizationView; ///< Pointer to the graphics view used for rendering.